@@ -0,0 +1,25 @@
+# - Try to find liburing
+# Once done this will define
+#  LibURing_FOUND - System has liburing
+#  LibURing_INCLUDE_DIRS - The liburing include directories
+#  LibURing_LIBRARIES - The libraries needed to use liburing
+
+FIND_LIBRARY(LibURing_LIBRARIES
+    NAMES uring
+)
+
+FIND_PATH(LibURing_INCLUDE_DIRS
+    NAMES liburing.h
+)
+
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LibURing DEFAULT_MSG
+    LibURing_LIBRARIES
+    LibURing_INCLUDE_DIRS
+)
+
+# Hide these vars from ccmake GUI
+MARK_AS_ADVANCED(
+	LibURing_LIBRARIES
+	LibURing_INCLUDE_DIRS
+)
@@ -0,0 +1,177 @@
+/* Implements a map from relative paths of list items to their index
+ * and comparison state.
+ *
+ * A strmap stores copies of key and value strings in a tree node for
+ * each item, and each state change rewrites the value string.  For
+ * lists with hundreds of millions of items that dominates both memory
+ * and time of a comparison.  Here the keys are the names already held
+ * by the list, states are packed into one integer per item, and items
+ * are found with an open addressing hash table with linear probing.
+ * Each slot holds the item index plus one in its low 40 bits, so that
+ * 0 marks an empty slot, and the top 24 bits of the key hash in its
+ * high bits, so that most probes of other keys are rejected without
+ * touching their names. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mfu.h"
+#include "mfu_cmpmap.h"
+
+#define SLOT_INDEX_BITS (40)
+#define SLOT_INDEX_MASK (((uint64_t)1 << SLOT_INDEX_BITS) - 1)
+
+/* hash key into a 64-bit value with 64-bit FNV-1a, followed by the
+ * MurmurHash3 finalizer so that both the low bits used for the slot
+ * number and the high bits used for the tag are well mixed */
+static uint64_t cmpmap_hash(const char* key)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const unsigned char* ptr = (const unsigned char*) key;
+    while (*ptr != '\0') {
+        hash ^= (uint64_t) *ptr;
+        hash *= 0x100000001b3ULL;
+        ptr++;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/* return tag of hash that is stored in the high bits of a slot */
+static uint64_t cmpmap_tag(uint64_t hash)
+{
+    return (hash >> SLOT_INDEX_BITS) << SLOT_INDEX_BITS;
+}
+
+const char* mfu_cmpmap_key(const mfu_cmpmap* map, uint64_t idx)
+{
+    const char* name = mfu_flist_file_get_name(map->list, idx);
+    return name + map->prefix_len;
+}
+
+mfu_cmpmap* mfu_cmpmap_new(mfu_flist list, size_t prefix_len)
+{
+    mfu_cmpmap* map = (mfu_cmpmap*) MFU_MALLOC(sizeof(mfu_cmpmap));
+    map->list       = list;
+    map->prefix_len = prefix_len;
+    map->count      = mfu_flist_size(list);
+
+    if (map->count > SLOT_INDEX_MASK - 1) {
+        MFU_ABORT(-1, "Too many items for comparison map: %llu",
+            (unsigned long long) map->count);
+    }
+
+    /* all fields start in state 0 */
+    map->states = (uint64_t*) MFU_MALLOC(map->count * sizeof(uint64_t));
+    if (map->count > 0) {
+        memset(map->states, 0, map->count * sizeof(uint64_t));
+    }
+
+    /* use a power of two number of slots, at most half full */
+    uint64_t nslots = 16;
+    while (nslots < map->count * 2) {
+        nslots *= 2;
+    }
+    map->mask  = nslots - 1;
+    map->slots = (uint64_t*) MFU_MALLOC(nslots * sizeof(uint64_t));
+    memset(map->slots, 0, nslots * sizeof(uint64_t));
+
+    /* insert each item, a later item with the same key replaces
+     * an earlier one */
+    uint64_t idx;
+    for (idx = 0; idx < map->count; idx++) {
+        const char* key = mfu_cmpmap_key(map, idx);
+        uint64_t hash = cmpmap_hash(key);
+        uint64_t tag  = cmpmap_tag(hash);
+        uint64_t pos  = hash & map->mask;
+        while (map->slots[pos] != 0) {
+            uint64_t slot = map->slots[pos];
+            if ((slot & ~SLOT_INDEX_MASK) == tag) {
+                uint64_t other = (slot & SLOT_INDEX_MASK) - 1;
+                if (strcmp(mfu_cmpmap_key(map, other), key) == 0) {
+                    break;
+                }
+            }
+            pos = (pos + 1) & map->mask;
+        }
+        map->slots[pos] = tag | (idx + 1);
+    }
+
+    return map;
+}
+
+void mfu_cmpmap_delete(mfu_cmpmap** pmap)
+{
+    if (pmap != NULL && *pmap != NULL) {
+        mfu_cmpmap* map = *pmap;
+        mfu_free(&map->slots);
+        mfu_free(&map->states);
+        mfu_free(pmap);
+    }
+}
+
+int mfu_cmpmap_lookup(const mfu_cmpmap* map, const char* key, uint64_t* idx)
+{
+    uint64_t hash = cmpmap_hash(key);
+    uint64_t tag  = cmpmap_tag(hash);
+    uint64_t pos  = hash & map->mask;
+    while (map->slots[pos] != 0) {
+        uint64_t slot = map->slots[pos];
+        if ((slot & ~SLOT_INDEX_MASK) == tag) {
+            uint64_t other = (slot & SLOT_INDEX_MASK) - 1;
+            if (strcmp(mfu_cmpmap_key(map, other), key) == 0) {
+                *idx = other;
+                return 0;
+            }
+        }
+        pos = (pos + 1) & map->mask;
+    }
+    return -1;
+}
+
+/* key and index of an item while sorting */
+typedef struct {
+    const char* key;
+    uint64_t idx;
+} cmpmap_sort_t;
+
+static int cmpmap_sort_cmp(const void* a, const void* b)
+{
+    const cmpmap_sort_t* x = (const cmpmap_sort_t*) a;
+    const cmpmap_sort_t* y = (const cmpmap_sort_t*) b;
+    return strcmp(x->key, y->key);
+}
+
+uint64_t* mfu_cmpmap_sorted(const mfu_cmpmap* map, uint64_t* count)
+{
+    /* gather items the map resolves its keys to, which skips
+     * earlier items of the list that have the same key */
+    cmpmap_sort_t* items = (cmpmap_sort_t*) MFU_MALLOC(map->count * sizeof(cmpmap_sort_t));
+    uint64_t n = 0;
+    uint64_t idx;
+    for (idx = 0; idx < map->count; idx++) {
+        const char* key = mfu_cmpmap_key(map, idx);
+        uint64_t found;
+        if (mfu_cmpmap_lookup(map, key, &found) == 0 && found == idx) {
+            items[n].key = key;
+            items[n].idx = idx;
+            n++;
+        }
+    }
+
+    qsort(items, (size_t)n, sizeof(cmpmap_sort_t), cmpmap_sort_cmp);
+
+    uint64_t* sorted = (uint64_t*) MFU_MALLOC(n * sizeof(uint64_t));
+    for (idx = 0; idx < n; idx++) {
+        sorted[idx] = items[idx].idx;
+    }
+    mfu_free(&items);
+
+    *count = n;
+    return sorted;
+}
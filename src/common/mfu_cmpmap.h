@@ -0,0 +1,81 @@
+#ifndef MFU_CMPMAP_H
+#define MFU_CMPMAP_H
+
+/* Maps the path of each item in a file list, relative to a prefix
+ * directory, to the index of the item and a comparison state for each
+ * of up to MFU_CMPMAP_FIELDS fields.  Used by tools that compare two
+ * lists item by item, like dcmp and dsync.
+ *
+ * Keys point into the names held by the list, so the list must not be
+ * freed before the map.  States are small integers packed 4 bits per
+ * field, all states start at 0. */
+
+#include <stdint.h>
+#include "mfu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* max number of fields with a state for each item */
+#define MFU_CMPMAP_FIELDS (16)
+
+/* max value of a state */
+#define MFU_CMPMAP_STATE_MAX (15)
+
+typedef struct mfu_cmpmap_struct {
+    mfu_flist list;     /* list holding items of map */
+    size_t prefix_len;  /* number of characters to skip in item names */
+    uint64_t count;     /* number of items in map */
+    uint64_t* states;   /* packed states of each item, indexed by item */
+    uint64_t* slots;    /* hash table of items, see mfu_cmpmap.c */
+    uint64_t mask;      /* number of slots minus one */
+} mfu_cmpmap;
+
+/* create a map of all items in list, skipping the first prefix_len
+ * characters of each name */
+mfu_cmpmap* mfu_cmpmap_new(mfu_flist list, size_t prefix_len);
+
+/* free map */
+void mfu_cmpmap_delete(mfu_cmpmap** pmap);
+
+/* return number of items in map */
+static inline uint64_t mfu_cmpmap_size(const mfu_cmpmap* map)
+{
+    return map->count;
+}
+
+/* return key of the item at index idx of the list */
+const char* mfu_cmpmap_key(const mfu_cmpmap* map, uint64_t idx);
+
+/* look up key, sets idx to the index of its item and returns 0
+ * if found, returns -1 otherwise */
+int mfu_cmpmap_lookup(const mfu_cmpmap* map, const char* key, uint64_t* idx);
+
+/* return state of field of item idx */
+static inline int mfu_cmpmap_get_state(const mfu_cmpmap* map, uint64_t idx, int field)
+{
+    return (int)((map->states[idx] >> (4 * field)) & 0xf);
+}
+
+/* set state of field of item idx */
+static inline void mfu_cmpmap_set_state(mfu_cmpmap* map, uint64_t idx, int field, int state)
+{
+    uint64_t shift = 4 * (uint64_t)field;
+    map->states[idx] &= ~((uint64_t)0xf << shift);
+    map->states[idx] |= ((uint64_t)state & 0xf) << shift;
+}
+
+/* return an array of the index of each item of map ordered by key,
+ * with one item for each key, and set count to its length,
+ * the caller frees the array with mfu_free */
+uint64_t* mfu_cmpmap_sorted(const mfu_cmpmap* map, uint64_t* count);
+
+/* iterate over index of each item of map in list order */
+#define mfu_cmpmap_foreach(map, idx) \
+    for ((idx) = 0; (idx) < mfu_cmpmap_size(map); (idx)++)
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* MFU_CMPMAP_H */
@@ -67,6 +67,24 @@ mfu_walk_opts_t* mfu_walk_opts_new(void)
     /* Don't dereference symbolic links by default */
     opts->dereference = 0;
 
+    /* Collect all stat fields by default */
+    opts->stat_mask = MFU_STAT_ALL;
+
+    /* Use a single thread per process by default */
+    opts->threads = 1;
+
+    /* Descend into all directories by default */
+    opts->maxdepth = -1;
+    opts->prune    = NULL;
+
+    /* Read every directory by default */
+    opts->prev = NULL;
+
+    /* Don't checkpoint or resume a walk by default */
+    opts->checkpoint      = NULL;
+    opts->checkpoint_secs = 600;
+    opts->resume          = NULL;
+
     return opts;
 }
 
@@ -123,7 +141,7 @@ static size_t list_elem_pack2_size(int detail, uint64_t chars, const elem_t* ele
 {
     size_t size;
     if (detail) {
-        size = 2 * 4 + chars + 0 * 4 + 10 * 8;
+        size = 2 * 4 + chars + 1 * 4 + 13 * 8;
     }
     else {
         size = 2 * 4 + chars + 1 * 4;
@@ -165,6 +183,9 @@ static size_t list_elem_pack2(void* buf, int detail, uint64_t chars, const elem_
 #endif
 
     if (detail) {
+        /* copy in mask of valid stat fields */
+        mfu_pack_uint32(&ptr, (uint32_t) elem->valid);
+
         /* copy in fields */
         mfu_pack_uint64(&ptr, elem->mode);
         mfu_pack_uint64(&ptr, elem->uid);
@@ -176,6 +197,9 @@ static size_t list_elem_pack2(void* buf, int detail, uint64_t chars, const elem_
         mfu_pack_uint64(&ptr, elem->ctime);
         mfu_pack_uint64(&ptr, elem->ctime_nsec);
         mfu_pack_uint64(&ptr, elem->size);
+        mfu_pack_uint64(&ptr, elem->dev);
+        mfu_pack_uint64(&ptr, elem->ino);
+        mfu_pack_uint64(&ptr, elem->nlink);
     }
     else {
         /* just have the file type */
@@ -187,7 +211,7 @@ static size_t list_elem_pack2(void* buf, int detail, uint64_t chars, const elem_
 }
 
 /* unpack element from buffer and return number of bytes read */
-static size_t list_elem_unpack2(const void* buf, elem_t* elem)
+static size_t list_elem_unpack2(flist_t* flist, const void* buf, elem_t* elem)
 {
     /* set pointer to start of buffer */
     const char* start = (const char*) buf;
@@ -206,7 +230,7 @@ static size_t list_elem_unpack2(const void* buf, elem_t* elem)
     ptr += chars;
 
     /* copy path */
-    elem->file = MFU_STRDUP(file);
+    elem->file = mfu_flist_strdup(flist, file);
 
     /* set depth */
     elem->depth = mfu_flist_compute_depth(file);
@@ -220,6 +244,11 @@ static size_t list_elem_unpack2(const void* buf, elem_t* elem)
 #endif
 
     if (detail) {
+        /* extract mask of valid stat fields */
+        uint32_t valid;
+        mfu_unpack_uint32(&ptr, &valid);
+        elem->valid = (unsigned int) valid;
+
         /* extract fields */
         mfu_unpack_uint64(&ptr, &elem->mode);
         mfu_unpack_uint64(&ptr, &elem->uid);
@@ -231,6 +260,9 @@ static size_t list_elem_unpack2(const void* buf, elem_t* elem)
         mfu_unpack_uint64(&ptr, &elem->ctime);
         mfu_unpack_uint64(&ptr, &elem->ctime_nsec);
         mfu_unpack_uint64(&ptr, &elem->size);
+        mfu_unpack_uint64(&ptr, &elem->dev);
+        mfu_unpack_uint64(&ptr, &elem->ino);
+        mfu_unpack_uint64(&ptr, &elem->nlink);
         /* use mode to set file type */
         elem->type = mfu_flist_mode_to_filetype((mode_t)elem->mode);
     }
@@ -239,12 +271,35 @@ static size_t list_elem_unpack2(const void* buf, elem_t* elem)
         uint32_t type;
         mfu_unpack_uint32(&ptr, &type);
         elem->type = (mfu_filetype) type;
+        elem->valid = 0;
+
+        /* no inode identity without stat data */
+        elem->dev   = 0;
+        elem->ino   = 0;
+        elem->nlink = 0;
     }
 
     size_t bytes = (size_t)(ptr - start);
     return bytes;
 }
 
+/* pack element with a name field sized to its own path,
+ * so that records of different lengths can follow one another */
+size_t mfu_flist_elem_pack_size(int detail, const elem_t* elem)
+{
+    return list_elem_pack2_size(detail, strlen(elem->file) + 1, elem);
+}
+
+size_t mfu_flist_elem_pack(void* buf, int detail, const elem_t* elem)
+{
+    return list_elem_pack2(buf, detail, strlen(elem->file) + 1, elem);
+}
+
+size_t mfu_flist_elem_unpack(flist_t* flist, const void* buf, elem_t* elem)
+{
+    return list_elem_unpack2(flist, buf, elem);
+}
+
 /* fake insert, just increase the count, used for counting */
 void mfu_flist_increase(mfu_flist* pbflist)
 {
@@ -257,6 +312,66 @@ void mfu_flist_increase(mfu_flist* pbflist)
     return;
 }
 
+/* number of bytes in each block of list memory */
+#define FLIST_BLOCK_SIZE (1024 * 1024)
+
+/* return pointer to size bytes of memory owned by the list, aligned
+ * to hold any element field, rather than calling malloc for each
+ * element and name, the list carves them from large blocks that are
+ * all freed together when the list is deleted */
+static void* list_alloc(flist_t* flist, size_t size)
+{
+    /* round up so the next allocation stays aligned */
+    size_t align = sizeof(uint64_t);
+    size = (size + align - 1) & ~(align - 1);
+
+    /* allocate a new block if the current one is full */
+    flist_block_t* block = flist->blocks;
+    if (block == NULL || block->used + size > block->size) {
+        /* large requests get a block of their own */
+        size_t block_size = FLIST_BLOCK_SIZE;
+        if (size > block_size) {
+            block_size = size;
+        }
+
+        block = (flist_block_t*) MFU_MALLOC(sizeof(flist_block_t) + block_size);
+        block->size = block_size;
+        block->used = 0;
+        block->next = flist->blocks;
+        flist->blocks = block;
+    }
+
+    /* hand out the next piece of the block */
+    char* ptr = (char*)(block + 1) + block->used;
+    block->used += size;
+    return ptr;
+}
+
+/* free all memory blocks of the list */
+static void list_free_blocks(flist_t* flist)
+{
+    flist_block_t* block = flist->blocks;
+    while (block != NULL) {
+        flist_block_t* next = block->next;
+        mfu_free(&block);
+        block = next;
+    }
+    flist->blocks = NULL;
+}
+
+elem_t* mfu_flist_elem_alloc(flist_t* flist)
+{
+    return (elem_t*) list_alloc(flist, sizeof(elem_t));
+}
+
+char* mfu_flist_strdup(flist_t* flist, const char* str)
+{
+    size_t len = strlen(str) + 1;
+    char* copy = (char*) list_alloc(flist, len);
+    memcpy(copy, str, len);
+    return copy;
+}
+
 /* add new element to running list index, allocates additional
  * capactiy for index if needed */
 static void list_index_append(flist_t* flist, elem_t* elem)
@@ -327,13 +442,14 @@ void mfu_flist_insert_elem(flist_t* flist, elem_t* elem)
 static void list_insert_copy(flist_t* flist, elem_t* src)
 {
     /* create new element */
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    elem_t* elem = mfu_flist_elem_alloc(flist);
 
     /* copy values from source */
-    elem->file       = MFU_STRDUP(src->file);
+    elem->file       = mfu_flist_strdup(flist, src->file);
     elem->depth      = src->depth;
     elem->type       = src->type;
     elem->detail     = src->detail;
+    elem->valid      = src->valid;
     elem->mode       = src->mode;
     elem->uid        = src->uid;
     elem->gid        = src->gid;
@@ -344,6 +460,9 @@ static void list_insert_copy(flist_t* flist, elem_t* src)
     elem->ctime      = src->ctime;
     elem->ctime_nsec = src->ctime_nsec;
     elem->size       = src->size;
+    elem->dev        = src->dev;
+    elem->ino        = src->ino;
+    elem->nlink      = src->nlink;
 
     /* append element to tail of linked list */
     mfu_flist_insert_elem(flist, elem);
@@ -353,12 +472,21 @@ static void list_insert_copy(flist_t* flist, elem_t* src)
 
 /* insert a file given its mode and optional stat data */
 void mfu_flist_insert_stat(flist_t* flist, const char* fpath, mode_t mode, const struct stat* sb)
+{
+    unsigned int valid = (sb != NULL) ? MFU_STAT_ALL : 0;
+    mfu_flist_insert_stat_valid(flist, fpath, mode, sb, valid);
+}
+
+/* insert a file given its mode and optional stat data,
+ * where valid is the set of MFU_STAT bits that hold meaningful
+ * values in sb, missing fields are filled in later on demand */
+void mfu_flist_insert_stat_valid(flist_t* flist, const char* fpath, mode_t mode, const struct stat* sb, unsigned int valid)
 {
     /* create new element to record file path, file type, and stat info */
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    elem_t* elem = mfu_flist_elem_alloc(flist);
 
     /* copy path */
-    elem->file = MFU_STRDUP(fpath);
+    elem->file = mfu_flist_strdup(flist, fpath);
 
     /* set depth */
     elem->depth = mfu_flist_compute_depth(fpath);
@@ -369,6 +497,7 @@ void mfu_flist_insert_stat(flist_t* flist, const char* fpath, mode_t mode, const
     /* copy stat info */
     if (sb != NULL) {
         elem->detail = 1;
+        elem->valid  = valid | MFU_STAT_MODE;
         elem->mode  = (uint64_t) sb->st_mode;
         elem->uid   = (uint64_t) sb->st_uid;
         elem->gid   = (uint64_t) sb->st_gid;
@@ -388,10 +517,19 @@ void mfu_flist_insert_stat(flist_t* flist, const char* fpath, mode_t mode, const
 
         elem->size  = (uint64_t) sb->st_size;
 
+        /* record inode identity to detect hard links */
+        elem->dev   = (uint64_t) sb->st_dev;
+        elem->ino   = (uint64_t) sb->st_ino;
+        elem->nlink = (uint64_t) sb->st_nlink;
+
         /* TODO: link to user and group names? */
     }
     else {
         elem->detail = 0;
+        elem->valid  = 0;
+        elem->dev    = 0;
+        elem->ino    = 0;
+        elem->nlink  = 0;
     }
 
     /* append element to tail of linked list */
@@ -403,13 +541,8 @@ void mfu_flist_insert_stat(flist_t* flist, const char* fpath, mode_t mode, const
 /* delete linked list of stat items */
 static void list_delete(flist_t* flist)
 {
-    elem_t* current = flist->list_head;
-    while (current != NULL) {
-        elem_t* next = current->next;
-        mfu_free(&current->file);
-        mfu_free(&current);
-        current = next;
-    }
+    /* elements and names live in the list's memory blocks */
+    list_free_blocks(flist);
     flist->list_count = 0;
     flist->list_head  = NULL;
     flist->list_tail  = NULL;
@@ -421,6 +554,11 @@ static void list_delete(flist_t* flist)
     return;
 }
 
+void mfu_flist_clear_elems(flist_t* flist)
+{
+    list_delete(flist);
+}
+
 /* given an index, return pointer to that file element,
  * NULL if index is not in range */
 static elem_t* list_get_elem(flist_t* flist, uint64_t idx)
@@ -549,6 +687,7 @@ mfu_flist mfu_flist_new()
     flist->list_tail  = NULL;
     flist->list_index = NULL;
     flist->list_cap   = 0;
+    flist->blocks     = NULL;
 
     /* initialize user and group structures */
     mfu_flist_usrgrp_init(flist);
@@ -886,12 +1025,102 @@ void *mfu_flist_file_get_acl(mfu_flist bflist, uint64_t idx, ssize_t *acl_size,
 }
 #endif
 
+/* lstat the item on demand if any of the requested MFU_STAT fields
+ * were not collected during the walk, fields that are already valid
+ * (e.g., set by the caller) are left as they are, items only miss
+ * fields when they come from a walk of a POSIX file system, so we
+ * can use lstat directly */
+void mfu_flist_elem_need(elem_t* elem, unsigned int fields)
+{
+    unsigned int missing = fields & ~elem->valid;
+    if (missing == 0 || (elem->valid & MFU_STAT_FAILED)) {
+        return;
+    }
+
+    /* fill in every field we don't already have */
+    missing = MFU_STAT_ALL & ~elem->valid;
+
+    struct stat st;
+    int stat_rc = mfu_lstat(elem->file, &st);
+    if (stat_rc != 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to stat `%s' (errno=%d %s)",
+            elem->file, errno, strerror(errno));
+
+        /* set missing fields to the value getters return for an
+         * unknown item, and remember not to try again */
+        if (missing & MFU_STAT_UID) {
+            elem->uid = (uint64_t) -1;
+        }
+        if (missing & MFU_STAT_GID) {
+            elem->gid = (uint64_t) -1;
+        }
+        if (missing & MFU_STAT_ATIME) {
+            elem->atime      = (uint64_t) -1;
+            elem->atime_nsec = (uint64_t) -1;
+        }
+        if (missing & MFU_STAT_MTIME) {
+            elem->mtime      = (uint64_t) -1;
+            elem->mtime_nsec = (uint64_t) -1;
+        }
+        if (missing & MFU_STAT_CTIME) {
+            elem->ctime      = (uint64_t) -1;
+            elem->ctime_nsec = (uint64_t) -1;
+        }
+        if (missing & MFU_STAT_SIZE) {
+            elem->size = (uint64_t) -1;
+        }
+        if (missing & MFU_STAT_INO) {
+            elem->dev   = (uint64_t) -1;
+            elem->ino   = (uint64_t) -1;
+            elem->nlink = (uint64_t) -1;
+        }
+        elem->valid |= MFU_STAT_FAILED;
+        return;
+    }
+
+    if (missing & MFU_STAT_UID) {
+        elem->uid = (uint64_t) st.st_uid;
+    }
+    if (missing & MFU_STAT_GID) {
+        elem->gid = (uint64_t) st.st_gid;
+    }
+
+    uint64_t secs, nsecs;
+    if (missing & MFU_STAT_ATIME) {
+        mfu_stat_get_atimes(&st, &secs, &nsecs);
+        elem->atime      = secs;
+        elem->atime_nsec = nsecs;
+    }
+    if (missing & MFU_STAT_MTIME) {
+        mfu_stat_get_mtimes(&st, &secs, &nsecs);
+        elem->mtime      = secs;
+        elem->mtime_nsec = nsecs;
+    }
+    if (missing & MFU_STAT_CTIME) {
+        mfu_stat_get_ctimes(&st, &secs, &nsecs);
+        elem->ctime      = secs;
+        elem->ctime_nsec = nsecs;
+    }
+    if (missing & MFU_STAT_SIZE) {
+        elem->size = (uint64_t) st.st_size;
+    }
+    if (missing & MFU_STAT_INO) {
+        elem->dev   = (uint64_t) st.st_dev;
+        elem->ino   = (uint64_t) st.st_ino;
+        elem->nlink = (uint64_t) st.st_nlink;
+    }
+
+    elem->valid |= MFU_STAT_ALL;
+    return;
+}
+
 uint64_t mfu_flist_file_get_uid(mfu_flist bflist, uint64_t idx)
 {
     uint64_t ret = (uint64_t) - 1;
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_UID);
         ret = elem->uid;
     }
     return ret;
@@ -903,6 +1132,7 @@ uint64_t mfu_flist_file_get_gid(mfu_flist bflist, uint64_t idx)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_GID);
         ret = elem->gid;
     }
     return ret;
@@ -914,6 +1144,7 @@ uint64_t mfu_flist_file_get_atime(mfu_flist bflist, uint64_t idx)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_ATIME);
         ret = elem->atime;
     }
     return ret;
@@ -925,6 +1156,7 @@ uint64_t mfu_flist_file_get_atime_nsec(mfu_flist bflist, uint64_t idx)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_ATIME);
         ret = elem->atime_nsec;
     }
     return ret;
@@ -936,6 +1168,7 @@ uint64_t mfu_flist_file_get_mtime(mfu_flist bflist, uint64_t idx)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_MTIME);
         ret = elem->mtime;
     }
     return ret;
@@ -947,6 +1180,7 @@ uint64_t mfu_flist_file_get_mtime_nsec(mfu_flist bflist, uint64_t idx)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_MTIME);
         ret = elem->mtime_nsec;
     }
     return ret;
@@ -958,6 +1192,7 @@ uint64_t mfu_flist_file_get_ctime(mfu_flist bflist, uint64_t idx)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_CTIME);
         ret = elem->ctime;
     }
     return ret;
@@ -969,6 +1204,7 @@ uint64_t mfu_flist_file_get_ctime_nsec(mfu_flist bflist, uint64_t idx)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_CTIME);
         ret = elem->ctime_nsec;
     }
     return ret;
@@ -980,11 +1216,48 @@ uint64_t mfu_flist_file_get_size(mfu_flist bflist, uint64_t idx)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_SIZE);
         ret = elem->size;
     }
     return ret;
 }
 
+uint64_t mfu_flist_file_get_dev(mfu_flist bflist, uint64_t idx)
+{
+    uint64_t ret = (uint64_t) - 1;
+    flist_t* flist = (flist_t*) bflist;
+    elem_t* elem = list_get_elem(flist, idx);
+    if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_INO);
+        ret = elem->dev;
+    }
+    return ret;
+}
+
+uint64_t mfu_flist_file_get_ino(mfu_flist bflist, uint64_t idx)
+{
+    uint64_t ret = (uint64_t) - 1;
+    flist_t* flist = (flist_t*) bflist;
+    elem_t* elem = list_get_elem(flist, idx);
+    if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_INO);
+        ret = elem->ino;
+    }
+    return ret;
+}
+
+uint64_t mfu_flist_file_get_nlink(mfu_flist bflist, uint64_t idx)
+{
+    uint64_t ret = (uint64_t) - 1;
+    flist_t* flist = (flist_t*) bflist;
+    elem_t* elem = list_get_elem(flist, idx);
+    if (elem != NULL && flist->detail) {
+        mfu_flist_elem_need(elem, MFU_STAT_INO);
+        ret = elem->nlink;
+    }
+    return ret;
+}
+
 const char* mfu_flist_file_get_username(mfu_flist bflist, uint64_t idx)
 {
     const char* ret = NULL;
@@ -1012,11 +1285,9 @@ void mfu_flist_file_set_name(mfu_flist bflist, uint64_t idx, const char* name)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
-        /* free existing name if there is one */
-        mfu_free(&elem->file);
-
-        /* set new name and compute depth */
-        elem->file = MFU_STRDUP(name);
+        /* set new name and compute depth, the space of the
+         * existing name is released along with the list */
+        elem->file = mfu_flist_strdup(flist, name);
         elem->depth = mfu_flist_compute_depth(name);
     }
     return;
@@ -1039,11 +1310,9 @@ void mfu_flist_file_set_cont(mfu_flist bflist, uint64_t idx, const char* name)
     flist_t* flist = (flist_t*) bflist;
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
-        /* free existing name if there is one */
-        mfu_free(&elem->file);
-
-        /* set new name */
-        elem->file = MFU_STRDUP(name);
+        /* set new name, the space of the existing
+         * name is released along with the list */
+        elem->file = mfu_flist_strdup(flist, name);
     }
     return;
 }
@@ -1075,6 +1344,7 @@ void mfu_flist_file_set_mode(mfu_flist bflist, uint64_t idx, uint64_t mode)
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->mode = mode;
+        elem->valid |= MFU_STAT_MODE;
     }
     return;
 }
@@ -1085,6 +1355,7 @@ void mfu_flist_file_set_uid(mfu_flist bflist, uint64_t idx, uint64_t uid)
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->uid = uid;
+        elem->valid |= MFU_STAT_UID;
     }
     return;
 }
@@ -1095,6 +1366,7 @@ void mfu_flist_file_set_gid(mfu_flist bflist, uint64_t idx, uint64_t gid)
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->gid = gid;
+        elem->valid |= MFU_STAT_GID;
     }
     return;
 }
@@ -1105,6 +1377,7 @@ void mfu_flist_file_set_atime(mfu_flist bflist, uint64_t idx, uint64_t atime)
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->atime = atime;
+        elem->valid |= MFU_STAT_ATIME;
     }
     return;
 }
@@ -1115,6 +1388,7 @@ void mfu_flist_file_set_atime_nsec(mfu_flist bflist, uint64_t idx, uint64_t atim
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->atime_nsec = atime_nsec;
+        elem->valid |= MFU_STAT_ATIME;
     }
     return;
 }
@@ -1125,6 +1399,7 @@ void mfu_flist_file_set_mtime(mfu_flist bflist, uint64_t idx, uint64_t mtime)
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->mtime = mtime;
+        elem->valid |= MFU_STAT_MTIME;
     }
     return;
 }
@@ -1135,6 +1410,7 @@ void mfu_flist_file_set_mtime_nsec(mfu_flist bflist, uint64_t idx, uint64_t mtim
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->mtime_nsec = mtime_nsec;
+        elem->valid |= MFU_STAT_MTIME;
     }
     return;
 }
@@ -1145,6 +1421,7 @@ void mfu_flist_file_set_ctime(mfu_flist bflist, uint64_t idx, uint64_t ctime)
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->ctime = ctime;
+        elem->valid |= MFU_STAT_CTIME;
     }
     return;
 }
@@ -1155,6 +1432,7 @@ void mfu_flist_file_set_ctime_nsec(mfu_flist bflist, uint64_t idx, uint64_t ctim
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->ctime_nsec = ctime_nsec;
+        elem->valid |= MFU_STAT_CTIME;
     }
     return;
 }
@@ -1165,6 +1443,40 @@ void mfu_flist_file_set_size(mfu_flist bflist, uint64_t idx, uint64_t size)
     elem_t* elem = list_get_elem(flist, idx);
     if (elem != NULL) {
         elem->size = size;
+        elem->valid |= MFU_STAT_SIZE;
+    }
+    return;
+}
+
+void mfu_flist_file_set_dev(mfu_flist bflist, uint64_t idx, uint64_t dev)
+{
+    flist_t* flist = (flist_t*) bflist;
+    elem_t* elem = list_get_elem(flist, idx);
+    if (elem != NULL) {
+        elem->dev = dev;
+        elem->valid |= MFU_STAT_INO;
+    }
+    return;
+}
+
+void mfu_flist_file_set_ino(mfu_flist bflist, uint64_t idx, uint64_t ino)
+{
+    flist_t* flist = (flist_t*) bflist;
+    elem_t* elem = list_get_elem(flist, idx);
+    if (elem != NULL) {
+        elem->ino = ino;
+        elem->valid |= MFU_STAT_INO;
+    }
+    return;
+}
+
+void mfu_flist_file_set_nlink(mfu_flist bflist, uint64_t idx, uint64_t nlink)
+{
+    flist_t* flist = (flist_t*) bflist;
+    elem_t* elem = list_get_elem(flist, idx);
+    if (elem != NULL) {
+        elem->nlink = nlink;
+        elem->valid |= MFU_STAT_INO;
     }
     return;
 }
@@ -1321,8 +1633,8 @@ size_t mfu_flist_file_unpack(const void* buf, mfu_flist bflist)
 {
     /* convert handle to flist_t */
     flist_t* flist = (flist_t*) bflist;
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
-    size_t size = list_elem_unpack2(buf, elem);
+    elem_t* elem = mfu_flist_elem_alloc(flist);
+    size_t size = list_elem_unpack2(flist, buf, elem);
     mfu_flist_insert_elem(flist, elem);
     return size;
 }
@@ -1333,7 +1645,7 @@ uint64_t mfu_flist_file_create(mfu_flist bflist)
     /* convert handle to flist_t */
     flist_t* flist = (flist_t*) bflist;
 
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    elem_t* elem = mfu_flist_elem_alloc(flist);
 
     /* initialize all fields */
     elem->file       = NULL;
@@ -1341,6 +1653,7 @@ uint64_t mfu_flist_file_create(mfu_flist bflist)
     elem->type       = MFU_TYPE_NULL;
 
     elem->detail     = 0;
+    elem->valid      = MFU_STAT_ALL;
     elem->mode       = 0;
     elem->uid        = getuid();
     elem->gid        = getgid();
@@ -1351,6 +1664,9 @@ uint64_t mfu_flist_file_create(mfu_flist bflist)
     elem->ctime      = 0;
     elem->ctime_nsec = 0;
     elem->size       = 0;
+    elem->dev        = 0;
+    elem->ino        = 0;
+    elem->nlink      = 0;
 
     /* for DAOS */
 #ifdef DAOS_SUPPORT
@@ -1610,6 +1926,118 @@ mfu_flist mfu_flist_spread(mfu_flist flist)
     return newlist;
 }
 
+/* map function to send all names of an inode to the same rank */
+static int map_inode(mfu_flist flist, uint64_t idx, int ranks, const void* args)
+{
+    /* hash the device and inode numbers together */
+    uint64_t key[2];
+    key[0] = mfu_flist_file_get_dev(flist, idx);
+    key[1] = mfu_flist_file_get_ino(flist, idx);
+    uint32_t hash = mfu_hash_jenkins((const char*)key, sizeof(key));
+    int rank = (int)(hash % (uint32_t)ranks);
+    return rank;
+}
+
+/* identifies an item in a list of hard links while sorting */
+typedef struct {
+    uint64_t dev;     /* device id */
+    uint64_t ino;     /* inode number */
+    const char* name; /* full path to item */
+    uint64_t idx;     /* index of item in list */
+} inode_key_t;
+
+/* order items by device, then inode, then name */
+static int inode_key_cmp(const void* a, const void* b)
+{
+    const inode_key_t* x = (const inode_key_t*) a;
+    const inode_key_t* y = (const inode_key_t*) b;
+    if (x->dev != y->dev) {
+        return (x->dev < y->dev) ? -1 : 1;
+    }
+    if (x->ino != y->ino) {
+        return (x->ino < y->ino) ? -1 : 1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+/* Split list into items whose data must be copied and names that are
+ * additional hard links to one of those items.  All names of a regular
+ * file with more than one link are sent to the same rank, which elects
+ * the name that sorts first as the owner of the inode.  On return,
+ * unique holds every item not linked to another item in the list plus
+ * one owner per inode, links holds the remaining names, and targets
+ * holds the owner of each item in links at the same index. */
+void mfu_flist_split_hardlinks(
+    mfu_flist flist,
+    mfu_flist* unique,
+    mfu_flist* links,
+    mfu_flist* targets)
+{
+    /* create output lists */
+    *unique  = mfu_flist_subset(flist);
+    *links   = mfu_flist_subset(flist);
+    *targets = mfu_flist_subset(flist);
+
+    /* separate regular files having more than one link from other items,
+     * we can only do this if we have stat data */
+    mfu_flist multi = mfu_flist_subset(flist);
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(flist);
+    int detail = mfu_flist_have_detail(flist);
+    for (idx = 0; idx < size; idx++) {
+        mfu_filetype type = mfu_flist_file_get_type(flist, idx);
+        if (detail && type == MFU_TYPE_FILE &&
+            mfu_flist_file_get_nlink(flist, idx) > 1)
+        {
+            mfu_flist_file_copy(flist, idx, multi);
+        } else {
+            mfu_flist_file_copy(flist, idx, *unique);
+        }
+    }
+    mfu_flist_summarize(multi);
+
+    /* gather all names of each inode on a single rank */
+    mfu_flist grouped = mfu_flist_remap(multi, map_inode, NULL);
+    mfu_flist_free(&multi);
+
+    /* sort our names by inode and name */
+    size = mfu_flist_size(grouped);
+    inode_key_t* keys = (inode_key_t*) MFU_MALLOC(size * sizeof(inode_key_t));
+    for (idx = 0; idx < size; idx++) {
+        keys[idx].dev  = mfu_flist_file_get_dev(grouped, idx);
+        keys[idx].ino  = mfu_flist_file_get_ino(grouped, idx);
+        keys[idx].name = mfu_flist_file_get_name(grouped, idx);
+        keys[idx].idx  = idx;
+    }
+    qsort(keys, (size_t)size, sizeof(inode_key_t), inode_key_cmp);
+
+    /* the first name of each inode owns the data,
+     * each other name becomes a link to it */
+    uint64_t owner = 0;
+    for (idx = 0; idx < size; idx++) {
+        if (idx == 0 ||
+            keys[idx].dev != keys[owner].dev ||
+            keys[idx].ino != keys[owner].ino)
+        {
+            owner = idx;
+            mfu_flist_file_copy(grouped, keys[idx].idx, *unique);
+        } else {
+            mfu_flist_file_copy(grouped, keys[idx].idx, *links);
+            mfu_flist_file_copy(grouped, keys[owner].idx, *targets);
+        }
+    }
+
+    mfu_free(&keys);
+    mfu_flist_free(&grouped);
+
+    /* compute global summary of output lists */
+    mfu_flist_summarize(*unique);
+    mfu_flist_summarize(*links);
+    mfu_flist_summarize(*targets);
+
+    return;
+}
+
 /* print information about a file given the index and rank (used in print_files) */
 static void print_file(mfu_flist flist, uint64_t idx)
 {
@@ -1807,13 +2235,19 @@ void mfu_flist_print(mfu_flist flist)
     return;
 }
 
-void mfu_flist_print_summary(mfu_flist flist)
+void mfu_flist_summary_init(mfu_flist_summary_t* summary)
 {
-    /* get our rank and the size of comm_world */
-    int rank, ranks;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    summary->detail  = 0;
+    summary->items   = 0;
+    summary->dirs    = 0;
+    summary->files   = 0;
+    summary->links   = 0;
+    summary->unknown = 0;
+    summary->bytes   = 0;
+}
 
+void mfu_flist_summary_add(mfu_flist flist, mfu_flist_summary_t* summary)
+{
     /* initlialize counters */
     uint64_t total_dirs    = 0;
     uint64_t total_files   = 0;
@@ -1871,14 +2305,44 @@ void mfu_flist_print_summary(mfu_flist flist)
         idx++;
     }
 
-    /* get total directories, files, links, and bytes */
-    uint64_t all_dirs, all_files, all_links, all_unknown, all_bytes;
-    uint64_t all_count = mfu_flist_global_size(flist);
-    MPI_Allreduce(&total_dirs,    &all_dirs,    1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
-    MPI_Allreduce(&total_files,   &all_files,   1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
-    MPI_Allreduce(&total_links,   &all_links,   1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
-    MPI_Allreduce(&total_unknown, &all_unknown, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
-    MPI_Allreduce(&total_bytes,   &all_bytes,   1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    /* add our counts to the summary */
+    if (mfu_flist_have_detail(flist)) {
+        summary->detail = 1;
+    }
+    summary->items   += max;
+    summary->dirs    += total_dirs;
+    summary->files   += total_files;
+    summary->links   += total_links;
+    summary->unknown += total_unknown;
+    summary->bytes   += total_bytes;
+
+    return;
+}
+
+void mfu_flist_summary_print(const mfu_flist_summary_t* summary)
+{
+    /* get our rank */
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* get total items, directories, files, links, and bytes */
+    uint64_t values[6], totals[6];
+    values[0] = summary->items;
+    values[1] = summary->dirs;
+    values[2] = summary->files;
+    values[3] = summary->links;
+    values[4] = summary->unknown;
+    values[5] = summary->bytes;
+    MPI_Allreduce(values, totals, 6, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    uint64_t all_count   = totals[0];
+    uint64_t all_dirs    = totals[1];
+    uint64_t all_files   = totals[2];
+    uint64_t all_links   = totals[3];
+    uint64_t all_bytes   = totals[5];
+
+    /* some processes may not have seen any list with stat data */
+    int detail;
+    MPI_Allreduce(&summary->detail, &detail, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
 
     /* convert total size to units */
     if (rank == 0) {
@@ -1888,7 +2352,7 @@ void mfu_flist_print_summary(mfu_flist flist)
         MFU_LOG(MFU_LOG_INFO, "  Links: %llu", (unsigned long long) all_links);
         /* MFU_LOG(MFU_LOG_INFO, "  Unknown: %lu", (unsigned long long) all_unknown); */
 
-        if (mfu_flist_have_detail(flist)) {
+        if (detail) {
             /* format total bytes */
             double agg_size_tmp;
             const char* agg_size_units;
@@ -1909,3 +2373,11 @@ void mfu_flist_print_summary(mfu_flist flist)
 
     return;
 }
+
+void mfu_flist_print_summary(mfu_flist flist)
+{
+    mfu_flist_summary_t summary;
+    mfu_flist_summary_init(&summary);
+    mfu_flist_summary_add(flist, &summary);
+    mfu_flist_summary_print(&summary);
+}
@@ -63,10 +63,20 @@ extern "C" {
 #define MFU_CHUNK_SIZE_STR "4MB"
 #define MFU_CHUNK_SIZE (4*1024*1024)
 
+/* default cost of opening a file when balancing chunks across processes,
+ * counted in bytes as though that much more data had to be copied */
+#define MFU_CHUNK_FILE_COST_STR "1MB"
+#define MFU_CHUNK_FILE_COST (1024*1024)
+
 /* default buffer size to read/write data to file system */
 #define MFU_BUFFER_SIZE_STR "4MB"
 #define MFU_BUFFER_SIZE (4*1024*1024)
 
+/* default number of buffers to keep in flight while copying file data,
+ * a value of 1 reads and writes each buffer in turn */
+#define MFU_IO_DEPTH_STR "1"
+#define MFU_IO_DEPTH (1)
+
 /*
  * FIXME: Is this description correct?
  *
@@ -276,6 +286,34 @@ void mfu_flist_read_cache(
     mfu_flist flist
 );
 
+/* read file list from file, items that can't satisfy pred may be
+ * left out of the list, so the list still needs to be filtered,
+ * only version 6 files record enough to leave items out */
+void mfu_flist_read_cache_pred(
+    const char* name,
+    mfu_flist flist,
+    mfu_pred* pred
+);
+
+/* function called on each batch of items read by mfu_flist_read_cache_batches,
+ * batch is a list of items on the calling process that is only valid
+ * during the call, items can be queried with mfu_flist_file_get_* */
+typedef void (*mfu_flist_batch_fn)(mfu_flist batch, void* arg);
+
+/* read file list from file and pass items to fn in batches of up to
+ * batch_size items instead of holding the whole list in memory,
+ * processes may see different numbers of batches so fn must not
+ * call collectives, lists from files older than version 4 are read
+ * whole and passed as one batch, if pred is not NULL, items that
+ * can't satisfy it may be left out as in mfu_flist_read_cache_pred */
+void mfu_flist_read_cache_batches(
+    const char* name,
+    mfu_pred* pred,
+    uint64_t batch_size,
+    mfu_flist_batch_fn fn,
+    void* arg
+);
+
 /* write file list to file */
 void mfu_flist_write_cache(
     const char* name,
@@ -294,6 +332,27 @@ void mfu_flist_print(mfu_flist flist);
 /* print count of items, directories, files, links, and bytes */
 void mfu_flist_print_summary(mfu_flist flist);
 
+/* counts of items, directories, files, links, and bytes gathered
+ * over one or more lists */
+typedef struct {
+    int detail;       /* set to 1 if any list had stat data */
+    uint64_t items;   /* number of items */
+    uint64_t dirs;    /* number of directories */
+    uint64_t files;   /* number of regular files */
+    uint64_t links;   /* number of symlinks */
+    uint64_t unknown; /* number of other items */
+    uint64_t bytes;   /* number of bytes in regular files */
+} mfu_flist_summary_t;
+
+/* set all counts in summary to 0 */
+void mfu_flist_summary_init(mfu_flist_summary_t* summary);
+
+/* add counts of items in local list to summary */
+void mfu_flist_summary_add(mfu_flist flist, mfu_flist_summary_t* summary);
+
+/* sum counts across processes and print them like mfu_flist_print_summary */
+void mfu_flist_summary_print(const mfu_flist_summary_t* summary);
+
 /****************************************
  * Functions to add new items to a list
  * and summarize global properties after adding new items
@@ -395,6 +454,9 @@ uint64_t mfu_flist_file_get_mtime_nsec(mfu_flist flist, uint64_t index);
 uint64_t mfu_flist_file_get_ctime(mfu_flist flist, uint64_t index);
 uint64_t mfu_flist_file_get_ctime_nsec(mfu_flist flist, uint64_t index);
 uint64_t mfu_flist_file_get_size(mfu_flist flist, uint64_t index);
+uint64_t mfu_flist_file_get_dev(mfu_flist flist, uint64_t index);
+uint64_t mfu_flist_file_get_ino(mfu_flist flist, uint64_t index);
+uint64_t mfu_flist_file_get_nlink(mfu_flist flist, uint64_t index);
 uint64_t mfu_flist_file_get_perm(mfu_flist flist, uint64_t index);
 #if DCOPY_USE_XATTRS
 void *mfu_flist_file_get_acl(mfu_flist bflist, uint64_t idx, ssize_t *acl_size, char *type);
@@ -420,6 +482,9 @@ void mfu_flist_file_set_mtime_nsec(mfu_flist flist, uint64_t index, uint64_t mti
 void mfu_flist_file_set_ctime(mfu_flist flist, uint64_t index, uint64_t ctime);
 void mfu_flist_file_set_ctime_nsec(mfu_flist flist, uint64_t index, uint64_t ctime_nsec);
 void mfu_flist_file_set_size(mfu_flist flist, uint64_t index, uint64_t size);
+void mfu_flist_file_set_dev(mfu_flist flist, uint64_t index, uint64_t dev);
+void mfu_flist_file_set_ino(mfu_flist flist, uint64_t index, uint64_t ino);
+void mfu_flist_file_set_nlink(mfu_flist flist, uint64_t index, uint64_t nlink);
 #if DCOPY_USE_XATTRS
 //void *mfu_flist_file_set_acl(mfu_flist bflist, uint64_t idx, ssize_t *acl_size, char *type);
 #endif
@@ -442,6 +507,12 @@ mfu_flist mfu_flist_remap(mfu_flist list, mfu_flist_map_fn map, const void* args
  * and then returns the newly created list to the caller */
 mfu_flist mfu_flist_spread(mfu_flist flist);
 
+/* split a list into items whose data must be copied (unique) and names
+ * that are extra hard links to one of those items (links), for each item
+ * in links, targets holds the item it links to at the same index,
+ * requires stat data, all three output lists must be freed by caller */
+void mfu_flist_split_hardlinks(mfu_flist flist, mfu_flist* unique, mfu_flist* links, mfu_flist* targets);
+
 /* sort flist by specified fields, given as common-delimitted list
  * returns a newly allocated sorted list
  * precede field name with '-' character to reverse sort order:
@@ -468,6 +539,14 @@ mfu_copy_opts_t* mfu_copy_opts_new(void);
 /* free object allocated in mfu_copy_opts_new */
 void mfu_copy_opts_delete(mfu_copy_opts_t** opts);
 
+/* convert an I/O engine name ("posix" or "uring") to its value,
+ * returns MFU_SUCCESS if the name is valid, MFU_FAILURE otherwise */
+int mfu_io_engine_parse(const char* str, mfu_io_engine* engine);
+
+/* convert a sync mode name ("node", "fs", or "file") to its value,
+ * returns MFU_SUCCESS if the name is valid, MFU_FAILURE otherwise */
+int mfu_sync_mode_parse(const char* str, mfu_sync_mode* mode);
+
 /* copy items in list from source paths to destination,
  * each item in source list must come from one of the
  * given source paths, returns 0 on success -1 on error */
@@ -599,9 +678,17 @@ typedef struct mfu_file_chunk_struct {
 
 /* given a file list and a chunk size, split files at chunk boundaries and evenly
  * spread chunks to processes, returns a linked list of file sections each process
- * is responsbile for */
+ * is responsbile for, chunks are balanced by their length plus a cost for opening
+ * each file (MFU_FILE_CHUNK_FILE_COST, default MFU_CHUNK_FILE_COST_STR), set
+ * MFU_FILE_CHUNK_BALANCE=COUNT to give each process the same number of chunks */
 mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size);
 
+/* like mfu_file_chunk_list_alloc, but uses lseek(SEEK_DATA/SEEK_HOLE) to
+ * leave out chunks that lie entirely within holes of sparse files,
+ * the last chunk of each file is always included so the file size can be
+ * set, returns number of bytes left out on the calling process in holes */
+mfu_file_chunk* mfu_file_chunk_list_alloc_data(mfu_flist list, uint64_t chunk_size, uint64_t* holes);
+
 /* free the linked list allocated with mfu_file_chunk_list_alloc */
 void mfu_file_chunk_list_free(mfu_file_chunk** phead);
 
@@ -640,6 +727,7 @@ typedef struct {
     size_t  header_size;
     int     create_libcircle;
     int     extract_libarchive;
+    int     open_files;
 } mfu_archive_opts_t;
 
 /* return a newly allocated archive_opts structure, set default values on its fields */
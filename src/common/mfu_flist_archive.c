@@ -98,45 +98,31 @@ static void DTAR_exit(int code)
  * the same file when using libcicle
  ***************************************/
 
-/* TODO: this is basically a copy of mfu_copy_file_open/close.
- * It should be moved to use that instead in the future */
-
-/* cache open file descriptor to avoid
+/* cache open file descriptors to avoid
  * opening / closing the same file */
 typedef struct {
-    char* name; /* name of open file (NULL if none) */
-    int   read; /* whether file is open for read-only (1) or write (0) */
-    int   sync; /* whether to fsync file on close (1) or not (0) */
-    int   fd;   /* file descriptor */
+    mfu_file_cache files; /* files kept open */
+    mfu_file_t     file;  /* refers to the most recently opened file */
 } mfu_archive_file_cache_t;
 
-/* close a file that opened with mfu_copy_open_file */
+/* initialize a cache to keep up to capacity files open */
+static void mfu_archive_init_file(
+    mfu_archive_file_cache_t* cache,
+    int capacity)
+{
+    cache->file.type = POSIX;
+    cache->file.fd   = -1;
+    mfu_file_cache_init(&cache->files, capacity);
+}
+
+/* close all files that were opened with mfu_archive_open_file */
 static int mfu_archive_close_file(
     mfu_archive_file_cache_t* cache)
 {
-    int rc = 0;
-
-    /* close file if we have one */
-    char* name = cache->name;
-    if (name != NULL) {
-        int fd = cache->fd;
-
-        /* if open for write, fsync */
-        int read_flag = cache->read;
-        int sync_flag = cache->sync;
-        if (! read_flag && sync_flag) {
-            rc = mfu_fsync(name, fd);
-        }
-
-        /* close the file and delete the name string */
-        rc = mfu_close(name, fd);
-        mfu_free(&cache->name);
-    }
-
-    return rc;
+    return mfu_file_cache_close(&cache->files, &cache->file);
 }
 
-/* open and cache a file.
+/* open and cache a file, the descriptor is in cache->file.fd.
  * Returns 0 on success, -1 otherwise */
 static int mfu_archive_open_file(
     const char* file,                /* path to file to be opened */
@@ -144,45 +130,21 @@ static int mfu_archive_open_file(
     int sync_flag,                   /* set to 1 to sync file on close (if opned for write) */
     mfu_archive_file_cache_t* cache) /* cache the open file to avoid repetitive open/close of the same file */
 {
-    /* see if we have a cached file descriptor */
-    char* name = cache->name;
-    if (name != NULL) {
-        /* we have a cached file descriptor */
-        int fd = cache->fd;
-        if (strcmp(name, file) == 0 && cache->read == read_flag) {
-            /* the file we're trying to open matches name and read/write mode,
-             * so just return the cached descriptor */
-            return 0;
-        } else {
-            /* the file we're trying to open is different,
-             * close the old file and delete the name */
-            mfu_archive_close_file(cache);
-        }
+    int flags = O_RDONLY;
+    if (! read_flag) {
+        flags = O_WRONLY | O_CREAT;
     }
 
-    /* open the new file */
-    int fd;
-    if (read_flag) {
-        int flags = O_RDONLY;
-        fd = mfu_open(file, flags);
-    } else {
-        int flags = O_WRONLY | O_CREAT;
-        fd = mfu_open(file, flags, DCOPY_DEF_PERMS_FILE);
-    }
-    if (fd < 0) {
+    int rc = mfu_file_cache_open(&cache->files, file, flags,
+        DCOPY_DEF_PERMS_FILE, (! read_flag && sync_flag), &cache->file);
+    if (rc < 0) {
         return -1;
     }
 
-    /* cache the file descriptor */
-    cache->name = MFU_STRDUP(file);
-    cache->fd   = fd;
-    cache->read = read_flag;
-    cache->sync = sync_flag;
-
     return 0;
 }
 
-/** Cache most recent open file descriptor to avoid opening / closing the same file */
+/** Cache open file descriptors to avoid opening / closing the same file */
 static mfu_archive_file_cache_t mfu_archive_src_cache;
 static mfu_archive_file_cache_t mfu_archive_dst_cache;
 
@@ -730,7 +692,7 @@ static void DTAR_perform_copy(CIRCLE_handle* handle)
     int read_flag = 1;
     int sync_flag = 0;
     int open_rc = mfu_archive_open_file(in_name, read_flag, sync_flag, &mfu_archive_src_cache);
-    int in_fd = mfu_archive_src_cache.fd;
+    int in_fd = mfu_archive_src_cache.file.fd;
     if (open_rc == -1) {
         MFU_LOG(MFU_LOG_ERR, "Failed to open source file '%s' errno=%d %s",
             in_name, errno, strerror(errno));
@@ -917,7 +879,7 @@ static void DTAR_perform_extract(CIRCLE_handle* handle)
     int read_flag = 0; /* write */
     int sync_flag = DTAR_opts->sync_on_close;
     int open_rc = mfu_archive_open_file(out_name, read_flag, sync_flag, &mfu_archive_dst_cache);
-    int out_fd = mfu_archive_dst_cache.fd;
+    int out_fd = mfu_archive_dst_cache.file.fd;
     if (open_rc == -1) {
         MFU_LOG(MFU_LOG_ERR, "Failed to open destination file '%s' errno=%d %s",
             out_name, errno, strerror(errno));
@@ -2267,7 +2229,7 @@ static int mfu_flist_archive_create_copy_libcircle(
     DTAR_data_offsets = data_offsets;
 
     /* initialize file cache for opening source files */
-    mfu_archive_src_cache.name = NULL;
+    mfu_archive_init_file(&mfu_archive_src_cache, opts->open_files);
 
     /* prepare libcircle */
     CIRCLE_init(0, NULL, CIRCLE_SPLIT_EQUAL | CIRCLE_CREATE_GLOBAL | CIRCLE_TERM_TREE);
@@ -4525,6 +4487,9 @@ static int extract_files_offsets_chunk_libcircle(
     DTAR_rank_disps   = rank_disps;
     DTAR_data_chunks  = data_chunks;
 
+    /* initialize file cache for opening destination files */
+    mfu_archive_init_file(&mfu_archive_dst_cache, opts->open_files);
+
     /* prepare libcircle */
     CIRCLE_init(0, NULL, CIRCLE_SPLIT_EQUAL | CIRCLE_CREATE_GLOBAL | CIRCLE_TERM_TREE);
     CIRCLE_loglevel loglevel = CIRCLE_LOG_WARN;
@@ -5785,6 +5750,9 @@ mfu_archive_opts_t* mfu_archive_opts_new(void)
     /* whether to extract items with libarchive (1) or read data from archive directly (0) */
     opts->extract_libarchive = 0;
 
+    /* number of files each process keeps open while copying data */
+    opts->open_files = MFU_OPEN_FILES;
+
     return opts;
 }
 
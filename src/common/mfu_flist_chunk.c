@@ -1,6 +1,12 @@
+/* for SEEK_DATA and SEEK_HOLE */
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 
 #include <string.h>
 
@@ -12,63 +18,278 @@
  * Functions to divide flist into linked list of file sections
  ***************************************/
 
-/* given a file offset, the rank of the last process to hold an
- * extra chunk, and the number of chunks per rank, compute
- * and return the rank of the chunk at the given offset */
-static int map_chunk_to_rank(uint64_t offset, uint64_t cutoff, uint64_t chunks_per_rank)
+/* methods to balance file chunks across processes */
+typedef enum {
+    CHUNK_BALANCE_COUNT, /* each chunk counts the same regardless of its length */
+    CHUNK_BALANCE_BYTES, /* chunks are weighted by their length plus a cost to open each file */
+} mfu_file_chunk_balance;
+
+/* cost model used to weight chunks when balancing */
+typedef struct {
+    mfu_file_chunk_balance balance; /* balancing method */
+    uint64_t file_cost;             /* cost of opening a file, in equivalent bytes */
+} mfu_file_chunk_cost;
+
+/* select how chunks are balanced, which can be overridden
+ * through environment variables */
+static void select_chunk_cost(mfu_file_chunk_cost* cost)
+{
+    /* default to weighting chunks by bytes */
+    cost->balance   = CHUNK_BALANCE_BYTES;
+    cost->file_cost = MFU_CHUNK_FILE_COST;
+
+    char varname[] = "MFU_FILE_CHUNK_BALANCE";
+    const char* value = getenv(varname);
+    if (value != NULL) {
+        if (strcmp(value, "COUNT") == 0) {
+            cost->balance = CHUNK_BALANCE_COUNT;
+        } else if (strcmp(value, "BYTES") == 0) {
+            cost->balance = CHUNK_BALANCE_BYTES;
+        } else {
+            if (mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_ERR, "%s: Unknown value: %s", varname, value);
+            }
+        }
+    }
+
+    char costname[] = "MFU_FILE_CHUNK_FILE_COST";
+    value = getenv(costname);
+    if (value != NULL) {
+        unsigned long long bytes;
+        if (mfu_abtoull(value, &bytes) == MFU_SUCCESS) {
+            cost->file_cost = (uint64_t) bytes;
+        } else {
+            if (mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_ERR, "%s: Invalid value: %s", costname, value);
+            }
+        }
+    }
+}
+
+/* return the number of chunks to copy for a file of the given size,
+ * the last chunk may be partial and a 0-size file still takes a chunk */
+static uint64_t file_chunk_count(uint64_t file_size, uint64_t chunk_size)
 {
-    /* total number of chunks held by ranks below cutoff */
-    uint64_t cutoff_coverage = cutoff * (chunks_per_rank + 1);
+    uint64_t chunks = file_size / chunk_size;
+    if (chunks * chunk_size < file_size || file_size == 0) {
+        chunks++;
+    }
+    return chunks;
+}
+
+/* return the cost of processing one chunk of a file,
+ * the cost of opening the file is charged to its first chunk,
+ * so runs of small files cost about as much as one large chunk */
+static uint64_t file_chunk_cost(
+    const mfu_file_chunk_cost* cost,
+    uint64_t chunk_id,
+    uint64_t chunk_size,
+    uint64_t file_size)
+{
+    if (cost->balance == CHUNK_BALANCE_COUNT) {
+        return 1;
+    }
+
+    /* length of this chunk, the last one may be partial */
+    uint64_t offset = chunk_id * chunk_size;
+    uint64_t length = file_size - offset;
+    if (length > chunk_size) {
+        length = chunk_size;
+    }
 
-    /* given an offset of a chunk, identify which rank will
-     * be responsible */
-    int rank;
-    if (offset < cutoff_coverage) {
-        rank = (int) (offset / (chunks_per_rank + 1));
-    } else {
-        rank = (int) (cutoff + (offset - cutoff_coverage) / chunks_per_rank);
+    uint64_t val = length;
+    if (chunk_id == 0) {
+        val += cost->file_cost;
     }
 
+    /* every chunk takes some effort, this also avoids
+     * a zero total when all files are empty */
+    if (val == 0) {
+        val = 1;
+    }
+
+    return val;
+}
+
+/* given the global offset and cost of a chunk in the sequence of all
+ * chunks, and the total cost of all chunks, compute and return the rank
+ * responsible for the chunk, each rank is assigned a contiguous range
+ * of chunks amounting to about total / ranks, a chunk belongs to the
+ * range holding its midpoint */
+static int map_chunk_to_rank(uint64_t offset, uint64_t cost, uint64_t total, int ranks)
+{
+    double midpoint = (double) offset + (double) cost / 2.0;
+    int rank = (int) (midpoint * (double) ranks / (double) total);
+    if (rank >= ranks) {
+        rank = ranks - 1;
+    }
     return rank;
 }
 
+/* tracks the current range of data in a file while walking its chunks,
+ * so we only need a pair of lseek calls for each data range */
+typedef struct {
+    const char* name; /* name of file */
+    int fd;           /* file descriptor, -1 if holes are not being detected */
+    uint64_t data;    /* offset of first byte of current data range */
+    uint64_t hole;    /* offset of first hole after current data range */
+} mfu_file_chunk_holes;
+
+/* start looking for holes in the named file, only files that span more
+ * than one chunk are opened since a single chunk is always copied */
+static void chunk_holes_open(
+    mfu_file_chunk_holes* h,
+    const char* name,
+    uint64_t file_size,
+    uint64_t chunk_size)
+{
+    h->name = name;
+    h->fd   = -1;
+    h->data = 0;
+    h->hole = 0;
+    if (file_size > chunk_size) {
+        h->fd = mfu_open(name, O_RDONLY);
+    }
+}
+
+/* stop looking for holes in the current file */
+static void chunk_holes_close(mfu_file_chunk_holes* h)
+{
+    if (h->fd >= 0) {
+        mfu_close(h->name, h->fd);
+        h->fd = -1;
+    }
+}
+
+/* return 1 if any byte in the given range of the file may hold data,
+ * and 0 if the range lies entirely within a hole, chunks must be
+ * queried in increasing order of offset */
+static int chunk_holes_has_data(mfu_file_chunk_holes* h, uint64_t offset, uint64_t length)
+{
+    /* assume there is data if we can't tell */
+    if (h->fd < 0) {
+        return 1;
+    }
+
+    /* find the next data range if the current one ends before this chunk */
+    if (h->hole <= offset) {
+        off_t data = lseek(h->fd, (off_t) offset, SEEK_DATA);
+        if (data < 0) {
+            if (errno != ENXIO) {
+                /* file system can't report holes, copy everything */
+                chunk_holes_close(h);
+                return 1;
+            }
+
+            /* no data from offset to the end of the file */
+            h->data = UINT64_MAX;
+            h->hole = UINT64_MAX;
+        } else {
+            off_t hole = lseek(h->fd, data, SEEK_HOLE);
+            if (hole < 0) {
+                chunk_holes_close(h);
+                return 1;
+            }
+            h->data = (uint64_t) data;
+            h->hole = (uint64_t) hole;
+        }
+    }
+
+    /* the current data range ends after offset,
+     * so the chunk has data if the range starts before its end */
+    return (h->data < offset + length);
+}
+
 /* This is a long routine, but the idea is simple.  All tasks sum up
- * the number of file chunks they have, and those are then evenly
- * distributed amongst the processes.  */
-mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
+ * the cost of their file chunks, and chunks are then distributed
+ * amongst the processes so that each gets about the same total cost.
+ * Chunks are weighted by bytes plus a per-file open cost, so that
+ * processes assigned many small files get fewer bytes to move.
+ * If skip_holes is set, chunks that fall entirely within a hole of
+ * a sparse file are left out, except for the last chunk of each file,
+ * and the number of bytes left out is added to holes. */
+static mfu_file_chunk* chunk_list_alloc(
+    mfu_flist list,
+    uint64_t chunk_size,
+    int skip_holes,
+    uint64_t* holes)
 {
     /* get our rank and number of ranks */
     int rank, ranks;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &ranks);
 
-    /* total up number of file chunks for all files in our list */
-    uint64_t count = 0;
+    /* determine how to weight chunks */
+    mfu_file_chunk_cost cost;
+    select_chunk_cost(&cost);
+
+    /* when skipping holes, we record whether each of our chunks holds
+     * data as we total up costs, so that chunks are assigned to ranks
+     * below using the same decisions even if files change meanwhile */
     uint64_t idx;
     uint64_t size = mfu_flist_size(list);
+    uint8_t* has_data = NULL;
+    if (skip_holes) {
+        uint64_t all_chunks = 0;
+        for (idx = 0; idx < size; idx++) {
+            mfu_filetype type = mfu_flist_file_get_type(list, idx);
+            if (type == MFU_TYPE_FILE) {
+                uint64_t file_size = mfu_flist_file_get_size(list, idx);
+                all_chunks += file_chunk_count(file_size, chunk_size);
+            }
+        }
+        has_data = (uint8_t*) MFU_MALLOC(all_chunks * sizeof(uint8_t));
+    }
+
+    /* total up cost of file chunks for all files in our list */
+    uint64_t count = 0;
+    uint64_t chunk_index = 0;
     for (idx = 0; idx < size; idx++) {
         /* get type of item */
         mfu_filetype type = mfu_flist_file_get_type(list, idx);
 
-        /* if we have a file, add up its chunks */
+        /* if we have a file, add up the cost of its chunks */
         if (type == MFU_TYPE_FILE) {
             /* get size of file */
             uint64_t file_size = mfu_flist_file_get_size(list, idx);
 
             /* compute number of chunks to copy for this file */
-            uint64_t chunks = file_size / chunk_size;
-            if (chunks * chunk_size < file_size || file_size == 0) {
-                /* this accounts for the last chunk, which may be
-                 * partial or it adds a chunk for 0-size files */
-                chunks++;
+            uint64_t chunks = file_chunk_count(file_size, chunk_size);
+
+            /* look for holes if requested */
+            mfu_file_chunk_holes h;
+            h.fd = -1;
+            if (skip_holes) {
+                const char* name = mfu_flist_file_get_name(list, idx);
+                chunk_holes_open(&h, name, file_size, chunk_size);
             }
 
-            /* include these chunks in our total */
-            count += chunks;
+            /* include cost of these chunks in our total */
+            uint64_t chunk_id;
+            for (chunk_id = 0; chunk_id < chunks; chunk_id++) {
+                if (skip_holes) {
+                    /* always keep the last chunk, which sets the file size */
+                    uint64_t chunk_offset = chunk_id * chunk_size;
+                    uint64_t chunk_length = file_size - chunk_offset;
+                    if (chunk_length > chunk_size) {
+                        chunk_length = chunk_size;
+                    }
+                    int keep = (chunk_id == chunks - 1 ||
+                        chunk_holes_has_data(&h, chunk_offset, chunk_length));
+                    has_data[chunk_index++] = (uint8_t) keep;
+                    if (! keep) {
+                        *holes += chunk_length;
+                        continue;
+                    }
+                }
+                count += file_chunk_cost(&cost, chunk_id, chunk_size, file_size);
+            }
+
+            chunk_holes_close(&h);
         }
     }
 
-    /* compute total number of chunks across procs */
+    /* compute total cost of chunks across procs */
     uint64_t total;
     MPI_Allreduce(&count, &total, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
 
@@ -79,13 +300,6 @@ mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
         offset = 0;
     }
 
-    /* compute number of chunks per task, ranks below cutoff will
-     * be responsible for (chunks_per_rank+1) and ranks at cutoff
-     * and above are responsible for chunks_per_rank */
-    uint64_t chunks_per_rank = total / (uint64_t) ranks;
-    uint64_t coverage = chunks_per_rank * (uint64_t) ranks;
-    uint64_t cutoff = total - coverage;
-
     /* TODO: replace this with DSDE */
 
     /* allocate an array of integers to use in alltoall,
@@ -103,16 +317,18 @@ mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
     }
 
     /* if we have some chunks, figure out the number of ranks
-     * we'll send to and the range of rank ids, set flags to 1 */
+     * we'll send to and the range of rank ids, set flags to 1,
+     * the range spans all ranks covering our part of the total,
+     * a rank at either end may end up with no chunks from us,
+     * in which case we send it an empty message */
     int send_ranks = 0;
     int first_send_rank, last_send_rank;
     if (count > 0) {
         /* compute first rank we'll send data to */
-        first_send_rank = map_chunk_to_rank(offset, cutoff, chunks_per_rank);
+        first_send_rank = map_chunk_to_rank(offset, 0, total, ranks);
 
         /* compute last rank we'll send to */
-        uint64_t last_offset = offset + count - 1;
-        last_send_rank  = map_chunk_to_rank(last_offset, cutoff, chunks_per_rank);
+        last_send_rank  = map_chunk_to_rank(offset + count, 0, total, ranks);
 
         /* set flag for each process we'll send data to */
         for (i = first_send_rank; i <= last_send_rank; i++) {
@@ -143,6 +359,7 @@ mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
      * send to each task, as an optimization, we encode consecutive
      * chunks of the same file into a single unit */
     uint64_t current_offset = offset;
+    chunk_index = 0;
     for (idx = 0; idx < size; idx++) {
         /* get type of item */
         mfu_filetype type = mfu_flist_file_get_type(list, idx);
@@ -153,18 +370,23 @@ mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
             uint64_t file_size = mfu_flist_file_get_size(list, idx);
 
             /* compute number of chunks to copy for this file */
-            uint64_t chunks = file_size / chunk_size;
-            if (chunks * chunk_size < file_size || file_size == 0) {
-                chunks++;
-            }
+            uint64_t chunks = file_chunk_count(file_size, chunk_size);
 
             /* iterate over each chunk of this file and determine the
              * rank we should send it to */
             int prev_rank = MPI_PROC_NULL;
             uint64_t chunk_id;
             for (chunk_id = 0; chunk_id < chunks; chunk_id++) {
+                /* skip chunks within holes, the chunk after a hole
+                 * always starts a new element */
+                if (has_data != NULL && ! has_data[chunk_index++]) {
+                    prev_rank = MPI_PROC_NULL;
+                    continue;
+                }
+
                 /* determine which rank we should map this chunk to */
-                int current_rank = map_chunk_to_rank(current_offset, cutoff, chunks_per_rank);
+                uint64_t chunk_cost = file_chunk_cost(&cost, chunk_id, chunk_size, file_size);
+                int current_rank = map_chunk_to_rank(current_offset, chunk_cost, total, ranks);
 
                 /* compute index into our send_ranks arrays */
                 int rank_index = current_rank - first_send_rank;
@@ -224,7 +446,7 @@ mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
                 }
 
                 /* go on to our next chunk */
-                current_offset++;
+                current_offset += chunk_cost;
             }
         }
     }
@@ -393,6 +615,9 @@ mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
         tail = p;
     }
 
+    /* free the flags marking chunks with data */
+    mfu_free(&has_data);
+
     /* free the send and receive flag arrays */
     mfu_free(&sendlist);
     mfu_free(&recvlist);
@@ -434,6 +659,17 @@ mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
     return head;
 }
 
+mfu_file_chunk* mfu_file_chunk_list_alloc(mfu_flist list, uint64_t chunk_size)
+{
+    return chunk_list_alloc(list, chunk_size, 0, NULL);
+}
+
+mfu_file_chunk* mfu_file_chunk_list_alloc_data(mfu_flist list, uint64_t chunk_size, uint64_t* holes)
+{
+    *holes = 0;
+    return chunk_list_alloc(list, chunk_size, 1, holes);
+}
+
 /* free the linked list of structs (copy elem's) */
 void mfu_file_chunk_list_free(mfu_file_chunk** phead)
 {
@@ -43,6 +43,7 @@
 
 #include <libgen.h> /* dirname */
 #include <stdbool.h>
+#include <aio.h>
 #include "libcircle.h"
 #include "dtcmp.h"
 
@@ -64,6 +65,10 @@
 #include <gpfs.h>
 #endif
 
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
 /****************************************
  * Define types
  ***************************************/
@@ -74,22 +79,29 @@ typedef struct {
     int64_t  total_links;        /* sum of all symlinks */
     int64_t  total_size;         /* sum of all file sizes */
     int64_t  total_bytes_copied; /* total bytes written */
+    int64_t  total_bytes_cloned;    /* bytes shared with reflinks */
+    int64_t  total_bytes_offloaded; /* bytes copied with copy_file_range */
     time_t   time_started;       /* time when dcp command started */
     time_t   time_ended;         /* time when dcp command ended */
     double   wtime_started;      /* time when dcp command started */
     double   wtime_ended;        /* time when dcp command ended */
 } mfu_copy_stats_t;
 
-/* cache open file descriptor to avoid
- * opening / closing the same file */
+/* tracks one buffer in the pipelined copy,
+ * each buffer has at most one read or write in flight */
+typedef enum {
+    MFU_COPY_SLOT_IDLE = 0, /* no operation is using the buffer */
+    MFU_COPY_SLOT_READ,     /* buffer is being filled from the source */
+    MFU_COPY_SLOT_WRITE,    /* buffer is being drained to the destination */
+} mfu_copy_slot_op;
+
 typedef struct {
-    char* name;    /* name of open file (NULL if none) */
-    int   read;    /* whether file is open for read-only (1) or write (0) */
-    int   fd;      /* file descriptor */
-#ifdef DAOS_SUPPORT
-    dfs_obj_t* obj; /* open object */
-#endif
-} mfu_copy_file_cache_t;
+    char* buf;           /* buffer holding data for this slot */
+    struct aiocb cb;     /* control block of operation in flight */
+    mfu_copy_slot_op op; /* type of operation last started on buffer */
+    int queued;          /* 1 if operation was queued with aio, 0 if it completed synchronously */
+    ssize_t result;      /* number of bytes transferred by synchronous operation */
+} mfu_copy_slot_t;
 
 /****************************************
  * Define globals
@@ -138,123 +150,65 @@ static void mkdir_progress_fn(const uint64_t* vals, int count, int complete, int
     }
 }
 
-/** Cache most recent open file descriptor to avoid opening / closing the same file */
-static mfu_copy_file_cache_t mfu_copy_src_cache;
-static mfu_copy_file_cache_t mfu_copy_dst_cache;
+/** Cache open file descriptors to avoid opening / closing the same file */
+static mfu_file_cache mfu_copy_src_cache;
+static mfu_file_cache mfu_copy_dst_cache;
 
 /* open and cache a file.
  * Returns 0 on success; -1 otherwise */
 static int mfu_copy_open_file(
     const char* file,             /* path to file to be opened */
     int read_flag,                /* set to 1 to open in read only, 0 for write */
-    mfu_copy_file_cache_t* cache, /* cache the open file to avoid repetitive open/close of the same file */
+    mfu_file_cache* cache,        /* cache the open file to avoid repetitive open/close of the same file */
     mfu_copy_opts_t* copy_opts,   /* options configuring the copy operation */
     mfu_file_t* mfu_file)         /* whether the file is in POSIX/DAOS */
 {
-    /* see if we have a cached file descriptor */
-    char* name = cache->name;
-    if (name != NULL) {
-        /* we have a cached file descriptor */
-        int fd = cache->fd;
-#ifdef DAOS_SUPPORT
-        dfs_obj_t* obj = cache->obj;
-#endif
-        if (strcmp(name, file) == 0 && cache->read == read_flag) {
-            /* the file we're trying to open matches name and read/write mode,
-             * so just return the cached descriptor */
-            return 0;
-        } else {
-            /* the file we're trying to open is different,
-             * close the old file and delete the name */
-            mfu_file_close(name, mfu_file);
-            mfu_free(&cache->name);
-        }
+    int flags = O_RDONLY;
+    if (! read_flag) {
+        flags = O_WRONLY | O_CREAT;
     }
-
-    /* open the new file, this sets mfu_file->fd/obj */
-    if (read_flag) {
-        int flags = O_RDONLY;
-        if (copy_opts->direct) {
-            flags |= O_DIRECT;
-        }
-        mfu_file_open(file, flags, mfu_file);
-    } else {
-        int flags = O_WRONLY | O_CREAT;
-        if (copy_opts->direct) {
-            flags |= O_DIRECT;
-        }
-        mfu_file_open(file, flags, mfu_file, DCOPY_DEF_PERMS_FILE);
+    if (copy_opts->direct) {
+        flags |= O_DIRECT;
     }
 
-    /* cache the file descriptor */
-    if (mfu_file->type == POSIX) {
-        if (mfu_file->fd < 0) {
-            return -1;
-        }
-
-        cache->name = MFU_STRDUP(file);
-        cache->fd   = mfu_file->fd;
-        cache->read = read_flag;
+    /* files we write are synced as they are closed if the
+     * sync mode asks for it, otherwise mfu_sync_all flushes them */
+    int sync_flag = (! read_flag &&
+                     mfu_file->type == POSIX &&
+                     copy_opts->sync_mode == MFU_SYNC_FILE);
 
-#ifdef LUSTRE_SUPPORT
-        /* Zero is an invalid ID for grouplock. */
-        if (copy_opts->grouplock_id != 0) {
-            errno = 0;
-            int rc = ioctl(mfu_file->fd, LL_IOC_GROUP_LOCK, copy_opts->grouplock_id);
-            if (rc) {
-                MFU_LOG(MFU_LOG_ERR, "Failed to obtain grouplock with ID %d "
-                    "on file `%s', ignoring this error (errno=%d %s)",
-                    copy_opts->grouplock_id, file, errno, strerror(errno));
-            } else {
-                MFU_LOG(MFU_LOG_INFO, "Obtained grouplock with ID %d "
-                    "on file `%s', fd %d", copy_opts->grouplock_id,
-                    file, mfu_file->fd);
-            }
-        }
-#endif
+    /* this sets mfu_file->fd/obj */
+    int rc = mfu_file_cache_open(cache, file, flags, DCOPY_DEF_PERMS_FILE, sync_flag, mfu_file);
+    if (rc < 0) {
+        return -1;
     }
 
-#ifdef DAOS_SUPPORT
-    if (mfu_file->type == DFS) {
-        if (mfu_file->obj == NULL) {
-            return -1;
+#ifdef LUSTRE_SUPPORT
+    /* Zero is an invalid ID for grouplock. */
+    if (rc == 1 && mfu_file->type == POSIX && copy_opts->grouplock_id != 0) {
+        errno = 0;
+        int rc = ioctl(mfu_file->fd, LL_IOC_GROUP_LOCK, copy_opts->grouplock_id);
+        if (rc) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to obtain grouplock with ID %d "
+                "on file `%s', ignoring this error (errno=%d %s)",
+                copy_opts->grouplock_id, file, errno, strerror(errno));
+        } else {
+            MFU_LOG(MFU_LOG_INFO, "Obtained grouplock with ID %d "
+                "on file `%s', fd %d", copy_opts->grouplock_id,
+                file, mfu_file->fd);
         }
-        
-        cache->name = MFU_STRDUP(file);
-        cache->read = read_flag;
-        cache->obj  = mfu_file->obj;
     }
 #endif
 
     return 0;
 }
 
-/* close a file that opened with mfu_copy_open_file */
+/* close all files that were opened with mfu_copy_open_file */
 static int mfu_copy_close_file(
-    mfu_copy_file_cache_t* cache,
+    mfu_file_cache* cache,
     mfu_file_t* mfu_file)
 {
-    int rc = 0;
-
-    /* close file if we have one */
-    char* name = cache->name;
-    if (name != NULL) {
-        int fd = cache->fd;
-#ifdef DAOS_SUPPORT
-        dfs_obj_t* obj = cache->obj;
-#endif
-        /* if open for write, fsync */
-        int read_flag = cache->read;
-        if (! read_flag && mfu_file->type == POSIX) {
-            rc = mfu_fsync(name, fd);
-        }
-
-        /* close the file and delete the name string */
-        rc = mfu_file_close(name, mfu_file);
-        mfu_free(&cache->name);
-    }
-
-    return rc;
+    return mfu_file_cache_close(cache, mfu_file);
 }
 
 /* copy all extended attributes from op->operand to dest_path,
@@ -1564,6 +1518,82 @@ static int mfu_create_hardlinks(
     return rc;
 }
 
+/* create each name in links as a hard link to the destination of
+ * the item at the same index in targets, whose data has been copied */
+static int mfu_copy_hardlinks(
+    mfu_flist links,
+    mfu_flist targets,
+    int numpaths,
+    const mfu_param_path* paths,
+    const mfu_param_path* destpath,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    int rc = 0;
+
+    /* get current rank */
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* bail early if there is no work to do */
+    mknod_total_count = mfu_flist_global_size(links);
+    if (mknod_total_count == 0) {
+        return rc;
+    }
+
+    /* indicate to user what phase we're in */
+    if (rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "Creating %llu hard links.", (unsigned long long) mknod_total_count);
+    }
+
+    /* start progress messages for creating links */
+    mfu_progress* create_prog = mfu_progress_start(mfu_progress_timeout, 1, MPI_COMM_WORLD, create_progress_fn);
+
+    uint64_t count = 0;
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(links);
+    for (idx = 0; idx < size; idx++) {
+        /* get destination name of link and of the file it refers to */
+        const char* name   = mfu_flist_file_get_name(links, idx);
+        const char* target = mfu_flist_file_get_name(targets, idx);
+        char* dest = mfu_param_path_copy_dest(name, numpaths,
+                paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+        char* dest_target = mfu_param_path_copy_dest(target, numpaths,
+                paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+
+        if (dest != NULL && dest_target != NULL) {
+            /* replace any item already at the destination */
+            int link_rc = mfu_hardlink(dest_target, dest);
+            if (link_rc != 0 && errno == EEXIST) {
+                mfu_file_unlink(dest, mfu_dst_file);
+                link_rc = mfu_hardlink(dest_target, dest);
+            }
+
+            if (link_rc != 0) {
+                MFU_LOG(MFU_LOG_ERR, "Failed to create hardlink %s --> %s (errno=%d %s)",
+                        dest, dest_target, errno, strerror(errno));
+                rc = -1;
+            } else {
+                /* increment our file count by one */
+                mfu_copy_stats.total_files++;
+            }
+        }
+
+        mfu_free(&dest_target);
+        mfu_free(&dest);
+
+        /* update number of links we have created for progress messages */
+        count++;
+        mfu_progress_update(&count, create_prog);
+    }
+
+    /* finalize progress messages */
+    mfu_progress_complete(&count, &create_prog);
+
+    return rc;
+}
+
 /* hold state for copy progress messages */
 static mfu_progress* copy_prog;
 
@@ -1613,19 +1643,99 @@ static void copy_progress_fn(const uint64_t* vals, int count, int complete, int
     }
 }
 
-/* return 1 if entire buffer is 0, return 0 if any byte is not 0,
- * we avoid writing NULL blocks when supporting sparse files */
-static int mfu_is_all_null(const char* buf, uint64_t buf_size)
+/* in sparse mode, regions of a buffer are checked for zeros in blocks
+ * of this many bytes, aligned to file offsets, and each block of zeros
+ * is left as a hole rather than written */
+#define MFU_COPY_HOLE_SIZE (4096)
+
+/* given the position of a byte in a buffer holding size bytes read
+ * from file offset off, return the position just past its hole block */
+static size_t mfu_copy_hole_block_end(size_t size, off_t off, size_t pos)
 {
-    uint64_t i;
-    for (i = 0; i < buf_size; i++) {
-        if (buf[i] != 0) {
-            return 0;
+    size_t end = pos + MFU_COPY_HOLE_SIZE - (size_t)((uint64_t)(off + (off_t)pos) % MFU_COPY_HOLE_SIZE);
+    if (end > size) {
+        end = size;
+    }
+    return end;
+}
+
+/* find the next run of data in a buffer of size bytes read from file
+ * offset off, starting the search at pos, a run spans consecutive hole
+ * blocks that each hold a nonzero byte, sets start and end to the
+ * bounds of the run and returns 1, or returns 0 if the buffer holds
+ * only zeros from pos to its end */
+static int mfu_copy_next_data(
+    const char* buf,
+    size_t size,
+    off_t off,
+    size_t pos,
+    size_t* start,
+    size_t* end)
+{
+    /* skip over blocks of zeros */
+    while (pos < size) {
+        size_t next = mfu_copy_hole_block_end(size, off, pos);
+        if (! mfu_is_zero(buf + pos, next - pos)) {
+            break;
+        }
+        pos = next;
+    }
+
+    if (pos >= size) {
+        return 0;
+    }
+
+    /* extend the run until the next block of zeros */
+    *start = pos;
+    pos = mfu_copy_hole_block_end(size, off, pos);
+    while (pos < size) {
+        size_t next = mfu_copy_hole_block_end(size, off, pos);
+        if (mfu_is_zero(buf + pos, next - pos)) {
+            break;
         }
+        pos = next;
     }
+    *end = pos;
+
     return 1;
 }
 
+/* write count bytes from buf to dest at offset off, retrying short writes,
+ * returns 0 on success and -1 on error */
+static int mfu_copy_write_buf(
+    const char* src,
+    const char* dest,
+    const char* buf,
+    size_t count,
+    off_t off,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_dst_file)
+{
+    /* we loop to account for short writes */
+    size_t n = 0;
+    while (n < count) {
+        /* write bytes to destination file */
+        ssize_t bytes_written = mfu_file_pwrite(dest, buf + n, count - n, off + (off_t)n, mfu_dst_file);
+
+        /* check for an error */
+        if (bytes_written < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s' (errno=%d %s)",
+                src, dest, errno, strerror(errno));
+            return -1;
+        }
+
+        /* So long as we're not using O_DIRECT, we can handle short writes
+         * by advancing by the number of bytes written.  For O_DIRECT, we
+         * need to keep buffer, file offset, and amount to write aligned
+         * on block boundaries, so just retry the entire operation. */
+        if (!copy_opts->direct || (size_t)bytes_written == count) {
+            n += (size_t)bytes_written;
+        }
+    }
+
+    return 0;
+}
+
 static int mfu_copy_file_normal(
     const char* src,
     const char* dest,
@@ -1717,34 +1827,26 @@ static int mfu_copy_file_normal(
         /* If in sparse mode, skip writing out blocks that are all 0.
          * Rely on posix hole semantics to account for those 0 values instead.
          * If this hole is at the end of the file, the truncate below will
-         * set the file size correctly. */
-        int skip_write = 0;
-        if (copy_opts->sparse && mfu_is_all_null(buf, bytes_to_write)) {
-            skip_write = 1;
-        }
-
-        /* write data to destination file if needed */
-        if (! skip_write) {
-            /* we loop to account for short writes */
-            ssize_t n = 0;
-            while (n < bytes_to_write) {
-                /* write bytes to destination file */
-                ssize_t bytes_written = mfu_file_pwrite(dest, ((char*)buf) + n, bytes_to_write - n, off + n, mfu_dst_file);
-
-                /* check for an error */
-                if (bytes_written < 0) {
-                    MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s' (errno=%d %s)",
-                        src, dest, errno, strerror(errno));
+         * set the file size correctly.  Without O_DIRECT, we can leave
+         * holes for zero blocks within the buffer and only write the
+         * runs of data between them.  O_DIRECT writes must cover the
+         * full aligned buffer, so there we only skip entire buffers. */
+        if (copy_opts->sparse && ! copy_opts->direct) {
+            size_t start;
+            size_t end = 0;
+            while (mfu_copy_next_data((const char*)buf, bytes_to_write, off, end, &start, &end)) {
+                if (mfu_copy_write_buf(src, dest, (const char*)buf + start, end - start,
+                    off + (off_t)start, copy_opts, mfu_dst_file) < 0)
+                {
                     return -1;
                 }
-
-                /* So long as we're not using O_DIRECT, we can handle short writes
-                 * by advancing by the number of bytes written.  For O_DIRECT, we
-                 * need to keep buffer, file offset, and amount to write aligned
-                 * on block boundaries, so just retry the entire operation. */
-                if (!copy_opts->direct || bytes_written == bytes_to_write) {
-                    n += bytes_written;
-                }
+            }
+        } else if (! copy_opts->sparse || ! mfu_is_zero(buf, bytes_to_write)) {
+            /* write data to destination file */
+            if (mfu_copy_write_buf(src, dest, (const char*)buf, bytes_to_write,
+                off, copy_opts, mfu_dst_file) < 0)
+            {
+                return -1;
             }
         }
 
@@ -1785,129 +1887,667 @@ static int mfu_copy_file_normal(
     return 0;
 }
 
-static int mfu_copy_file_fiemap(
+/* start reading count bytes at offset from the source into slot buffer,
+ * if the request can't be queued, the read is executed before returning */
+static void mfu_copy_slot_read(
+    mfu_copy_slot_t* slot,
     const char* src,
+    int fd,
+    size_t count,
+    off_t offset)
+{
+    memset(&slot->cb, 0, sizeof(slot->cb));
+    slot->cb.aio_fildes = fd;
+    slot->cb.aio_buf    = slot->buf;
+    slot->cb.aio_nbytes = count;
+    slot->cb.aio_offset = offset;
+    slot->op = MFU_COPY_SLOT_READ;
+
+    slot->queued = 1;
+    if (aio_read(&slot->cb) != 0) {
+        /* unable to queue the request (e.g., EAGAIN), so do it now */
+        slot->queued = 0;
+        slot->result = mfu_pread(src, fd, slot->buf, count, offset);
+    }
+}
+
+/* start writing count bytes from slot buffer to the destination at offset,
+ * if the request can't be queued, the write is executed before returning */
+static void mfu_copy_slot_write(
+    mfu_copy_slot_t* slot,
     const char* dest,
-    uint64_t offset,
-    uint64_t length,
-    uint64_t file_size,
-    bool* normal_copy_required,
-    mfu_copy_opts_t* copy_opts,
-    mfu_file_t* mfu_src_file,
-    mfu_file_t* mfu_dst_file)
+    int fd,
+    size_t count,
+    off_t offset)
 {
-    *normal_copy_required = true;
-    if (copy_opts->direct) {
-        goto fail_normal_copy;
+    memset(&slot->cb, 0, sizeof(slot->cb));
+    slot->cb.aio_fildes = fd;
+    slot->cb.aio_buf    = slot->buf;
+    slot->cb.aio_nbytes = count;
+    slot->cb.aio_offset = offset;
+    slot->op = MFU_COPY_SLOT_WRITE;
+
+    slot->queued = 1;
+    if (aio_write(&slot->cb) != 0) {
+        /* unable to queue the request (e.g., EAGAIN), so do it now */
+        slot->queued = 0;
+        slot->result = mfu_pwrite(dest, fd, slot->buf, count, offset);
     }
+}
 
-#ifdef DAOS_SUPPORT
-    /* Not yet supported */
-    if (mfu_src_file->type == DFS) {
-        goto fail_normal_copy;
+/* wait for the operation started on the slot to complete,
+ * returns number of bytes transferred, or -1 with errno set on error */
+static ssize_t mfu_copy_slot_wait(mfu_copy_slot_t* slot)
+{
+    /* nothing to wait on if the operation was executed synchronously */
+    if (! slot->queued) {
+        return slot->result;
     }
-#endif
 
-    size_t last_ext_start = offset;
-    size_t last_ext_len = 0;
+    /* block until the request finishes, aio_suspend may return early on a signal */
+    const struct aiocb* list[1] = { &slot->cb };
+    int err;
+    while ((err = aio_error(&slot->cb)) == EINPROGRESS) {
+        aio_suspend(list, 1, NULL);
+    }
 
-    struct fiemap *fiemap = (struct fiemap*)malloc(sizeof(struct fiemap));
-    if (fiemap == NULL) {
-        MFU_LOG(MFU_LOG_ERR, "Out of memory allocating fiemap");
-        goto fail_normal_copy;
+    /* reap the request, this must be called exactly once per request */
+    ssize_t rc = aio_return(&slot->cb);
+    if (err != 0) {
+        errno = err;
+        rc = -1;
     }
-    memset(fiemap, 0, sizeof(struct fiemap));
 
-    fiemap->fm_start  = offset;
-    fiemap->fm_length = length;
-    fiemap->fm_flags  = FIEMAP_FLAG_SYNC;
-    fiemap->fm_extent_count   = 0;
-    fiemap->fm_mapped_extents = 0;
+    /* record result in case we're called again for the same operation */
+    slot->queued = 0;
+    slot->result = rc;
+    return rc;
+}
 
-    struct stat sb;
-    if (fstat(mfu_src_file->fd, &sb) < 0) {
-        goto fail_fiemap;
+/* wait for a write started on the slot and finish any short write,
+ * returns 0 on success and -1 on error */
+static int mfu_copy_slot_finish_write(
+    mfu_copy_slot_t* slot,
+    const char* src,
+    const char* dest,
+    int fd,
+    bool direct)
+{
+    /* nothing to do if buffer is not being written */
+    if (slot->op != MFU_COPY_SLOT_WRITE) {
+        return 0;
     }
-
-    if (ioctl(mfu_src_file->fd, FS_IOC_FIEMAP, fiemap) < 0) {
-        if (errno == ENOTSUP) {
-            /* silently ignore */
+    slot->op = MFU_COPY_SLOT_IDLE;
+
+    size_t count = slot->cb.aio_nbytes;
+    off_t offset = slot->cb.aio_offset;
+    ssize_t n = mfu_copy_slot_wait(slot);
+    while (n >= 0 && (size_t)n < count) {
+        /* So long as we're not using O_DIRECT, we can handle short writes
+         * by advancing by the number of bytes written.  For O_DIRECT, we
+         * need to keep buffer, file offset, and amount to write aligned
+         * on block boundaries, so just retry the entire operation. */
+        if (direct) {
+            ssize_t bytes_written = mfu_pwrite(dest, fd, slot->buf, count, offset);
+            if (bytes_written < 0 || (size_t)bytes_written == count) {
+                n = bytes_written;
+            }
         } else {
-            MFU_LOG(MFU_LOG_ERR, "fiemap ioctl() failed for src '%s' (errno=%d %s)",
-                    src, errno, strerror(errno));
+            ssize_t bytes_written = mfu_pwrite(dest, fd, slot->buf + n, count - (size_t)n, offset + n);
+            n = (bytes_written < 0) ? bytes_written : n + bytes_written;
         }
-        goto fail_fiemap;
-    }
-
-    size_t extents_size = sizeof(struct fiemap_extent) * (fiemap->fm_mapped_extents);
-
-    /* reallocate the fiemap.
-     * If realloc returns NULL, the original fiemap is left malloc'ed */
-    struct fiemap* new_fiemap = (struct fiemap*) realloc(fiemap, sizeof(struct fiemap) + extents_size);
-    if (new_fiemap == NULL) {
-        MFU_LOG(MFU_LOG_ERR, "Out of memory reallocating fiemap");
-        goto fail_fiemap;
     }
-    fiemap = new_fiemap;
-
-    memset(fiemap->fm_extents, 0, extents_size);
-    fiemap->fm_extent_count   = fiemap->fm_mapped_extents;
-    fiemap->fm_mapped_extents = 0;
 
-    if (ioctl(mfu_src_file->fd, FS_IOC_FIEMAP, fiemap) < 0) {
-        MFU_LOG(MFU_LOG_ERR, "fiemap ioctl() failed for src '%s' (errno=%d %s)",
-                src, errno, strerror(errno));
-        goto fail_fiemap;
+    if (n < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s' (errno=%d %s)",
+            src, dest, errno, strerror(errno));
+        return -1;
     }
 
-    uint64_t last_byte = offset + length;
+    return 0;
+}
 
-    if (fiemap->fm_mapped_extents > 0) {
-        uint64_t fe_logical = fiemap->fm_extents[0].fe_logical;
-        uint64_t fe_length  = fiemap->fm_extents[0].fe_length;
-        if (fe_logical < offset) {
-            fiemap->fm_extents[0].fe_length -= (offset - fe_logical);
-            fiemap->fm_extents[0].fe_logical = offset;
-        }
+/* copies data like mfu_copy_file_normal, but keeps up to io_depth
+ * buffers in flight so that reading the next buffers from the source
+ * overlaps with writing previous buffers to the destination,
+ * assumes both files are POSIX and open */
+static int mfu_copy_file_pipeline(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    /* set buffer size and number of buffers */
+    size_t buf_size = copy_opts->buf_size;
+    uint64_t depth  = (uint64_t) copy_opts->io_depth;
+    bool direct     = copy_opts->direct;
 
-        fe_logical = fiemap->fm_extents[fiemap->fm_mapped_extents - 1].fe_logical;
-        fe_length  = fiemap->fm_extents[fiemap->fm_mapped_extents - 1].fe_length;
-        if (fe_logical + fe_length > last_byte) {
-           fiemap->fm_extents[fiemap->fm_mapped_extents - 1].fe_length -=
-           fe_logical + fe_length - last_byte;
-        }
+    /* for O_DIRECT, check that length is multiple of buf_size */
+    if (direct &&                      /* using O_DIRECT */
+        offset + length < file_size && /* not at end of file */
+        length % buf_size != 0)        /* length not an integer multiple of block size */
+    {
+        MFU_ABORT(-1, "O_DIRECT requires chunk size to be integer multiple of block size %llu",
+            (unsigned long long) buf_size);
     }
 
-    *normal_copy_required = false;
+    int src_fd = mfu_src_file->fd;
+    int dst_fd = mfu_dst_file->fd;
 
-    /* seek to offset in source file */
-    if (mfu_file_lseek(src, mfu_src_file, (off_t)last_ext_start, SEEK_SET) < 0) {
-        MFU_LOG(MFU_LOG_ERR, "Couldn't seek in source path `%s' (errno=%d %s)",
-            src, errno, strerror(errno));
-        goto fail_fiemap;
+    /* set up a slot for each buffer */
+    mfu_copy_slot_t* slots = (mfu_copy_slot_t*) MFU_MALLOC(depth * sizeof(mfu_copy_slot_t));
+    uint64_t i;
+    for (i = 0; i < depth; i++) {
+        slots[i].buf    = copy_opts->io_bufs[i];
+        slots[i].op     = MFU_COPY_SLOT_IDLE;
+        slots[i].queued = 0;
+        slots[i].result = 0;
     }
 
-    /* seek to offset in destination file */
-    if (mfu_file_lseek(dest, mfu_dst_file, (off_t)last_ext_start, SEEK_SET) < 0) {
-        MFU_LOG(MFU_LOG_ERR, "Couldn't seek in destination path `%s' (errno=%d %s)",
-            dest, errno, strerror(errno));
-        goto fail_fiemap;
-    }
+    /* block i of the chunk always goes through slot (i % depth) */
+    uint64_t blocks = (length + buf_size - 1) / buf_size;
 
-    unsigned int i;
-    for (i = 0; i < fiemap->fm_mapped_extents; i++) {
-        size_t ext_start;
-        size_t ext_len;
-        size_t ext_hole_size;
+    /* O_DIRECT requires read operation of certain size blocks,
+     * even if we know that would run past the end of the file */
+    #define MFU_COPY_BLOCK_LEN(b) \
+        ((direct || length - (b) * buf_size >= buf_size) ? buf_size : (size_t)(length - (b) * buf_size))
 
-        size_t buf_size = copy_opts->buf_size;
-        void* buf = copy_opts->block_buf1;
+    /* prime the pipeline by issuing a read into each buffer */
+    uint64_t issued = 0;
+    while (issued < blocks && issued < depth) {
+        off_t off = (off_t)(offset + issued * buf_size);
+        mfu_copy_slot_read(&slots[issued], src, src_fd, MFU_COPY_BLOCK_LEN(issued), off);
+        issued++;
+    }
 
-        ext_start = fiemap->fm_extents[i].fe_logical;
-        ext_len = fiemap->fm_extents[i].fe_length;
-        ext_hole_size = ext_start - (last_ext_start + last_ext_len);
+    int rc = 0;
+    uint64_t total_bytes = 0;
+    uint64_t done = 0;
+    while (done < blocks) {
+        /* wait for oldest outstanding read */
+        mfu_copy_slot_t* slot = &slots[done % depth];
+        size_t left_to_read = MFU_COPY_BLOCK_LEN(done);
+        off_t off = (off_t)(offset + done * buf_size);
+        ssize_t bytes_read = mfu_copy_slot_wait(slot);
+        slot->op = MFU_COPY_SLOT_IDLE;
 
-        if (ext_hole_size) {
+        /* If we're using O_DIRECT, deal with short reads.
+         * Retry with same buffer and offset since those must
+         * be aligned at block boundaries. */
+        while (direct &&                       /* using O_DIRECT */
+               bytes_read > 0 &&               /* read was not an error or eof */
+               bytes_read < left_to_read &&    /* shorter than requested */
+               (off + bytes_read) < file_size) /* not at end of file */
+        {
+            bytes_read = mfu_pread(src, src_fd, slot->buf, left_to_read, off);
+        }
+
+        /* otherwise, the rest of the block must still be read since
+         * the offsets of the blocks after this one are already fixed */
+        while (! direct &&
+               bytes_read > 0 &&
+               bytes_read < left_to_read)
+        {
+            ssize_t n = mfu_pread(src, src_fd, slot->buf + bytes_read,
+                left_to_read - (size_t)bytes_read, off + bytes_read);
+            if (n <= 0) {
+                bytes_read = (n < 0) ? n : 0;
+                break;
+            }
+            bytes_read += n;
+        }
+
+        /* check for an error */
+        if (bytes_read < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Read error when copying from `%s' to `%s' (errno=%d %s)",
+                src, dest, errno, strerror(errno));
+            rc = -1;
+            break;
+        }
+
+        /* check for early EOF */
+        if (bytes_read == 0) {
+            MFU_LOG(MFU_LOG_ERR, "Source file `%s' shorter than expected %llu (errno=%d %s)",
+                src, (unsigned long long) file_size, errno, strerror(errno));
+            rc = -1;
+            break;
+        }
+
+        /* compute number of bytes to write */
+        size_t bytes_to_write = (size_t) bytes_read;
+        if (direct) {
+            /* O_DIRECT requires particular write sizes,
+             * ok to write beyond end of file so long as
+             * we truncate in cleanup step */
+            size_t remainder = buf_size - (size_t) bytes_read;
+            if (remainder > 0) {
+                /* zero out the end of the buffer for security,
+                 * don't want to leave data from another file at end of
+                 * current file if we fail before truncating */
+                memset(slot->buf + bytes_read, 0, remainder);
+            }
+
+            /* assumes buf_size is magic size for O_DIRECT */
+            bytes_to_write = buf_size;
+        }
+
+        /* If in sparse mode, skip writing out blocks that are all 0.
+         * Rely on posix hole semantics to account for those 0 values instead.
+         * If this hole is at the end of the file, the truncate below will
+         * set the file size correctly. */
+        if (! copy_opts->sparse || ! mfu_is_zero(slot->buf, bytes_to_write)) {
+            /* start writing this block, the next read overlaps with it */
+            mfu_copy_slot_write(slot, dest, dst_fd, bytes_to_write, off);
+        }
+
+        /* accumulate number of bytes copied */
+        total_bytes += (uint64_t) bytes_read;
+
+        /* update number of bytes we have copied for progress messages */
+        copy_count += (uint64_t) bytes_read;
+        mfu_progress_update(&copy_count, copy_prog);
+
+        done++;
+
+        /* refill the slot holding the oldest write with the next block,
+         * which first requires that write to complete */
+        if (issued < blocks) {
+            mfu_copy_slot_t* next = &slots[issued % depth];
+            if (mfu_copy_slot_finish_write(next, src, dest, dst_fd, direct) < 0) {
+                rc = -1;
+                break;
+            }
+            off_t next_off = (off_t)(offset + issued * buf_size);
+            mfu_copy_slot_read(next, src, src_fd, MFU_COPY_BLOCK_LEN(issued), next_off);
+            issued++;
+        }
+    }
+
+    #undef MFU_COPY_BLOCK_LEN
+
+    /* drain all operations still in flight before buffers can be reused,
+     * this includes any reads we abandoned due to an error */
+    for (i = 0; i < depth; i++) {
+        if (slots[i].op == MFU_COPY_SLOT_WRITE) {
+            if (mfu_copy_slot_finish_write(&slots[i], src, dest, dst_fd, direct) < 0) {
+                rc = -1;
+            }
+        } else if (slots[i].op == MFU_COPY_SLOT_READ) {
+            mfu_copy_slot_wait(&slots[i]);
+            slots[i].op = MFU_COPY_SLOT_IDLE;
+        }
+    }
+    mfu_free(&slots);
+
+    if (rc != 0) {
+        return -1;
+    }
+
+    /* Increment the global counter. */
+    mfu_copy_stats.total_size += (int64_t) total_bytes;
+    mfu_copy_stats.total_bytes_copied += (int64_t) total_bytes;
+
+    /* if we wrote the last chunk, truncate the file */
+    off_t last_written = offset + length;
+    off_t file_size_offt = (off_t) file_size;
+    if (last_written >= file_size_offt || file_size == 0) {
+        /* Use ftruncate() here rather than truncate(), because grouplock
+         * of Lustre would cause block to truncate() since the fd is different
+         * from the out_fd. */
+        if (mfu_file_ftruncate(mfu_dst_file, file_size_offt) < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to truncate destination file: %s (errno=%d %s)",
+                dest, errno, strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* try to copy a chunk without moving data through user space,
+ * first by sharing extents with a reflink and then with copy_file_range,
+ * sets *offloaded to the number of bytes from the start of the chunk
+ * that were copied, the caller copies the rest through a buffer,
+ * returns 0 on success and -1 on error */
+static int mfu_copy_file_offload(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size,
+    uint64_t* offloaded,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    *offloaded = 0;
+
+    /* check whether this chunk ends the file */
+    int last_chunk = (offset + length >= file_size);
+
+#ifdef FICLONERANGE
+    /* Reflink the chunk if the file system supports it.  Offsets must
+     * be aligned to file system blocks, except that a length of 0 clones
+     * to the end of the source file, which we use for the last chunk. */
+    struct file_clone_range range;
+    range.src_fd      = (int64_t) mfu_src_file->fd;
+    range.src_offset  = offset;
+    range.src_length  = last_chunk ? 0 : length;
+    range.dest_offset = offset;
+    if (ioctl(mfu_dst_file->fd, FICLONERANGE, &range) == 0) {
+        *offloaded = length;
+        mfu_copy_stats.total_bytes_cloned += (int64_t) length;
+    } else {
+        MFU_LOG(MFU_LOG_DBG, "Failed to reflink `%s' to `%s' (errno=%d %s)",
+            src, dest, errno, strerror(errno));
+    }
+#endif
+
+#ifdef SYS_copy_file_range
+    /* copy_file_range may fill holes in the destination with
+     * explicit zeros, so leave sparse files to the buffered path */
+    while (*offloaded < length && ! copy_opts->sparse) {
+        loff_t off_in  = (loff_t)(offset + *offloaded);
+        loff_t off_out = off_in;
+        size_t count   = (size_t)(length - *offloaded);
+        ssize_t n = (ssize_t) syscall(SYS_copy_file_range, mfu_src_file->fd, &off_in,
+            mfu_dst_file->fd, &off_out, count, 0);
+        if (n < 0) {
+            /* these mean the kernel can't offload this pair of files,
+             * let the caller finish through the buffered path */
+            if (errno == EXDEV || errno == EOPNOTSUPP || errno == ENOSYS ||
+                errno == EINVAL || errno == EBADF || errno == EPERM)
+            {
+                MFU_LOG(MFU_LOG_DBG, "Failed to copy_file_range `%s' to `%s' (errno=%d %s)",
+                    src, dest, errno, strerror(errno));
+                break;
+            }
+
+            /* anything else, like EIO or ENOSPC, is a real copy error */
+            MFU_LOG(MFU_LOG_ERR, "Failed to copy_file_range `%s' to `%s' (errno=%d %s)",
+                src, dest, errno, strerror(errno));
+            return -1;
+        }
+
+        /* check for early EOF */
+        if (n == 0) {
+            MFU_LOG(MFU_LOG_ERR, "Source file `%s' shorter than expected %llu",
+                src, (unsigned long long) file_size);
+            return -1;
+        }
+
+        *offloaded += (uint64_t) n;
+        mfu_copy_stats.total_bytes_offloaded += (int64_t) n;
+    }
+#endif
+
+    if (*offloaded == 0) {
+        return 0;
+    }
+
+    /* update number of bytes we have copied for progress messages */
+    copy_count += *offloaded;
+    mfu_progress_update(&copy_count, copy_prog);
+
+    /* Increment the global counter. */
+    mfu_copy_stats.total_size += (int64_t) *offloaded;
+    mfu_copy_stats.total_bytes_copied += (int64_t) *offloaded;
+
+    /* if we copied the last chunk, truncate the file */
+    if (*offloaded == length && (last_chunk || file_size == 0)) {
+        if (mfu_file_ftruncate(mfu_dst_file, (off_t) file_size) < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to truncate destination file: %s (errno=%d %s)",
+                dest, errno, strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* copy a range of the file through our buffers, overlapping reads and
+ * writes if we have more than one buffer, the pipeline is only
+ * implemented for POSIX files */
+static int mfu_copy_file_data(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    if (copy_opts->io_depth > 1 &&
+        mfu_src_file->type == POSIX &&
+        mfu_dst_file->type == POSIX)
+    {
+        return mfu_copy_file_pipeline(src, dest, offset, length, file_size,
+                                      copy_opts, mfu_src_file, mfu_dst_file);
+    }
+    return mfu_copy_file_normal(src, dest, offset, length, file_size,
+                                copy_opts, mfu_src_file, mfu_dst_file);
+}
+
+/* copy the data ranges of a chunk found with lseek(SEEK_DATA/SEEK_HOLE),
+ * holes in the source are left as holes in the destination, which works
+ * on file systems that don't implement FIEMAP, sets normal_copy_required
+ * if the source can't report its data ranges this way */
+static int mfu_copy_file_seek_data(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size,
+    bool* normal_copy_required,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    /* O_DIRECT requires aligned ranges, which holes don't provide */
+    *normal_copy_required = true;
+    if (copy_opts->direct || mfu_src_file->type != POSIX) {
+        return -1;
+    }
+
+    int fd = mfu_src_file->fd;
+    uint64_t last_byte = offset + length;
+    uint64_t holes = 0;
+    uint64_t pos = offset;
+    while (pos < last_byte) {
+        /* find the start of the next data range */
+        off_t data = lseek(fd, (off_t) pos, SEEK_DATA);
+        if (data < 0) {
+            if (errno == ENXIO) {
+                /* nothing but holes from pos to the end of the file */
+                data = (off_t) last_byte;
+            } else if (pos == offset) {
+                /* file system can't tell us, let the caller try another way */
+                return -1;
+            } else {
+                MFU_LOG(MFU_LOG_ERR, "Failed to find data in `%s' (errno=%d %s)",
+                    src, errno, strerror(errno));
+                *normal_copy_required = false;
+                return -1;
+            }
+        }
+        *normal_copy_required = false;
+
+        if ((uint64_t) data > last_byte) {
+            data = (off_t) last_byte;
+        }
+        holes += (uint64_t) data - pos;
+        pos = (uint64_t) data;
+        if (pos >= last_byte) {
+            break;
+        }
+
+        /* find the end of this data range */
+        off_t hole = lseek(fd, data, SEEK_HOLE);
+        if (hole < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to find hole in `%s' (errno=%d %s)",
+                src, errno, strerror(errno));
+            return -1;
+        }
+        if ((uint64_t) hole > last_byte) {
+            hole = (off_t) last_byte;
+        }
+
+        /* copy the data range, this truncates the file if the range ends it */
+        uint64_t data_len = (uint64_t) hole - pos;
+        if (mfu_copy_file_data(src, dest, pos, data_len, file_size,
+                               copy_opts, mfu_src_file, mfu_dst_file) < 0)
+        {
+            return -1;
+        }
+        pos += data_len;
+    }
+    *normal_copy_required = false;
+
+    /* holes count towards the size copied and our progress */
+    mfu_copy_stats.total_size += (int64_t) holes;
+    copy_count += holes;
+    mfu_progress_update(&copy_count, copy_prog);
+
+    /* if this is the last chunk, set the file size, since it may end in a hole */
+    if (last_byte >= file_size) {
+        if (mfu_file_ftruncate(mfu_dst_file, (off_t) file_size) < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to truncate destination file: %s (errno=%d %s)",
+                dest, errno, strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int mfu_copy_file_fiemap(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size,
+    bool* normal_copy_required,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    *normal_copy_required = true;
+    if (copy_opts->direct) {
+        goto fail_normal_copy;
+    }
+
+#ifdef DAOS_SUPPORT
+    /* Not yet supported */
+    if (mfu_src_file->type == DFS) {
+        goto fail_normal_copy;
+    }
+#endif
+
+    size_t last_ext_start = offset;
+    size_t last_ext_len = 0;
+
+    struct fiemap *fiemap = (struct fiemap*)malloc(sizeof(struct fiemap));
+    if (fiemap == NULL) {
+        MFU_LOG(MFU_LOG_ERR, "Out of memory allocating fiemap");
+        goto fail_normal_copy;
+    }
+    memset(fiemap, 0, sizeof(struct fiemap));
+
+    fiemap->fm_start  = offset;
+    fiemap->fm_length = length;
+    fiemap->fm_flags  = FIEMAP_FLAG_SYNC;
+    fiemap->fm_extent_count   = 0;
+    fiemap->fm_mapped_extents = 0;
+
+    struct stat sb;
+    if (fstat(mfu_src_file->fd, &sb) < 0) {
+        goto fail_fiemap;
+    }
+
+    if (ioctl(mfu_src_file->fd, FS_IOC_FIEMAP, fiemap) < 0) {
+        if (errno == ENOTSUP) {
+            /* silently ignore */
+        } else {
+            MFU_LOG(MFU_LOG_ERR, "fiemap ioctl() failed for src '%s' (errno=%d %s)",
+                    src, errno, strerror(errno));
+        }
+        goto fail_fiemap;
+    }
+
+    size_t extents_size = sizeof(struct fiemap_extent) * (fiemap->fm_mapped_extents);
+
+    /* reallocate the fiemap.
+     * If realloc returns NULL, the original fiemap is left malloc'ed */
+    struct fiemap* new_fiemap = (struct fiemap*) realloc(fiemap, sizeof(struct fiemap) + extents_size);
+    if (new_fiemap == NULL) {
+        MFU_LOG(MFU_LOG_ERR, "Out of memory reallocating fiemap");
+        goto fail_fiemap;
+    }
+    fiemap = new_fiemap;
+
+    memset(fiemap->fm_extents, 0, extents_size);
+    fiemap->fm_extent_count   = fiemap->fm_mapped_extents;
+    fiemap->fm_mapped_extents = 0;
+
+    if (ioctl(mfu_src_file->fd, FS_IOC_FIEMAP, fiemap) < 0) {
+        MFU_LOG(MFU_LOG_ERR, "fiemap ioctl() failed for src '%s' (errno=%d %s)",
+                src, errno, strerror(errno));
+        goto fail_fiemap;
+    }
+
+    uint64_t last_byte = offset + length;
+
+    if (fiemap->fm_mapped_extents > 0) {
+        uint64_t fe_logical = fiemap->fm_extents[0].fe_logical;
+        uint64_t fe_length  = fiemap->fm_extents[0].fe_length;
+        if (fe_logical < offset) {
+            fiemap->fm_extents[0].fe_length -= (offset - fe_logical);
+            fiemap->fm_extents[0].fe_logical = offset;
+        }
+
+        fe_logical = fiemap->fm_extents[fiemap->fm_mapped_extents - 1].fe_logical;
+        fe_length  = fiemap->fm_extents[fiemap->fm_mapped_extents - 1].fe_length;
+        if (fe_logical + fe_length > last_byte) {
+           fiemap->fm_extents[fiemap->fm_mapped_extents - 1].fe_length -=
+           fe_logical + fe_length - last_byte;
+        }
+    }
+
+    *normal_copy_required = false;
+
+    /* seek to offset in source file */
+    if (mfu_file_lseek(src, mfu_src_file, (off_t)last_ext_start, SEEK_SET) < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Couldn't seek in source path `%s' (errno=%d %s)",
+            src, errno, strerror(errno));
+        goto fail_fiemap;
+    }
+
+    /* seek to offset in destination file */
+    if (mfu_file_lseek(dest, mfu_dst_file, (off_t)last_ext_start, SEEK_SET) < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Couldn't seek in destination path `%s' (errno=%d %s)",
+            dest, errno, strerror(errno));
+        goto fail_fiemap;
+    }
+
+    unsigned int i;
+    for (i = 0; i < fiemap->fm_mapped_extents; i++) {
+        size_t ext_start;
+        size_t ext_len;
+        size_t ext_hole_size;
+
+        size_t buf_size = copy_opts->buf_size;
+        void* buf = copy_opts->block_buf1;
+
+        ext_start = fiemap->fm_extents[i].fe_logical;
+        ext_len = fiemap->fm_extents[i].fe_length;
+        ext_hole_size = ext_start - (last_ext_start + last_ext_len);
+
+        if (ext_hole_size) {
             if (mfu_file_lseek(src, mfu_src_file, (off_t)ext_start, SEEK_SET) < 0) {
                 MFU_LOG(MFU_LOG_ERR, "Couldn't seek in source path `%s' (errno=%d %s)",
                     src, errno, strerror(errno));
@@ -1920,105 +2560,881 @@ static int mfu_copy_file_fiemap(
             }
         }
 
-        last_ext_start = ext_start;
-        last_ext_len = ext_len;
+        last_ext_start = ext_start;
+        last_ext_len = ext_len;
+
+        while (ext_len) {
+            ssize_t num_read = mfu_file_read(src, buf, MIN(ext_len, buf_size), mfu_src_file);
+
+            if (!num_read)
+                break;
+            ssize_t num_written = mfu_file_write(dest, buf, (size_t)num_read, mfu_dst_file);
+
+            if (num_written < 0) {
+                MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s' (errno=%d %s)",
+                          src, dest, errno, strerror(errno));
+                goto fail_fiemap;
+            }
+            if (num_written != num_read) {
+                MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s'",
+                    src, dest);
+                goto fail_fiemap;
+            }
+
+            ext_len -= (size_t)num_written;
+            mfu_copy_stats.total_bytes_copied += (int64_t) num_written;
+        }
+    }
+
+    off_t last_written = (off_t) last_byte;
+    off_t file_size_offt = (off_t) file_size;
+    if (last_written >= file_size_offt || file_size == 0) {
+        /* Use ftruncate() here rather than truncate(), because grouplock
+         * of Lustre would cause block to truncate() since the fd is different
+         * from the out_fd. */
+        if (mfu_file_ftruncate(mfu_dst_file, file_size_offt) < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to truncate destination file: %s (errno=%d %s)",
+                dest, errno, strerror(errno));
+            goto fail_fiemap;
+       }
+    }
+
+    if (last_written >= file_size_offt) {
+        mfu_copy_stats.total_size += (int64_t) (file_size_offt - (off_t) offset);
+    } else {
+        mfu_copy_stats.total_size += (int64_t) last_byte;
+    }
+
+    free(fiemap);
+    return 0;
+
+fail_fiemap:
+    free(fiemap);
+
+fail_normal_copy:
+    return -1;
+}
+
+static int mfu_copy_file(
+    const char* src,
+    const char* dest,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    int ret;
+
+    /* open the input file */
+    ret = mfu_copy_open_file(src, 1, &mfu_copy_src_cache,
+                             copy_opts, mfu_src_file);
+    if (ret) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open input file `%s' (errno=%d %s)",
+            src, errno, strerror(errno));
+        return -1;
+    }
+
+    /* open the output file */
+    ret = mfu_copy_open_file(dest, 0, &mfu_copy_dst_cache,
+                             copy_opts, mfu_dst_file);
+    if (ret) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open output file `%s' (errno=%d %s)",
+                dest, errno, strerror(errno));
+        return -1;
+    }
+
+    /* try to have the kernel or file system copy the data for us,
+     * then copy whatever it left behind through our buffers */
+    if (copy_opts->offload &&
+        mfu_src_file->type == POSIX &&
+        mfu_dst_file->type == POSIX &&
+        length > 0)
+    {
+        uint64_t offloaded;
+        ret = mfu_copy_file_offload(src, dest, offset, length, file_size,
+                                    &offloaded, copy_opts, mfu_src_file, mfu_dst_file);
+        if (ret || offloaded == length) {
+            return ret;
+        }
+
+        /* after a partial copy_file_range, finish the chunk from
+         * where it stopped, that only happens for non-sparse copies */
+        offset += offloaded;
+        length -= offloaded;
+    }
+
+    if (copy_opts->sparse) {
+        /* copy only the data ranges of the source, and fall back to
+         * FIEMAP if the file system can't report them through lseek */
+        bool normal_copy_required;
+        ret = mfu_copy_file_seek_data(src, dest, offset, length, file_size,
+                               &normal_copy_required, copy_opts,
+                               mfu_src_file, mfu_dst_file);
+        if (normal_copy_required) {
+            ret = mfu_copy_file_fiemap(src, dest, offset, length, file_size,
+                                   &normal_copy_required, copy_opts,
+                                   mfu_src_file, mfu_dst_file);
+        }
+        if (!ret || !normal_copy_required) {
+            return ret;
+        }
+    }
+
+    ret = mfu_copy_file_data(src, dest, offset, length, file_size,
+                             copy_opts, mfu_src_file, mfu_dst_file);
+
+    /* start writing back the chunk now rather than leaving
+     * dirty pages behind until the file is synced on close */
+    if (ret == 0 &&
+        copy_opts->sync_mode == MFU_SYNC_FILE &&
+        mfu_dst_file->type == POSIX)
+    {
+        int sync_rc = sync_file_range(mfu_dst_file->fd, (off64_t) offset,
+                                      (off64_t) length, SYNC_FILE_RANGE_WRITE);
+        if (sync_rc != 0) {
+            MFU_LOG(MFU_LOG_DBG, "Failed to start write back of `%s' (errno=%d %s)",
+                dest, errno, strerror(errno));
+        }
+    }
+
+    return ret;
+}
+
+#ifdef HAVE_LIBURING
+/* operations submitted for a chunk copied through io_uring,
+ * the operation is recorded in the low bits of the request user data
+ * and the index of the job owning the request in the remaining bits */
+enum mfu_uring_op {
+    MFU_URING_OPEN_SRC = 0,
+    MFU_URING_OPEN_DST,
+    MFU_URING_READ,
+    MFU_URING_WRITE,
+    MFU_URING_FSYNC,
+    MFU_URING_CLOSE,
+};
+#define MFU_URING_OP_BITS (3)
+#define MFU_URING_OP_MASK ((1 << MFU_URING_OP_BITS) - 1)
+
+/* tracks the state of one chunk being copied through io_uring */
+typedef struct {
+    const mfu_file_chunk* chunk; /* chunk being copied, NULL if job is idle */
+    uint64_t idx;                /* index of chunk within chunk list */
+    char* dest;                  /* name of destination file */
+    char* buf;                   /* buffer holding data between read and write */
+    int src_fd;                  /* source file descriptor, -1 if not open */
+    int dst_fd;                  /* destination file descriptor, -1 if not open */
+    int pending;                 /* number of submitted requests not yet completed */
+    int error;                   /* set to 1 if any operation on the chunk failed */
+    uint64_t done;               /* number of bytes of the chunk copied so far */
+    size_t nread;                /* number of bytes held in buf from last read */
+    size_t nwrite;               /* number of bytes to be written from buf */
+    size_t nwritten;             /* number of bytes written from buf so far */
+} mfu_uring_job_t;
+
+/* get a submission queue entry for an operation of the given job */
+static struct io_uring_sqe* mfu_uring_get_sqe(
+    struct io_uring* ring,
+    mfu_uring_job_t* jobs,
+    int slot,
+    enum mfu_uring_op op)
+{
+    struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    if (sqe == NULL) {
+        /* submission queue is full, hand what we have to the kernel */
+        io_uring_submit(ring);
+        sqe = io_uring_get_sqe(ring);
+        if (sqe == NULL) {
+            MFU_ABORT(-1, "Failed to get io_uring submission queue entry");
+        }
+    }
+
+    uintptr_t data = ((uintptr_t)slot << MFU_URING_OP_BITS) | (uintptr_t)op;
+    io_uring_sqe_set_data(sqe, (void*)data);
+
+    jobs[slot].pending++;
+
+    return sqe;
+}
+
+/* submit a read of the next block of the chunk */
+static void mfu_uring_read(
+    struct io_uring* ring,
+    mfu_uring_job_t* jobs,
+    int slot,
+    mfu_copy_opts_t* copy_opts)
+{
+    mfu_uring_job_t* job = &jobs[slot];
+    const mfu_file_chunk* chunk = job->chunk;
+
+    /* O_DIRECT requires read operation of certain size blocks,
+     * even if we know that would run past the end of the file */
+    size_t count = copy_opts->buf_size;
+    if (! copy_opts->direct) {
+        uint64_t remainder = chunk->length - job->done;
+        if (remainder < (uint64_t) count) {
+            count = (size_t) remainder;
+        }
+    }
+
+    struct io_uring_sqe* sqe = mfu_uring_get_sqe(ring, jobs, slot, MFU_URING_READ);
+    io_uring_prep_read(sqe, job->src_fd, job->buf, (unsigned) count,
+        (off_t)(chunk->offset + job->done));
+}
+
+/* submit a write of the bytes remaining in the job buffer */
+static void mfu_uring_write(
+    struct io_uring* ring,
+    mfu_uring_job_t* jobs,
+    int slot)
+{
+    mfu_uring_job_t* job = &jobs[slot];
+    const mfu_file_chunk* chunk = job->chunk;
+
+    struct io_uring_sqe* sqe = mfu_uring_get_sqe(ring, jobs, slot, MFU_URING_WRITE);
+    io_uring_prep_write(sqe, job->dst_fd, job->buf + job->nwritten,
+        (unsigned)(job->nwrite - job->nwritten),
+        (off_t)(chunk->offset + job->done + job->nwritten));
+}
+
+/* submit requests to close any file descriptors the job has open,
+ * returns 1 if nothing was left to close */
+static int mfu_uring_close(
+    struct io_uring* ring,
+    mfu_uring_job_t* jobs,
+    int slot)
+{
+    mfu_uring_job_t* job = &jobs[slot];
+    if (job->src_fd >= 0) {
+        struct io_uring_sqe* sqe = mfu_uring_get_sqe(ring, jobs, slot, MFU_URING_CLOSE);
+        io_uring_prep_close(sqe, job->src_fd);
+        job->src_fd = -1;
+    }
+
+    if (job->dst_fd >= 0) {
+        struct io_uring_sqe* sqe = mfu_uring_get_sqe(ring, jobs, slot, MFU_URING_CLOSE);
+        io_uring_prep_close(sqe, job->dst_fd);
+        job->dst_fd = -1;
+    }
+
+    return (job->pending == 0);
+}
+
+/* all data for the chunk has been written, truncate the file if this
+ * was the last chunk, then flush the data to the file system */
+static void mfu_uring_finish(
+    struct io_uring* ring,
+    mfu_uring_job_t* jobs,
+    int slot)
+{
+    mfu_uring_job_t* job = &jobs[slot];
+    const mfu_file_chunk* chunk = job->chunk;
+
+    /* if we wrote the last chunk, truncate the file */
+    off_t last_written = (off_t)(chunk->offset + chunk->length);
+    off_t file_size_offt = (off_t) chunk->file_size;
+    if (last_written >= file_size_offt || chunk->file_size == 0) {
+        if (mfu_ftruncate(job->dst_fd, file_size_offt) < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to truncate destination file: %s (errno=%d %s)",
+                job->dest, errno, strerror(errno));
+            job->error = 1;
+            mfu_uring_close(ring, jobs, slot);
+            return;
+        }
+    }
+
+    struct io_uring_sqe* sqe = mfu_uring_get_sqe(ring, jobs, slot, MFU_URING_FSYNC);
+    io_uring_prep_fsync(sqe, job->dst_fd, 0);
+}
+
+/* the current block has been written (or skipped as a hole),
+ * account for it and move on to the next block of the chunk */
+static void mfu_uring_advance(
+    struct io_uring* ring,
+    mfu_uring_job_t* jobs,
+    int slot,
+    mfu_copy_opts_t* copy_opts)
+{
+    mfu_uring_job_t* job = &jobs[slot];
+
+    job->done += (uint64_t) job->nread;
+
+    /* update number of bytes we have copied for progress messages */
+    copy_count += (uint64_t) job->nread;
+    mfu_progress_update(&copy_count, copy_prog);
+
+    if (job->done < job->chunk->length) {
+        mfu_uring_read(ring, jobs, slot, copy_opts);
+    } else {
+        mfu_uring_finish(ring, jobs, slot);
+    }
+}
+
+/* start copying a chunk by submitting open requests for its
+ * source and destination files */
+static void mfu_uring_start(
+    struct io_uring* ring,
+    mfu_uring_job_t* jobs,
+    int slot,
+    const mfu_file_chunk* chunk,
+    uint64_t idx,
+    char* dest,
+    mfu_copy_opts_t* copy_opts)
+{
+    /* for O_DIRECT, check that length is multiple of buf_size */
+    if (copy_opts->direct &&
+        chunk->offset + chunk->length < chunk->file_size &&
+        chunk->length % copy_opts->buf_size != 0)
+    {
+        MFU_ABORT(-1, "O_DIRECT requires chunk size to be integer multiple of block size %llu",
+            (unsigned long long) copy_opts->buf_size);
+    }
+
+    mfu_uring_job_t* job = &jobs[slot];
+    job->chunk    = chunk;
+    job->idx      = idx;
+    job->dest     = dest;
+    job->src_fd   = -1;
+    job->dst_fd   = -1;
+    job->pending  = 0;
+    job->error    = 0;
+    job->done     = 0;
+    job->nread    = 0;
+    job->nwrite   = 0;
+    job->nwritten = 0;
+
+    int src_flags = O_RDONLY;
+    int dst_flags = O_WRONLY | O_CREAT;
+    if (copy_opts->direct) {
+        src_flags |= O_DIRECT;
+        dst_flags |= O_DIRECT;
+    }
+
+    struct io_uring_sqe* sqe = mfu_uring_get_sqe(ring, jobs, slot, MFU_URING_OPEN_SRC);
+    io_uring_prep_openat(sqe, AT_FDCWD, chunk->name, src_flags, 0);
+
+    sqe = mfu_uring_get_sqe(ring, jobs, slot, MFU_URING_OPEN_DST);
+    io_uring_prep_openat(sqe, AT_FDCWD, dest, dst_flags, DCOPY_DEF_PERMS_FILE);
+}
+
+/* process a completed request, returns 1 if the job owning the
+ * request has finished with its chunk, 0 otherwise */
+static int mfu_uring_complete(
+    struct io_uring* ring,
+    mfu_uring_job_t* jobs,
+    struct io_uring_cqe* cqe,
+    mfu_copy_opts_t* copy_opts)
+{
+    uintptr_t data = (uintptr_t) io_uring_cqe_get_data(cqe);
+    int slot = (int)(data >> MFU_URING_OP_BITS);
+    enum mfu_uring_op op = (enum mfu_uring_op)(data & MFU_URING_OP_MASK);
+    int res = cqe->res;
+
+    mfu_uring_job_t* job = &jobs[slot];
+    const mfu_file_chunk* chunk = job->chunk;
+    job->pending--;
+
+    switch (op) {
+    case MFU_URING_OPEN_SRC:
+    case MFU_URING_OPEN_DST:
+        if (res < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to open %s file `%s' (errno=%d %s)",
+                (op == MFU_URING_OPEN_SRC) ? "input" : "output",
+                (op == MFU_URING_OPEN_SRC) ? chunk->name : job->dest,
+                -res, strerror(-res));
+            job->error = 1;
+        } else if (op == MFU_URING_OPEN_SRC) {
+            job->src_fd = res;
+        } else {
+            job->dst_fd = res;
+        }
+
+        /* wait until both files have been opened */
+        if (job->pending > 0) {
+            return 0;
+        }
+
+        if (job->error) {
+            return mfu_uring_close(ring, jobs, slot);
+        }
+
+        if (chunk->length > 0) {
+            mfu_uring_read(ring, jobs, slot, copy_opts);
+        } else {
+            mfu_uring_finish(ring, jobs, slot);
+        }
+        return 0;
+
+    case MFU_URING_READ:
+        /* If we're using O_DIRECT, deal with short reads.
+         * Retry with same buffer and offset since those must
+         * be aligned at block boundaries. */
+        if (copy_opts->direct &&
+            res > 0 &&
+            (size_t) res < copy_opts->buf_size &&
+            chunk->offset + job->done + (uint64_t) res < chunk->file_size)
+        {
+            mfu_uring_read(ring, jobs, slot, copy_opts);
+            return 0;
+        }
+
+        /* check for an error */
+        if (res < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Read error when copying from `%s' to `%s' (errno=%d %s)",
+                chunk->name, job->dest, -res, strerror(-res));
+            job->error = 1;
+            return mfu_uring_close(ring, jobs, slot);
+        }
+
+        /* check for early EOF */
+        if (res == 0) {
+            MFU_LOG(MFU_LOG_ERR, "Source file `%s' shorter than expected %llu",
+                chunk->name, (unsigned long long) chunk->file_size);
+            job->error = 1;
+            return mfu_uring_close(ring, jobs, slot);
+        }
+
+        /* compute number of bytes to write */
+        job->nread    = (size_t) res;
+        job->nwrite   = (size_t) res;
+        job->nwritten = 0;
+        if (copy_opts->direct) {
+            /* O_DIRECT requires particular write sizes, zero out the
+             * end of the buffer so we don't leave data from another
+             * file behind if we fail before truncating */
+            size_t remainder = copy_opts->buf_size - job->nread;
+            if (remainder > 0) {
+                memset(job->buf + job->nread, 0, remainder);
+            }
+            job->nwrite = copy_opts->buf_size;
+        }
+
+        /* If in sparse mode, skip writing out blocks that are all 0.
+         * Rely on posix hole semantics to account for those 0 values instead. */
+        if (copy_opts->sparse && mfu_is_zero(job->buf, job->nwrite)) {
+            mfu_uring_advance(ring, jobs, slot, copy_opts);
+        } else {
+            mfu_uring_write(ring, jobs, slot);
+        }
+        return 0;
+
+    case MFU_URING_WRITE:
+        /* check for an error */
+        if (res < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s' (errno=%d %s)",
+                chunk->name, job->dest, -res, strerror(-res));
+            job->error = 1;
+            return mfu_uring_close(ring, jobs, slot);
+        }
+
+        /* So long as we're not using O_DIRECT, we can handle short writes
+         * by advancing by the number of bytes written.  For O_DIRECT, we
+         * need to keep buffer, file offset, and amount to write aligned
+         * on block boundaries, so just retry the entire operation. */
+        if (! copy_opts->direct || (size_t) res == job->nwrite - job->nwritten) {
+            job->nwritten += (size_t) res;
+        }
+
+        if (job->nwritten < job->nwrite) {
+            mfu_uring_write(ring, jobs, slot);
+        } else {
+            mfu_uring_advance(ring, jobs, slot, copy_opts);
+        }
+        return 0;
+
+    case MFU_URING_FSYNC:
+        if (res < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to fsync file `%s' (errno=%d %s)",
+                job->dest, -res, strerror(-res));
+            job->error = 1;
+        }
+        return mfu_uring_close(ring, jobs, slot);
+
+    case MFU_URING_CLOSE:
+        if (res < 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to close file when copying from `%s' to `%s' (errno=%d %s)",
+                chunk->name, job->dest, -res, strerror(-res));
+            job->error = 1;
+        }
+        return (job->pending == 0);
+    }
+
+    return 0;
+}
 
-        while (ext_len) {
-            ssize_t num_read = mfu_file_read(src, buf, MIN(ext_len, buf_size), mfu_src_file);
+/* set up a ring to copy with, returns 0 on success, or -1 if the
+ * kernel does not support io_uring or the operations we need */
+static int mfu_uring_init(struct io_uring* ring, int depth)
+{
+    /* each job has at most two requests in flight at once */
+    int rc = io_uring_queue_init((unsigned)(2 * depth), ring, 0);
+    if (rc < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to set up io_uring (errno=%d %s)",
+            -rc, strerror(-rc));
+        return -1;
+    }
 
-            if (!num_read)
-                break;
-            ssize_t num_written = mfu_file_write(dest, buf, (size_t)num_read, mfu_dst_file);
+    /* check that the kernel knows all operations we submit */
+    struct io_uring_probe* probe = io_uring_get_probe_ring(ring);
+    int supported = (probe != NULL &&
+        io_uring_opcode_supported(probe, IORING_OP_OPENAT) &&
+        io_uring_opcode_supported(probe, IORING_OP_READ) &&
+        io_uring_opcode_supported(probe, IORING_OP_WRITE) &&
+        io_uring_opcode_supported(probe, IORING_OP_FSYNC) &&
+        io_uring_opcode_supported(probe, IORING_OP_CLOSE));
+    if (probe != NULL) {
+        io_uring_free_probe(probe);
+    }
 
-            if (num_written < 0) {
-                MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s' (errno=%d %s)",
-                          src, dest, errno, strerror(errno));
-                goto fail_fiemap;
+    if (! supported) {
+        MFU_LOG(MFU_LOG_ERR, "Kernel io_uring does not support open, read, write, fsync, and close");
+        io_uring_queue_exit(ring);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* copy data for each chunk in the list with opens, reads, writes,
+ * fsyncs, and closes batched through io_uring, up to io_depth chunks
+ * are in flight at once, each using one of the io_depth buffers,
+ * records 0 in vals for each chunk copied successfully and 1 otherwise */
+static void mfu_copy_files_uring(
+    struct io_uring* ring,
+    const mfu_file_chunk* head,
+    int* vals,
+    int numpaths,
+    const mfu_param_path* paths,
+    const mfu_param_path* destpath,
+    mfu_copy_opts_t* copy_opts,
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file,
+    uint64_t* total_count)
+{
+    /* one job per buffer, with a single buffer we only have block_buf1 */
+    int depth = copy_opts->io_depth;
+    char** bufs = copy_opts->io_bufs;
+    if (bufs == NULL) {
+        depth = 1;
+        bufs = &copy_opts->block_buf1;
+    }
+
+    mfu_uring_job_t* jobs = (mfu_uring_job_t*) MFU_MALLOC(depth * sizeof(mfu_uring_job_t));
+    int j;
+    for (j = 0; j < depth; j++) {
+        jobs[j].chunk  = NULL;
+        jobs[j].buf    = bufs[j];
+        jobs[j].src_fd = -1;
+        jobs[j].dst_fd = -1;
+    }
+
+    int active = 0;
+    uint64_t i = 0;
+    const mfu_file_chunk* p = head;
+    while (1) {
+        /* hand out remaining chunks to idle jobs */
+        for (j = 0; j < depth && p != NULL; j++) {
+            while (jobs[j].chunk == NULL && p != NULL) {
+                /* assume we'll succeed in copying this chunk */
+                vals[i] = 0;
+
+                /* get name of destination file */
+                char* dest = mfu_param_path_copy_dest(p->name, numpaths,
+                        paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+                if (dest != NULL) {
+                    /* add bytes to our running total */
+                    *total_count += (uint64_t)p->length;
+
+                    mfu_uring_start(ring, jobs, j, p, i, dest, copy_opts);
+                    active++;
+                }
+
+                p = p->next;
+                i++;
             }
-            if (num_written != num_read) {
-                MFU_LOG(MFU_LOG_ERR, "Write error when copying from `%s' to `%s'",
-                    src, dest);
-                goto fail_fiemap;
+        }
+
+        if (active == 0) {
+            break;
+        }
+
+        /* submit all queued requests and wait for at least one to complete */
+        int rc = io_uring_submit_and_wait(ring, 1);
+        if (rc < 0 && rc != -EINTR) {
+            MFU_ABORT(-1, "Failed to submit io_uring requests (errno=%d %s)",
+                -rc, strerror(-rc));
+        }
+
+        /* process every completion that is ready */
+        struct io_uring_cqe* cqe;
+        while (io_uring_peek_cqe(ring, &cqe) == 0) {
+            int slot = (int)((uintptr_t) io_uring_cqe_get_data(cqe) >> MFU_URING_OP_BITS);
+            int finished = mfu_uring_complete(ring, jobs, cqe, copy_opts);
+            io_uring_cqe_seen(ring, cqe);
+
+            if (finished) {
+                mfu_uring_job_t* job = &jobs[slot];
+                if (job->error) {
+                    vals[job->idx] = 1;
+                } else {
+                    /* Increment the global counter. */
+                    mfu_copy_stats.total_size += (int64_t) job->done;
+                    mfu_copy_stats.total_bytes_copied += (int64_t) job->done;
+                }
+
+                mfu_free(&job->dest);
+                job->chunk = NULL;
+                active--;
             }
+        }
+    }
 
-            ext_len -= (size_t)num_written;
-            mfu_copy_stats.total_bytes_copied += (int64_t) num_written;
+    mfu_free(&jobs);
+}
+#endif /* HAVE_LIBURING */
+
+/* state shared with the libcircle callbacks when copying chunks
+ * dynamically, each work item names a piece of a chunk held by some
+ * process, and failures are sent back to that process afterwards */
+static struct {
+    const mfu_file_chunk* head;     /* chunks assigned to this process */
+    int numpaths;                   /* number of source paths */
+    const mfu_param_path* paths;    /* source paths */
+    const mfu_param_path* destpath; /* destination path */
+    mfu_copy_opts_t* copy_opts;     /* options for the copy */
+    mfu_file_t* src;                /* source file handle */
+    mfu_file_t* dst;                /* destination file handle */
+    int* vals;                      /* failure flag for each chunk of this process */
+    uint64_t* failed;               /* (rank, index) pairs of failed chunks held by other processes */
+    uint64_t failed_count;          /* number of pairs in failed */
+    uint64_t failed_max;            /* number of pairs failed has room for */
+    uint64_t bytes;                 /* number of bytes copied by this process */
+} mfu_copy_circle;
+
+/* record that a piece of the chunk at the given index
+ * on the given rank failed to copy */
+static void mfu_copy_circle_fail(int rank, uint64_t idx)
+{
+    int my_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    if (rank == my_rank) {
+        mfu_copy_circle.vals[idx] = 1;
+        return;
+    }
+
+    /* grow the array if needed */
+    if (mfu_copy_circle.failed_count == mfu_copy_circle.failed_max) {
+        uint64_t max = mfu_copy_circle.failed_max * 2 + 16;
+        uint64_t* failed = (uint64_t*) MFU_MALLOC(max * 2 * sizeof(uint64_t));
+        if (mfu_copy_circle.failed_count > 0) {
+            memcpy(failed, mfu_copy_circle.failed,
+                mfu_copy_circle.failed_count * 2 * sizeof(uint64_t));
         }
+        mfu_free(&mfu_copy_circle.failed);
+        mfu_copy_circle.failed = failed;
+        mfu_copy_circle.failed_max = max;
     }
 
-    off_t last_written = (off_t) last_byte;
-    off_t file_size_offt = (off_t) file_size;
-    if (last_written >= file_size_offt || file_size == 0) {
-        /* Use ftruncate() here rather than truncate(), because grouplock
-         * of Lustre would cause block to truncate() since the fd is different
-         * from the out_fd. */
-        if (mfu_file_ftruncate(mfu_dst_file, file_size_offt) < 0) {
-            MFU_LOG(MFU_LOG_ERR, "Failed to truncate destination file: %s (errno=%d %s)",
-                dest, errno, strerror(errno));
-            goto fail_fiemap;
-       }
+    uint64_t n = mfu_copy_circle.failed_count;
+    mfu_copy_circle.failed[2 * n + 0] = (uint64_t) rank;
+    mfu_copy_circle.failed[2 * n + 1] = idx;
+    mfu_copy_circle.failed_count++;
+}
+
+/* copy a piece of a chunk, returns 0 on success and -1 on error */
+static int mfu_copy_circle_piece(
+    const char* name,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t file_size)
+{
+    /* get name of destination file */
+    char* dest = mfu_param_path_copy_dest(name, mfu_copy_circle.numpaths,
+            mfu_copy_circle.paths, mfu_copy_circle.destpath, mfu_copy_circle.copy_opts,
+            mfu_copy_circle.src, mfu_copy_circle.dst);
+    if (dest == NULL) {
+        /* No need to copy it */
+        return 0;
     }
 
-    if (last_written >= file_size_offt) {
-        mfu_copy_stats.total_size += (int64_t) (file_size_offt - (off_t) offset);
-    } else {
-        mfu_copy_stats.total_size += (int64_t) last_byte;
+    /* add bytes to our running total */
+    mfu_copy_circle.bytes += length;
+
+    int rc = mfu_copy_file(name, dest, offset, length, file_size,
+        mfu_copy_circle.copy_opts, mfu_copy_circle.src, mfu_copy_circle.dst);
+
+    mfu_free(&dest);
+
+    return rc;
+}
+
+/* enqueue each of our chunks in pieces of chunk size,
+ * so that idle processes can take them from us */
+static void mfu_copy_circle_create(CIRCLE_handle* handle)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    uint64_t chunk_size = mfu_copy_circle.copy_opts->chunk_size;
+
+    char op[CIRCLE_MAX_STRING_LEN];
+    uint64_t idx = 0;
+    const mfu_file_chunk* p = mfu_copy_circle.head;
+    while (p != NULL) {
+        /* assume we'll succeed in copying this chunk */
+        mfu_copy_circle.vals[idx] = 0;
+
+        /* a 0-size file still needs one piece to be created */
+        uint64_t offset = p->offset;
+        uint64_t end = p->offset + p->length;
+        do {
+            uint64_t length = end - offset;
+            if (length > chunk_size) {
+                length = chunk_size;
+            }
+
+            /* encode rank and index of the chunk to report failures,
+             * the name goes last since it may contain spaces */
+            int len = snprintf(op, sizeof(op), "%d %llu %llu %llu %llu %s",
+                rank, (unsigned long long) idx, (unsigned long long) offset,
+                (unsigned long long) length, (unsigned long long) p->file_size,
+                p->name);
+            if (len > 0 && len < (int) sizeof(op)) {
+                handle->enqueue(op);
+            } else {
+                /* name is too long for a work item, copy it ourselves */
+                if (mfu_copy_circle_piece(p->name, offset, length, p->file_size) < 0) {
+                    mfu_copy_circle.vals[idx] = 1;
+                }
+            }
+
+            offset += length;
+        } while (offset < end);
+
+        idx++;
+        p = p->next;
     }
+}
 
-    free(fiemap);
-    return 0;
+/* copy a piece of a chunk taken from the work queue */
+static void mfu_copy_circle_process(CIRCLE_handle* handle)
+{
+    char op[CIRCLE_MAX_STRING_LEN];
+    handle->dequeue(op);
 
-fail_fiemap:
-    free(fiemap);
+    int rank;
+    unsigned long long idx, offset, length, file_size;
+    int name_pos = 0;
+    int count = sscanf(op, "%d %llu %llu %llu %llu %n",
+        &rank, &idx, &offset, &length, &file_size, &name_pos);
+    if (count != 5 || name_pos == 0) {
+        MFU_LOG(MFU_LOG_ERR, "Invalid copy work item `%s'", op);
+        return;
+    }
+    const char* name = op + name_pos;
 
-fail_normal_copy:
-    return -1;
+    if (mfu_copy_circle_piece(name, (uint64_t) offset, (uint64_t) length, (uint64_t) file_size) < 0) {
+        mfu_copy_circle_fail(rank, (uint64_t) idx);
+    }
 }
 
-static int mfu_copy_file(
-    const char* src,
-    const char* dest,
-    uint64_t offset,
-    uint64_t length,
-    uint64_t file_size,
+/* copy chunks in our list through libcircle so that processes which
+ * run out of work take pieces from those that are still busy,
+ * failures are recorded in vals on the process holding the chunk
+ * so that mfu_file_chunk_list_lor can be applied as usual */
+static void mfu_copy_files_circle(
+    const mfu_file_chunk* head,
+    int* vals,
+    int numpaths,
+    const mfu_param_path* paths,
+    const mfu_param_path* destpath,
     mfu_copy_opts_t* copy_opts,
     mfu_file_t* mfu_src_file,
-    mfu_file_t* mfu_dst_file)
+    mfu_file_t* mfu_dst_file,
+    uint64_t* total_count)
 {
-    int ret;
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
 
-    /* open the input file */
-    ret = mfu_copy_open_file(src, 1, &mfu_copy_src_cache,
-                             copy_opts, mfu_src_file);
-    if (ret) {
-        MFU_LOG(MFU_LOG_ERR, "Failed to open input file `%s' (errno=%d %s)",
-            src, errno, strerror(errno));
-        return -1;
+    /* copy handles into state for libcircle callbacks */
+    mfu_copy_circle.head         = head;
+    mfu_copy_circle.numpaths     = numpaths;
+    mfu_copy_circle.paths        = paths;
+    mfu_copy_circle.destpath     = destpath;
+    mfu_copy_circle.copy_opts    = copy_opts;
+    mfu_copy_circle.src          = mfu_src_file;
+    mfu_copy_circle.dst          = mfu_dst_file;
+    mfu_copy_circle.vals         = vals;
+    mfu_copy_circle.failed       = NULL;
+    mfu_copy_circle.failed_count = 0;
+    mfu_copy_circle.failed_max   = 0;
+    mfu_copy_circle.bytes        = 0;
+
+    /* copy chunks, with every process enqueuing its own */
+    CIRCLE_init(0, NULL, CIRCLE_SPLIT_EQUAL | CIRCLE_CREATE_GLOBAL | CIRCLE_TERM_TREE);
+    CIRCLE_loglevel loglevel = CIRCLE_LOG_WARN;
+    CIRCLE_enable_logging(loglevel);
+    CIRCLE_cb_create(&mfu_copy_circle_create);
+    CIRCLE_cb_process(&mfu_copy_circle_process);
+    CIRCLE_begin();
+    CIRCLE_finalize();
+
+    /* count number of failures to send to each process */
+    int* send_counts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* recv_counts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* send_disps  = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* recv_disps  = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int i;
+    for (i = 0; i < ranks; i++) {
+        send_counts[i] = 0;
+    }
+    uint64_t n;
+    for (n = 0; n < mfu_copy_circle.failed_count; n++) {
+        int dest_rank = (int) mfu_copy_circle.failed[2 * n + 0];
+        send_counts[dest_rank]++;
+    }
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, MPI_COMM_WORLD);
+
+    /* compute displacements */
+    int send_total = 0;
+    int recv_total = 0;
+    for (i = 0; i < ranks; i++) {
+        send_disps[i] = send_total;
+        recv_disps[i] = recv_total;
+        send_total += send_counts[i];
+        recv_total += recv_counts[i];
     }
 
-    /* open the output file */
-    ret = mfu_copy_open_file(dest, 0, &mfu_copy_dst_cache,
-                             copy_opts, mfu_dst_file);
-    if (ret) {
-        MFU_LOG(MFU_LOG_ERR, "Failed to open output file `%s' (errno=%d %s)",
-                dest, errno, strerror(errno));
-        return -1;
+    /* pack chunk indices in order of destination rank */
+    uint64_t* sendbuf = (uint64_t*) MFU_MALLOC((size_t)send_total * sizeof(uint64_t));
+    uint64_t* recvbuf = (uint64_t*) MFU_MALLOC((size_t)recv_total * sizeof(uint64_t));
+    for (i = 0; i < ranks; i++) {
+        send_counts[i] = 0;
+    }
+    for (n = 0; n < mfu_copy_circle.failed_count; n++) {
+        int dest_rank = (int) mfu_copy_circle.failed[2 * n + 0];
+        sendbuf[send_disps[dest_rank] + send_counts[dest_rank]] = mfu_copy_circle.failed[2 * n + 1];
+        send_counts[dest_rank]++;
     }
 
-    if (copy_opts->sparse) {
-        bool normal_copy_required;
-        ret = mfu_copy_file_fiemap(src, dest, offset, length, file_size,
-                               &normal_copy_required, copy_opts,
-                               mfu_src_file, mfu_dst_file);
-        if (!ret || !normal_copy_required) {
-            return ret;
-        }
+    /* send failures back to the processes holding the chunks */
+    MPI_Alltoallv(sendbuf, send_counts, send_disps, MPI_UINT64_T,
+                  recvbuf, recv_counts, recv_disps, MPI_UINT64_T, MPI_COMM_WORLD);
+    for (i = 0; i < recv_total; i++) {
+        vals[recvbuf[i]] = 1;
     }
 
-    ret = mfu_copy_file_normal(src, dest, offset, length, file_size,
-                               copy_opts, mfu_src_file, mfu_dst_file);
+    *total_count = mfu_copy_circle.bytes;
 
-    return ret;
+    mfu_free(&recvbuf);
+    mfu_free(&sendbuf);
+    mfu_free(&recv_disps);
+    mfu_free(&send_disps);
+    mfu_free(&recv_counts);
+    mfu_free(&send_counts);
+    mfu_free(&mfu_copy_circle.failed);
 }
 
 /* slices files in list at boundaries of chunk size, evenly distributes
@@ -2055,6 +3471,27 @@ static int mfu_copy_files(
         }
     }
 
+    /* determine which engine reads and writes file data */
+    int use_uring = 0;
+    if (copy_opts->io_engine == MFU_IO_ENGINE_URING) {
+#ifdef HAVE_LIBURING
+        /* io_uring only applies to POSIX files, and Lustre grouplocks
+         * and copy offload use the descriptors of the blocking engine,
+         * dynamic scheduling hands out pieces one at a time */
+        if (mfu_src_file->type == POSIX &&
+            mfu_dst_file->type == POSIX &&
+            copy_opts->grouplock_id == 0 &&
+            ! copy_opts->offload &&
+            ! copy_opts->dynamic)
+        {
+            use_uring = 1;
+        }
+#endif
+        if (! use_uring && rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "io_uring engine is not available, using posix engine");
+        }
+    }
+
     /* get total for print percent progress while creating */
     copy_total_count = 0;
     MPI_Allreduce(&bytes, &copy_total_count, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
@@ -2077,8 +3514,32 @@ static int mfu_copy_files(
     copy_prog = mfu_progress_start(mfu_progress_timeout, 1, MPI_COMM_WORLD, copy_progress_fn);
 
     /* split file list into a linked list of file sections,
-     * this evenly spreads the file sections across processes */
-    mfu_file_chunk* head = mfu_file_chunk_list_alloc(list, copy_opts->chunk_size);
+     * this evenly spreads the file sections across processes,
+     * for sparse copies, sections that are all holes are left out */
+    mfu_file_chunk* head;
+    if (copy_opts->sparse && mfu_src_file->type == POSIX) {
+        uint64_t holes;
+        head = mfu_file_chunk_list_alloc_data(list, copy_opts->chunk_size, &holes);
+
+        /* count the holes we skipped as copied */
+        mfu_copy_stats.total_size += (int64_t) holes;
+        copy_count += holes;
+    } else {
+        head = mfu_file_chunk_list_alloc(list, copy_opts->chunk_size);
+    }
+
+    /* keep files open across chunks, which may interleave files */
+    mfu_file_cache_init(&mfu_copy_src_cache, copy_opts->open_files);
+    mfu_file_cache_init(&mfu_copy_dst_cache, copy_opts->open_files);
+
+#ifdef HAVE_LIBURING
+    /* fall back to the blocking engine if the kernel can't do it */
+    struct io_uring ring;
+    if (use_uring && mfu_uring_init(&ring, copy_opts->io_depth) != 0) {
+        MFU_LOG(MFU_LOG_WARN, "Falling back to posix engine");
+        use_uring = 0;
+    }
+#endif
 
     /* get a count of how many items are the chunk list */
     uint64_t list_count = mfu_file_chunk_list_size(head);
@@ -2091,7 +3552,24 @@ static int mfu_copy_files(
     /* loop over and copy data for each file section we're responsible for */
     uint64_t i;
     const mfu_file_chunk* p = head;
-    for (i = 0; i < list_count; i++) {
+#ifdef HAVE_LIBURING
+    if (use_uring) {
+        mfu_copy_files_uring(&ring, head, vals, numpaths, paths, destpath,
+            copy_opts, mfu_src_file, mfu_dst_file, &total_count);
+        io_uring_queue_exit(&ring);
+
+        /* skip the blocking copy below */
+        p = NULL;
+    }
+#endif
+    if (copy_opts->dynamic) {
+        mfu_copy_files_circle(head, vals, numpaths, paths, destpath,
+            copy_opts, mfu_src_file, mfu_dst_file, &total_count);
+
+        /* skip the static copy below */
+        p = NULL;
+    }
+    for (i = 0; p != NULL && i < list_count; i++) {
          /* assume we'll succeed in copying this chunk */
          vals[i] = 0;
 
@@ -2218,13 +3696,62 @@ static int mfu_copy_files(
             MFU_LOG(MFU_LOG_INFO, "Copy rate: %.3lf %s (%lu bytes in %.3lf seconds)",
               agg_rate_tmp, agg_rate_units, sum, secs
             );
+            MFU_LOG(MFU_LOG_INFO, "Copy I/O depth: %d buffers of %lu bytes",
+              copy_opts->io_depth, (unsigned long) copy_opts->buf_size
+            );
+            MFU_LOG(MFU_LOG_INFO, "Copy I/O engine: %s",
+              use_uring ? "uring" : "posix"
+            );
+            MFU_LOG(MFU_LOG_INFO, "Copy scheduling: %s",
+              copy_opts->dynamic ? "dynamic" : "static"
+            );
         }
     }
 
     return rc;
 }
 
-static void mfu_sync_all(const char* msg)
+/* flush the file system holding the given path,
+ * falls back to a node-wide sync if we can't get there */
+static void mfu_sync_fs(const char* path)
+{
+    /* nothing to flush if this process wrote nothing */
+    if (path == NULL) {
+        return;
+    }
+
+    /* syncfs needs any open descriptor on the file system,
+     * try the item itself and then its parent directory */
+    int fd = mfu_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        mfu_path* dirpath = mfu_path_from_str(path);
+        mfu_path_dirname(dirpath);
+        char* dir = mfu_path_strdup(dirpath);
+        fd = mfu_open(dir, O_RDONLY | O_CLOEXEC);
+        mfu_free(&dir);
+        mfu_path_delete(&dirpath);
+    }
+
+    if (fd < 0) {
+        MFU_LOG(MFU_LOG_WARN, "Failed to open `%s' to sync its file system, syncing all (errno=%d %s)",
+            path, errno, strerror(errno));
+        sync();
+        return;
+    }
+
+    if (syncfs(fd) != 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to sync file system of `%s' (errno=%d %s)",
+            path, errno, strerror(errno));
+    }
+
+    mfu_close(path, fd);
+}
+
+/* force data written by the copy to disk, path is an item on the
+ * destination file system (or NULL if this process wrote nothing),
+ * data is set when only file contents need to be flushed, which the
+ * file sync mode has already taken care of as each file was closed */
+static void mfu_sync_all(const char* msg, const char* path, int data, mfu_copy_opts_t* copy_opts)
 {
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -2235,7 +3762,20 @@ static void mfu_sync_all(const char* msg)
     if (rank == 0) {
         MFU_LOG(MFU_LOG_INFO, "%s", msg);
     }
-    sync();
+
+    switch (copy_opts->sync_mode) {
+    case MFU_SYNC_NODE:
+        sync();
+        break;
+    case MFU_SYNC_FS:
+        mfu_sync_fs(path);
+        break;
+    case MFU_SYNC_FILE:
+        if (! data) {
+            mfu_sync_fs(path);
+        }
+        break;
+    }
 
     MPI_Barrier(MPI_COMM_WORLD);
     double end = MPI_Wtime();
@@ -2345,6 +3885,38 @@ static void print_summary(mfu_flist flist)
     return;
 }
 
+/* report how the copied bytes were moved, either shared with reflinks,
+ * copied by the kernel with copy_file_range, or through our buffers */
+static void print_offload_summary(void)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* prep our values into buffer */
+    int64_t values[3];
+    values[0] = mfu_copy_stats.total_bytes_cloned;
+    values[1] = mfu_copy_stats.total_bytes_offloaded;
+    values[2] = mfu_copy_stats.total_bytes_copied
+        - mfu_copy_stats.total_bytes_cloned
+        - mfu_copy_stats.total_bytes_offloaded;
+
+    /* sum values across processes */
+    int64_t sums[3];
+    MPI_Allreduce(values, sums, 3, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        const char* names[3] = {"Reflinked", "Offloaded", "Buffered"};
+        int i;
+        for (i = 0; i < 3; i++) {
+            double size_tmp;
+            const char* size_units;
+            mfu_format_bytes((uint64_t)sums[i], &size_tmp, &size_units);
+            MFU_LOG(MFU_LOG_INFO, "  %s: %.3lf %s (%" PRId64 " bytes)",
+                names[i], size_tmp, size_units, sums[i]);
+        }
+    }
+}
+
 int mfu_flist_copy(
     mfu_flist src_cp_list,          /* list of source items to be copied */
     int numpaths,                   /* number of entries in paths array below */
@@ -2377,6 +3949,21 @@ int mfu_flist_copy(
     }
     mfu_flist_print_summary(src_cp_list);
 
+    /* copy data of each inode only once, the other names of files
+     * with multiple links are recreated as hard links after the data
+     * is copied, from here on src_cp_list refers to the unique items */
+    mfu_flist unique_list = MFU_FLIST_NULL;
+    mfu_flist link_list   = MFU_FLIST_NULL;
+    mfu_flist target_list = MFU_FLIST_NULL;
+    if (copy_opts->hardlinks &&
+        mfu_flist_have_detail(src_cp_list) &&
+        mfu_src_file->type == POSIX &&
+        mfu_dst_file->type == POSIX)
+    {
+        mfu_flist_split_hardlinks(src_cp_list, &unique_list, &link_list, &target_list);
+        src_cp_list = unique_list;
+    }
+
     /* TODO: consider file system striping params here */
     /* hard code some configurables for now */
 
@@ -2385,6 +3972,18 @@ int mfu_flist_copy(
     copy_opts->block_buf1 = (char*) MFU_MEMALIGN(copy_opts->buf_size, alignment);
     copy_opts->block_buf2 = (char*) MFU_MEMALIGN(copy_opts->buf_size, alignment);
 
+    /* allocate buffers for the pipelined copy,
+     * the first two are the block buffers allocated above */
+    if (copy_opts->io_depth > 1) {
+        int i;
+        copy_opts->io_bufs = (char**) MFU_MALLOC((size_t)copy_opts->io_depth * sizeof(char*));
+        copy_opts->io_bufs[0] = copy_opts->block_buf1;
+        copy_opts->io_bufs[1] = copy_opts->block_buf2;
+        for (i = 2; i < copy_opts->io_depth; i++) {
+            copy_opts->io_bufs[i] = (char*) MFU_MEMALIGN(copy_opts->buf_size, alignment);
+        }
+    }
+
     /* Grab a relative and actual start time for the epilogue. */
     time(&(mfu_copy_stats.time_started));
     mfu_copy_stats.wtime_started = MPI_Wtime();
@@ -2395,10 +3994,8 @@ int mfu_flist_copy(
     mfu_copy_stats.total_links = 0;
     mfu_copy_stats.total_size  = 0;
     mfu_copy_stats.total_bytes_copied = 0;
-
-    /* Initialize file cache */
-    mfu_copy_src_cache.name = NULL;
-    mfu_copy_dst_cache.name = NULL;
+    mfu_copy_stats.total_bytes_cloned = 0;
+    mfu_copy_stats.total_bytes_offloaded = 0;
 
     /* split items in file list into sublists depending on their
      * directory depth */
@@ -2487,7 +4084,7 @@ int mfu_flist_copy(
 
                 /* force data to backend to avoid the following metadata
                  * setting mismatch, which may happen on lustre */
-                mfu_sync_all("Syncing data to disk.");
+                mfu_sync_all("Syncing data to disk.", destpath->path, 1, copy_opts);
 
                 /* set permissions, ownership, and timestamps if needed */
                 mfu_copy_set_metadata(levels2, minlevel2, lists2, numpaths,
@@ -2500,7 +4097,7 @@ int mfu_flist_copy(
                 mfu_flist_free(&spreadlist);
 
                 /* force updates to disk */
-                mfu_sync_all("Syncing updates to disk.");
+                mfu_sync_all("Syncing updates to disk.", destpath->path, 0, copy_opts);
             }
 
             /* done with our batch list */
@@ -2574,6 +4171,20 @@ int mfu_flist_copy(
                     agg_rate_tmp, agg_rate_units, agg_copied, rel_time);
                 MFU_LOG(MFU_LOG_INFO, "Copied %" PRId64 " of %" PRId64 " items (%.3lf%%)", batch_offset, src_size, (double)batch_offset/(double)src_size*100.0);
             }
+
+            /* break down copied data by how it was moved */
+            if (copy_opts->offload) {
+                print_offload_summary();
+            }
+        }
+
+        /* link remaining names to files copied in the batches above */
+        if (link_list != MFU_FLIST_NULL) {
+            tmp_rc = mfu_copy_hardlinks(link_list, target_list, numpaths,
+                    paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+            if (tmp_rc < 0) {
+                rc = -1;
+            }
         }
 
         /* set permissions, ownership, and timestamps if needed */
@@ -2581,7 +4192,7 @@ int mfu_flist_copy(
                 paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
 
         /* force updates to disk */
-        mfu_sync_all("Syncing directory updates to disk.");
+        mfu_sync_all("Syncing directory updates to disk.", destpath->path, 0, copy_opts);
     } else {
         /* user does not want to batch files, so copy the whole list */
 
@@ -2601,20 +4212,43 @@ int mfu_flist_copy(
 
         /* force data to backend to avoid the following metadata
          * setting mismatch, which may happen on lustre */
-        mfu_sync_all("Syncing data to disk.");
+        mfu_sync_all("Syncing data to disk.", destpath->path, 1, copy_opts);
+
+        /* link remaining names to the files we just copied */
+        if (link_list != MFU_FLIST_NULL) {
+            tmp_rc = mfu_copy_hardlinks(link_list, target_list, numpaths,
+                    paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
+            if (tmp_rc < 0) {
+                rc = -1;
+            }
+        }
 
         /* set permissions, ownership, and timestamps if needed */
         mfu_copy_set_metadata(levels, minlevel, lists, numpaths,
                 paths, destpath, copy_opts, mfu_src_file, mfu_dst_file);
 
         /* force updates to disk */
-        mfu_sync_all("Syncing directory updates to disk.");
+        mfu_sync_all("Syncing directory updates to disk.", destpath->path, 0, copy_opts);
     }
 
     /* free our lists of levels */
     mfu_flist_array_free(levels, &lists);
 
+    /* free lists of hard links */
+    if (unique_list != MFU_FLIST_NULL) {
+        mfu_flist_free(&unique_list);
+        mfu_flist_free(&link_list);
+        mfu_flist_free(&target_list);
+    }
+
     /* free buffers */
+    if (copy_opts->io_bufs != NULL) {
+        int i;
+        for (i = 2; i < copy_opts->io_depth; i++) {
+            mfu_free(&copy_opts->io_bufs[i]);
+        }
+        mfu_free(&copy_opts->io_bufs);
+    }
     mfu_free(&copy_opts->block_buf1);
     mfu_free(&copy_opts->block_buf2);
 
@@ -2690,6 +4324,11 @@ int mfu_flist_copy(
             agg_rate_tmp, agg_rate_units, agg_copied, rel_time);
     }
 
+    /* break down copied data by how it was moved */
+    if (copy_opts->offload) {
+        print_offload_summary();
+    }
+
     /* determine whether any process reported an error,
      * inputs should are either 0 or -1, so min will be -1 on any -1 */
     int all_rc;
@@ -2897,6 +4536,9 @@ int mfu_flist_fill(mfu_flist list, mfu_copy_opts_t* copy_opts, mfu_file_t* mfu_f
      * this evenly spreads the file sections across processes */
     mfu_file_chunk* head = mfu_file_chunk_list_alloc(list, copy_opts->chunk_size);
 
+    /* keep files open across chunks, which may interleave files */
+    mfu_file_cache_init(&mfu_copy_dst_cache, copy_opts->open_files);
+
     /* get a count of how many items are the chunk list */
     uint64_t list_count = mfu_file_chunk_list_size(head);
 
@@ -3004,8 +4646,13 @@ int mfu_flist_fill(mfu_flist list, mfu_copy_opts_t* copy_opts, mfu_file_t* mfu_f
     }
 
     /* force data to backend to avoid the following metadata
-     * setting mismatch, which may happen on lustre */
-     mfu_sync_all("Syncing data to disk.");
+     * setting mismatch, which may happen on lustre,
+     * the file system is identified by the first item we hold */
+    const char* sync_path = NULL;
+    if (mfu_flist_size(list) > 0) {
+        sync_path = mfu_flist_file_get_name(list, 0);
+    }
+    mfu_sync_all("Syncing data to disk.", sync_path, 1, copy_opts);
 
     /* determine whether any process reported an error,
      * inputs should are either 0 or -1, so min will be -1 on any -1 */
@@ -3049,10 +4696,8 @@ int mfu_flist_hardlink(
     mfu_copy_stats.total_links = 0;
     mfu_copy_stats.total_size  = 0;
     mfu_copy_stats.total_bytes_copied = 0;
-
-    /* Initialize file cache */
-    mfu_copy_src_cache.name = NULL;
-    mfu_copy_dst_cache.name = NULL;
+    mfu_copy_stats.total_bytes_cloned = 0;
+    mfu_copy_stats.total_bytes_offloaded = 0;
 
     /* split items in file list into sublists depending on their
      * directory depth */
@@ -3086,7 +4731,7 @@ int mfu_flist_hardlink(
             srcpath, destpath, copy_opts, mfu_src_file, mfu_dst_file);
 
     /* force updates to disk */
-    mfu_sync_all("Syncing directory updates to disk.");
+    mfu_sync_all("Syncing directory updates to disk.", destpath->path, 0, copy_opts);
 
     /* free our lists of levels */
     mfu_flist_array_free(levels, &lists);
@@ -3275,6 +4920,28 @@ mfu_copy_opts_t* mfu_copy_opts_new(void)
     opts->block_buf1 = NULL;
     opts->block_buf2 = NULL;
 
+    /* By default, read and write each buffer in turn */
+    opts->io_depth = MFU_IO_DEPTH;
+    opts->io_bufs  = NULL;
+
+    /* By default, use blocking read and write calls */
+    opts->io_engine = MFU_IO_ENGINE_POSIX;
+
+    /* By default, only flush the destination file system */
+    opts->sync_mode = MFU_SYNC_FS;
+
+    /* By default, each process copies the chunks assigned to it */
+    opts->dynamic = false;
+
+    /* By default, keep a few files open to avoid reopening them */
+    opts->open_files = MFU_OPEN_FILES;
+
+    /* By default, copy all data through our own buffers */
+    opts->offload = false;
+
+    /* By default, copy each name of a hard linked file separately */
+    opts->hardlinks = false;
+
     /* Zero is invalid for the Lustre grouplock ID. */
     opts->grouplock_id = 0;
 
@@ -3284,6 +4951,38 @@ mfu_copy_opts_t* mfu_copy_opts_new(void)
     return opts;
 }
 
+int mfu_io_engine_parse(const char* str, mfu_io_engine* engine)
+{
+    int rc = MFU_SUCCESS;
+
+    if (strcasecmp(str, "posix") == 0) {
+        *engine = MFU_IO_ENGINE_POSIX;
+    } else if (strcasecmp(str, "uring") == 0) {
+        *engine = MFU_IO_ENGINE_URING;
+    } else {
+        rc = MFU_FAILURE;
+    }
+
+    return rc;
+}
+
+int mfu_sync_mode_parse(const char* str, mfu_sync_mode* mode)
+{
+    int rc = MFU_SUCCESS;
+
+    if (strcasecmp(str, "node") == 0) {
+        *mode = MFU_SYNC_NODE;
+    } else if (strcasecmp(str, "fs") == 0) {
+        *mode = MFU_SYNC_FS;
+    } else if (strcasecmp(str, "file") == 0) {
+        *mode = MFU_SYNC_FILE;
+    } else {
+        rc = MFU_FAILURE;
+    }
+
+    return rc;
+}
+
 void mfu_copy_opts_delete(mfu_copy_opts_t** popts)
 {
   if (popts != NULL) {
@@ -3295,6 +4994,7 @@ void mfu_copy_opts_delete(mfu_copy_opts_t** popts)
       mfu_free(&opts->input_file);
       mfu_free(&opts->block_buf1);
       mfu_free(&opts->block_buf2);
+      mfu_free(&opts->io_bufs);
     }
 
     mfu_free(popts);
@@ -30,6 +30,7 @@ typedef struct list_elem {
     int depth;              /* depth within directory tree */
     mfu_filetype type;    /* type of file object */
     int detail;             /* flag to indicate whether we have stat data */
+    unsigned int valid;     /* MFU_STAT bits of stat fields that have been set */
     uint64_t mode;          /* stat mode */
     uint64_t uid;           /* user id */
     uint64_t gid;           /* group id */
@@ -40,12 +41,23 @@ typedef struct list_elem {
     uint64_t ctime;         /* create time */
     uint64_t ctime_nsec;    /* create time nanoseconds */
     uint64_t size;          /* file size in bytes */
+    uint64_t dev;           /* device id of file system holding inode */
+    uint64_t ino;           /* inode number */
+    uint64_t nlink;         /* number of hard links to inode */
     struct list_elem* next; /* pointer to next item */
     /* vars for a non-posix DAOS copy */
     uint64_t obj_id_lo;
     uint64_t obj_id_hi;
 } elem_t;
 
+/* block of memory from which list elements and file names are carved,
+ * the data follows the header */
+typedef struct flist_block {
+    struct flist_block* next; /* previously allocated block */
+    size_t size;              /* number of bytes of data in block */
+    size_t used;              /* number of bytes handed out so far */
+} flist_block_t;
+
 /* holds an array of objects: users, groups, or file data */
 typedef struct {
     void* buf;       /* pointer to memory buffer holding data */
@@ -74,6 +86,7 @@ typedef struct flist {
     elem_t*  list_tail;  /* points to item at tail of list */
     elem_t** list_index; /* an array with pointers to each item in list */
     uint64_t list_cap;   /* current capacity of list_index */
+    flist_block_t* blocks; /* memory for elements and names, newest block first */
 
     /* buffers of users, groups, and files */
     buf_t users;
@@ -110,12 +123,61 @@ void mfu_flist_usrgrp_free(flist_t* flist);
 /* copy user and group structures from srclist to flist */
 void mfu_flist_usrgrp_copy(flist_t* srclist, flist_t* flist);
 
-/* append element to tail of linked list */
+/* allocate an element from memory owned by the list,
+ * it is freed along with the list */
+elem_t* mfu_flist_elem_alloc(flist_t* flist);
+
+/* copy string into memory owned by the list,
+ * it is freed along with the list */
+char* mfu_flist_strdup(flist_t* flist, const char* str);
+
+/* append element to tail of linked list,
+ * element must come from mfu_flist_elem_alloc on the same list */
 void mfu_flist_insert_elem(flist_t* flist, elem_t* elem);
 
+/* remove all elements from list and free their memory,
+ * keeps user and group structures */
+void mfu_flist_clear_elems(flist_t* flist);
+
+/* return number of bytes needed to pack element on its own */
+size_t mfu_flist_elem_pack_size(int detail, const elem_t* elem);
+
+/* pack element into buf, the record holds its own detail flag and
+ * name length, returns number of bytes written */
+size_t mfu_flist_elem_pack(void* buf, int detail, const elem_t* elem);
+
+/* unpack element packed with mfu_flist_elem_pack,
+ * returns number of bytes read */
+size_t mfu_flist_elem_unpack(flist_t* flist, const void* buf, elem_t* elem);
+
+/* write elements from elem to the end of the list to the checkpoint
+ * file name, which is written by the calling process alone, replaces
+ * the file if truncate is set and appends to it otherwise,
+ * returns 0 on success and -1 on error, in which case the file
+ * is left as it was if possible */
+int mfu_flist_write_part(const char* name, int truncate, int detail, const elem_t* elem);
+
+/* append all complete records of checkpoint file name to flist,
+ * returns 0 on success and -1 on error */
+int mfu_flist_read_part(const char* name, flist_t* flist);
+
 /* insert a file given its mode and optional stat data */
 void mfu_flist_insert_stat(flist_t* flist, const char* fpath, mode_t mode, const struct stat* sb);
 
+/* insert a file given its mode and stat data in which only the
+ * fields given by MFU_STAT bits in valid have been set */
+void mfu_flist_insert_stat_valid(flist_t* flist, const char* fpath, mode_t mode,
+                                 const struct stat* sb, unsigned int valid);
+
+/* set in valid of an item if stat'ing it on demand failed, fields
+ * that were missing are then set to (uint64_t)-1 and not retried */
+#define MFU_STAT_FAILED (1 << 8)
+
+/* stat the item to fill in any of the given MFU_STAT fields
+ * that were not collected when the item was inserted, only walks
+ * of POSIX file systems insert items with fields missing */
+void mfu_flist_elem_need(elem_t* elem, unsigned int fields);
+
 /* given path, return level within directory tree,
  * counts '/' characters assuming path is standardized
  * and absolute */
@@ -21,6 +21,7 @@
 #include <grp.h> /* for getgrent */
 #include <errno.h>
 #include <string.h>
+#include <bzlib.h>
 
 #include "dtcmp.h"
 #include "mfu.h"
@@ -188,18 +189,24 @@ static size_t list_elem_encode(void* buf, const elem_t* elem)
 }
 
 /* given a buffer, decode element and store values in elem */
-static void list_elem_decode(char* buf, elem_t* elem)
+static void list_elem_decode(flist_t* flist, char* buf, elem_t* elem)
 {
     /* get name and advance pointer */
     const char* file = strtok(buf, "|");
 
     /* copy path */
-    elem->file = MFU_STRDUP(file);
+    elem->file = mfu_flist_strdup(flist, file);
 
     /* set depth */
     elem->depth = mfu_flist_compute_depth(file);
 
     elem->detail = 0;
+    elem->valid  = 0;
+
+    /* cache files do not record inode identity */
+    elem->dev   = 0;
+    elem->ino   = 0;
+    elem->nlink = 0;
 
     const char* type = strtok(NULL, "|");
     if (type == NULL) {
@@ -272,7 +279,7 @@ static size_t list_elem_pack(void* buf, int detail, uint64_t chars, const elem_t
 }
 
 /* unpack element from buffer and return number of bytes read */
-static size_t list_elem_unpack(const void* buf, int detail, uint64_t chars, elem_t* elem)
+static size_t list_elem_unpack(flist_t* flist, const void* buf, int detail, uint64_t chars, elem_t* elem)
 {
     const char* start = (const char*) buf;
     const char* ptr = start;
@@ -282,12 +289,18 @@ static size_t list_elem_unpack(const void* buf, int detail, uint64_t chars, elem
     ptr += chars;
 
     /* copy path */
-    elem->file = MFU_STRDUP(file);
+    elem->file = mfu_flist_strdup(flist, file);
 
     /* set depth */
     elem->depth = mfu_flist_compute_depth(file);
 
     elem->detail = detail;
+    elem->valid  = detail ? MFU_STAT_ALL : 0;
+
+    /* cache files do not record inode identity */
+    elem->dev   = 0;
+    elem->ino   = 0;
+    elem->nlink = 0;
 
     if (detail) {
         /* extract fields */
@@ -317,10 +330,10 @@ static size_t list_elem_unpack(const void* buf, int detail, uint64_t chars, elem
 static void list_insert_decode(flist_t* flist, char* buf)
 {
     /* create new element to record file path, file type, and stat info */
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    elem_t* elem = mfu_flist_elem_alloc(flist);
 
     /* decode buffer and store values in element */
-    list_elem_decode(buf, elem);
+    list_elem_decode(flist, buf, elem);
 
     /* append element to tail of linked list */
     mfu_flist_insert_elem(flist, elem);
@@ -332,10 +345,10 @@ static void list_insert_decode(flist_t* flist, char* buf)
 static size_t list_insert_ptr(flist_t* flist, char* ptr, int detail, uint64_t chars)
 {
     /* create new element to record file path, file type, and stat info */
-    elem_t* elem = (elem_t*) MFU_MALLOC(sizeof(elem_t));
+    elem_t* elem = mfu_flist_elem_alloc(flist);
 
     /* get name and advance pointer */
-    size_t bytes = list_elem_unpack(ptr, detail, chars, elem);
+    size_t bytes = list_elem_unpack(flist, ptr, detail, chars, elem);
 
     /* append element to tail of linked list */
     mfu_flist_insert_elem(flist, elem);
@@ -343,6 +356,567 @@ static size_t list_insert_ptr(flist_t* flist, char* ptr, int detail, uint64_t ch
     return bytes;
 }
 
+/****************************************
+ * Reading a cache in batches
+ ***************************************/
+
+/* describes where to hand off items when a cache is read in batches */
+typedef struct {
+    uint64_t size;          /* max number of items in a batch */
+    mfu_flist_batch_fn fn;  /* function to call on each batch */
+    void* arg;              /* argument to pass to function */
+    uint64_t count;         /* number of items handed off so far */
+} cache_batch_t;
+
+/* when reading in batches, pass items in list to the batch function
+ * once the list holds a full batch, or holds any items if flush is set,
+ * and then remove them from the list, does nothing if batch is NULL */
+static void cache_batch_check(flist_t* flist, cache_batch_t* batch, int flush)
+{
+    if (batch == NULL) {
+        return;
+    }
+
+    uint64_t count = flist->list_count;
+    if (count >= batch->size || (flush && count > 0)) {
+        batch->fn((mfu_flist) flist, batch->arg);
+        batch->count += count;
+        mfu_flist_clear_elems(flist);
+    }
+}
+
+/****************************************
+ * Blocks of a version 5 cache file
+ ***************************************/
+
+/* Version 5 files store items in blocks.  Within a block each item is
+ * encoded as
+ *
+ *   varint number of leading chars shared with previous name in block
+ *   varint number of remaining chars
+ *   remaining chars of name (no terminating NUL)
+ *   if detail: varint mode, uid, gid, atime, atime_nsec, mtime,
+ *              mtime_nsec, ctime, ctime_nsec, size
+ *   else:      varint type
+ *
+ * A varint stores 7 bits of a value per byte, low bits first, with the
+ * high bit set on each byte but the last.  A block may be stored as is
+ * or compressed, and an index at the end of the file records where
+ * each block starts, so that processes can locate and decode disjoint
+ * sets of blocks in parallel. */
+
+/* close a block once it holds this many items */
+#define CACHE_BLOCK_ITEMS (4096)
+
+/* close a block once its encoded items take this many bytes */
+#define CACHE_BLOCK_BYTES (1024 * 1024)
+
+/* how a block is stored */
+#define CACHE_CODEC_NONE (0)
+#define CACHE_CODEC_BZ2  (1)
+
+/* each index entry records offset of block in file, bytes stored,
+ * bytes after decompression, number of items, and codec as uint64_t */
+#define CACHE_INDEX_ENTRY_SIZE (5 * 8)
+
+/* max bytes needed to encode a uint64_t as a varint */
+#define VARINT_MAX (10)
+
+static void mfu_pack_varint(char** pptr, uint64_t value)
+{
+    unsigned char* ptr = *(unsigned char**)pptr;
+    while (value >= 0x80) {
+        *ptr = (unsigned char)(value | 0x80);
+        ptr++;
+        value >>= 7;
+    }
+    *ptr = (unsigned char)value;
+    ptr++;
+    *pptr = (char*)ptr;
+}
+
+/* decode a varint that ends before end,
+ * returns 0 on success and -1 if the encoding is invalid */
+static int mfu_unpack_varint(const char** pptr, const char* end, uint64_t* value)
+{
+    const unsigned char* ptr = *(const unsigned char**)pptr;
+    uint64_t val = 0;
+    int shift = 0;
+    while (ptr < (const unsigned char*)end && shift < 64) {
+        unsigned char c = *ptr;
+        ptr++;
+        val |= (uint64_t)(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            *value = val;
+            *pptr  = (const char*)ptr;
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+/* return max number of bytes needed to encode an item
+ * whose name has up to chars characters */
+static size_t cache_block_elem_max(uint64_t chars)
+{
+    return (size_t)chars + 12 * VARINT_MAX;
+}
+
+/* encode name relative to name of previous element in block */
+static void cache_block_encode_name(char** pptr, const char* prev, const char* file)
+{
+    /* count leading chars shared with the previous name */
+    size_t prefix = 0;
+    while (prev[prefix] != '\0' && prev[prefix] == file[prefix]) {
+        prefix++;
+    }
+    size_t suffix = strlen(file + prefix);
+
+    mfu_pack_varint(pptr, (uint64_t)prefix);
+    mfu_pack_varint(pptr, (uint64_t)suffix);
+    memcpy(*pptr, file + prefix, suffix);
+    *pptr += suffix;
+}
+
+/* rebuild name in path from chars shared with previous name, which
+ * path still holds, and chars recorded for this item, path has room
+ * for path_size bytes, returns 0 on success and -1 if invalid */
+static int cache_block_decode_name(
+    const char** pptr,
+    const char* end,
+    int first,
+    char* path,
+    size_t path_size)
+{
+    uint64_t prefix, suffix;
+    if (mfu_unpack_varint(pptr, end, &prefix) != 0 ||
+        mfu_unpack_varint(pptr, end, &suffix) != 0)
+    {
+        return -1;
+    }
+    if ((first && prefix != 0) ||
+        prefix + suffix + 1 > (uint64_t)path_size ||
+        suffix > (uint64_t)(end - *pptr))
+    {
+        return -1;
+    }
+    memcpy(path + prefix, *pptr, (size_t)suffix);
+    path[prefix + suffix] = '\0';
+    *pptr += suffix;
+    return 0;
+}
+
+/* encode element into buffer given name of previous element in
+ * block, returns number of bytes written */
+static size_t cache_block_encode_elem(
+    char* buf,
+    const char* prev,
+    int detail,
+    const elem_t* elem)
+{
+    char* ptr = buf;
+
+    cache_block_encode_name(&ptr, prev, elem->file);
+
+    if (detail) {
+        mfu_pack_varint(&ptr, elem->mode);
+        mfu_pack_varint(&ptr, elem->uid);
+        mfu_pack_varint(&ptr, elem->gid);
+        mfu_pack_varint(&ptr, elem->atime);
+        mfu_pack_varint(&ptr, elem->atime_nsec);
+        mfu_pack_varint(&ptr, elem->mtime);
+        mfu_pack_varint(&ptr, elem->mtime_nsec);
+        mfu_pack_varint(&ptr, elem->ctime);
+        mfu_pack_varint(&ptr, elem->ctime_nsec);
+        mfu_pack_varint(&ptr, elem->size);
+    }
+    else {
+        mfu_pack_varint(&ptr, (uint64_t)elem->type);
+    }
+
+    return (size_t)(ptr - buf);
+}
+
+/* decode items of a block and append them to the list, path is a
+ * buffer of path_size bytes to reconstruct names in, items are handed
+ * off as they are decoded if batch is not NULL,
+ * returns 0 on success and -1 if the block is invalid */
+static int cache_block_decode(
+    flist_t* flist,
+    cache_batch_t* batch,
+    const char* buf,
+    size_t size,
+    uint64_t items,
+    int detail,
+    char* path,
+    size_t path_size)
+{
+    const char* ptr = buf;
+    const char* end = buf + size;
+
+    uint64_t i;
+    for (i = 0; i < items; i++) {
+        /* rebuild name from shared chars of previous name and
+         * chars recorded for this item */
+        if (cache_block_decode_name(&ptr, end, (i == 0), path, path_size) != 0) {
+            return -1;
+        }
+
+        /* create new element to record file path, file type, and stat info */
+        elem_t* elem = mfu_flist_elem_alloc(flist);
+
+        elem->file   = mfu_flist_strdup(flist, path);
+        elem->depth  = mfu_flist_compute_depth(path);
+        elem->detail = detail;
+        elem->valid  = detail ? MFU_STAT_ALL : 0;
+
+        /* cache files do not record inode identity */
+        elem->dev   = 0;
+        elem->ino   = 0;
+        elem->nlink = 0;
+
+        int rc = 0;
+        if (detail) {
+            rc |= mfu_unpack_varint(&ptr, end, &elem->mode);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->uid);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->gid);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->atime);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->atime_nsec);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->mtime);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->mtime_nsec);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->ctime);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->ctime_nsec);
+            rc |= mfu_unpack_varint(&ptr, end, &elem->size);
+
+            /* use mode to set file type */
+            elem->type = mfu_flist_mode_to_filetype((mode_t)elem->mode);
+        }
+        else {
+            uint64_t type;
+            rc |= mfu_unpack_varint(&ptr, end, &type);
+            elem->type = (mfu_filetype)type;
+        }
+
+        /* append element to tail of linked list */
+        mfu_flist_insert_elem(flist, elem);
+
+        if (rc != 0) {
+            return -1;
+        }
+
+        /* hand off full batch */
+        cache_batch_check(flist, batch, 0);
+    }
+
+    /* every byte of the block should be used */
+    if (ptr != end) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/****************************************
+ * Columnar blocks of a version 6 cache file
+ ***************************************/
+
+/* Version 6 files lay out the items of a block by field rather than
+ * by item, so a reader can decode the fields a filter tests without
+ * the rest.  A decoded block starts with the byte length of each
+ * column as a varint, followed by the columns in this order:
+ *
+ *   names, encoded as in version 5
+ *   varint mode, uid, gid, atime, atime_nsec, mtime, mtime_nsec,
+ *   ctime, ctime_nsec, size of each item
+ *
+ * The index entry of each block adds the min and max of size, mtime,
+ * uid, gid, and depth over its items, so readers can skip blocks in
+ * which no item can match a filter. */
+
+/* columns of a version 6 block */
+enum cache_column {
+    CACHE_COL_NAME = 0,
+    CACHE_COL_MODE,
+    CACHE_COL_UID,
+    CACHE_COL_GID,
+    CACHE_COL_ATIME,
+    CACHE_COL_ATIME_NSEC,
+    CACHE_COL_MTIME,
+    CACHE_COL_MTIME_NSEC,
+    CACHE_COL_CTIME,
+    CACHE_COL_CTIME_NSEC,
+    CACHE_COL_SIZE,
+    CACHE_COLUMNS
+};
+
+/* each index entry records the fields of a version 5 entry followed
+ * by min and max of size, mtime, uid, gid, and depth as uint64_t */
+#define CACHE_ZONE_INDEX_ENTRY_SIZE (15 * 8)
+
+/* return max number of bytes needed to encode a numeric column */
+static size_t cache_column_max(uint64_t items)
+{
+    return (size_t)items * VARINT_MAX;
+}
+
+/* append element to the columns of a block given name of previous
+ * element in block, cols points to the next byte of each column */
+static void cache_columns_encode_elem(
+    char** cols,
+    const char* prev,
+    const elem_t* elem)
+{
+    cache_block_encode_name(&cols[CACHE_COL_NAME], prev, elem->file);
+    mfu_pack_varint(&cols[CACHE_COL_MODE],       elem->mode);
+    mfu_pack_varint(&cols[CACHE_COL_UID],        elem->uid);
+    mfu_pack_varint(&cols[CACHE_COL_GID],        elem->gid);
+    mfu_pack_varint(&cols[CACHE_COL_ATIME],      elem->atime);
+    mfu_pack_varint(&cols[CACHE_COL_ATIME_NSEC], elem->atime_nsec);
+    mfu_pack_varint(&cols[CACHE_COL_MTIME],      elem->mtime);
+    mfu_pack_varint(&cols[CACHE_COL_MTIME_NSEC], elem->mtime_nsec);
+    mfu_pack_varint(&cols[CACHE_COL_CTIME],      elem->ctime);
+    mfu_pack_varint(&cols[CACHE_COL_CTIME_NSEC], elem->ctime_nsec);
+    mfu_pack_varint(&cols[CACHE_COL_SIZE],       elem->size);
+}
+
+/* widen the ranges of zone to include element,
+ * the zone is reset to the element if first is set */
+static void cache_zone_add(mfu_pred_zone* zone, int first, const elem_t* elem)
+{
+    uint64_t depth = (uint64_t) elem->depth;
+    if (first) {
+        zone->min_size  = zone->max_size  = elem->size;
+        zone->min_mtime = zone->max_mtime = elem->mtime;
+        zone->min_uid   = zone->max_uid   = elem->uid;
+        zone->min_gid   = zone->max_gid   = elem->gid;
+        zone->min_depth = zone->max_depth = depth;
+        return;
+    }
+
+    if (elem->size  < zone->min_size)  { zone->min_size  = elem->size;  }
+    if (elem->size  > zone->max_size)  { zone->max_size  = elem->size;  }
+    if (elem->mtime < zone->min_mtime) { zone->min_mtime = elem->mtime; }
+    if (elem->mtime > zone->max_mtime) { zone->max_mtime = elem->mtime; }
+    if (elem->uid   < zone->min_uid)   { zone->min_uid   = elem->uid;   }
+    if (elem->uid   > zone->max_uid)   { zone->max_uid   = elem->uid;   }
+    if (elem->gid   < zone->min_gid)   { zone->min_gid   = elem->gid;   }
+    if (elem->gid   > zone->max_gid)   { zone->max_gid   = elem->gid;   }
+    if (depth       < zone->min_depth) { zone->min_depth = depth;       }
+    if (depth       > zone->max_depth) { zone->max_depth = depth;       }
+}
+
+/* encode items from *pcurrent into a block in buf until the block
+ * is full, using col_bufs to build each column, sets zone to the
+ * ranges covered by the block, advances *pcurrent past the items,
+ * and returns number of bytes written */
+static size_t cache_columns_encode_block(
+    char* buf,
+    char** col_bufs,
+    const elem_t** pcurrent,
+    mfu_pred_zone* zone,
+    uint64_t* pitems)
+{
+    char* cols[CACHE_COLUMNS];
+    int c;
+    for (c = 0; c < CACHE_COLUMNS; c++) {
+        cols[c] = col_bufs[c];
+    }
+
+    /* encode items until block is full */
+    const elem_t* current = *pcurrent;
+    const char* prev = "";
+    uint64_t items = 0;
+    size_t bytes = 0;
+    while (current != NULL && items < CACHE_BLOCK_ITEMS && bytes < CACHE_BLOCK_BYTES) {
+        cache_columns_encode_elem(cols, prev, current);
+        cache_zone_add(zone, (items == 0), current);
+        prev = current->file;
+        current = current->next;
+        items++;
+
+        bytes = 0;
+        for (c = 0; c < CACHE_COLUMNS; c++) {
+            bytes += (size_t)(cols[c] - col_bufs[c]);
+        }
+    }
+
+    /* write length of each column followed by the columns */
+    char* ptr = buf;
+    for (c = 0; c < CACHE_COLUMNS; c++) {
+        mfu_pack_varint(&ptr, (uint64_t)(cols[c] - col_bufs[c]));
+    }
+    for (c = 0; c < CACHE_COLUMNS; c++) {
+        size_t len = (size_t)(cols[c] - col_bufs[c]);
+        memcpy(ptr, col_bufs[c], len);
+        ptr += len;
+    }
+
+    *pcurrent = current;
+    *pitems = items;
+    return (size_t)(ptr - buf);
+}
+
+/* decode items values of a numeric column into vals,
+ * returns 0 on success and -1 if the column is invalid */
+static int cache_column_decode(
+    const char* start,
+    const char* end,
+    uint64_t items,
+    uint64_t* vals)
+{
+    const char* ptr = start;
+    uint64_t i;
+    for (i = 0; i < items; i++) {
+        if (mfu_unpack_varint(&ptr, end, &vals[i]) != 0) {
+            return -1;
+        }
+    }
+    return (ptr == end) ? 0 : -1;
+}
+
+/* decode items of a columnar block and append them to the list,
+ * if pred is not NULL, only items that may satisfy it are added and
+ * the name and other fields are only decoded if some item may,
+ * vals has room for CACHE_COLUMNS * items values and keep for items
+ * flags, path is a buffer of path_size bytes to reconstruct names in,
+ * items are handed off as they are decoded if batch is not NULL,
+ * returns 0 on success and -1 if the block is invalid */
+static int cache_columns_decode(
+    flist_t* flist,
+    cache_batch_t* batch,
+    const mfu_pred* pred,
+    const char* buf,
+    size_t size,
+    uint64_t items,
+    uint64_t* vals,
+    char* keep,
+    char* path,
+    size_t path_size)
+{
+    const char* ptr = buf;
+    const char* end = buf + size;
+
+    /* locate start and end of each column */
+    const char* start[CACHE_COLUMNS];
+    const char* stop[CACHE_COLUMNS];
+    uint64_t lens[CACHE_COLUMNS];
+    int c;
+    for (c = 0; c < CACHE_COLUMNS; c++) {
+        if (mfu_unpack_varint(&ptr, end, &lens[c]) != 0) {
+            return -1;
+        }
+    }
+    for (c = 0; c < CACHE_COLUMNS; c++) {
+        if (lens[c] > (uint64_t)(end - ptr)) {
+            return -1;
+        }
+        start[c] = ptr;
+        ptr += lens[c];
+        stop[c] = ptr;
+    }
+    if (ptr != end) {
+        return -1;
+    }
+
+    /* values of column c for item i are at vals[c * items + i] */
+    int decoded[CACHE_COLUMNS] = {0};
+    uint64_t i;
+    uint64_t kept = items;
+    if (pred != NULL) {
+        /* decode the columns a zone covers and test each item alone */
+        int zone_cols[4] = {CACHE_COL_SIZE, CACHE_COL_MTIME, CACHE_COL_UID, CACHE_COL_GID};
+        for (c = 0; c < 4; c++) {
+            int col = zone_cols[c];
+            if (cache_column_decode(start[col], stop[col], items, &vals[col * items]) != 0) {
+                return -1;
+            }
+            decoded[col] = 1;
+        }
+
+        kept = 0;
+        for (i = 0; i < items; i++) {
+            mfu_pred_zone zone;
+            zone.min_size  = zone.max_size  = vals[CACHE_COL_SIZE  * items + i];
+            zone.min_mtime = zone.max_mtime = vals[CACHE_COL_MTIME * items + i];
+            zone.min_uid   = zone.max_uid   = vals[CACHE_COL_UID   * items + i];
+            zone.min_gid   = zone.max_gid   = vals[CACHE_COL_GID   * items + i];
+            zone.min_depth = 0;
+            zone.max_depth = UINT64_MAX;
+            keep[i] = (char) mfu_pred_zone_may_match(pred, &zone);
+            if (keep[i]) {
+                kept++;
+            }
+        }
+
+        /* nothing else to decode if no item may match */
+        if (kept == 0) {
+            return 0;
+        }
+    } else {
+        memset(keep, 1, (size_t)items);
+    }
+
+    /* decode remaining numeric columns */
+    for (c = CACHE_COL_MODE; c < CACHE_COLUMNS; c++) {
+        if (!decoded[c]) {
+            if (cache_column_decode(start[c], stop[c], items, &vals[c * items]) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    /* names are front coded, so every name has to be rebuilt in turn */
+    const char* name_ptr = start[CACHE_COL_NAME];
+    for (i = 0; i < items; i++) {
+        if (cache_block_decode_name(&name_ptr, stop[CACHE_COL_NAME], (i == 0), path, path_size) != 0) {
+            return -1;
+        }
+        if (!keep[i]) {
+            continue;
+        }
+
+        /* create new element to record file path, file type, and stat info */
+        elem_t* elem = mfu_flist_elem_alloc(flist);
+
+        elem->file   = mfu_flist_strdup(flist, path);
+        elem->depth  = mfu_flist_compute_depth(path);
+        elem->detail = 1;
+        elem->valid  = MFU_STAT_ALL;
+
+        /* cache files do not record inode identity */
+        elem->dev   = 0;
+        elem->ino   = 0;
+        elem->nlink = 0;
+
+        elem->mode       = vals[CACHE_COL_MODE       * items + i];
+        elem->uid        = vals[CACHE_COL_UID        * items + i];
+        elem->gid        = vals[CACHE_COL_GID        * items + i];
+        elem->atime      = vals[CACHE_COL_ATIME      * items + i];
+        elem->atime_nsec = vals[CACHE_COL_ATIME_NSEC * items + i];
+        elem->mtime      = vals[CACHE_COL_MTIME      * items + i];
+        elem->mtime_nsec = vals[CACHE_COL_MTIME_NSEC * items + i];
+        elem->ctime      = vals[CACHE_COL_CTIME      * items + i];
+        elem->ctime_nsec = vals[CACHE_COL_CTIME_NSEC * items + i];
+        elem->size       = vals[CACHE_COL_SIZE       * items + i];
+
+        /* use mode to set file type */
+        elem->type = mfu_flist_mode_to_filetype((mode_t)elem->mode);
+
+        /* append element to tail of linked list */
+        mfu_flist_insert_elem(flist, elem);
+
+        /* hand off full batch */
+        cache_batch_check(flist, batch, 0);
+    }
+
+    if (name_ptr != stop[CACHE_COL_NAME]) {
+        return -1;
+    }
+
+    return 0;
+}
+
 /****************************************
  * Read file list from file
  ***************************************/
@@ -827,6 +1401,61 @@ static void read_cache_v3(
     return;
 }
 
+/* read list of user or group names and ids starting at disp,
+ * and advance disp past the list */
+static void read_cache_usrgrp(
+    const char* name,
+    MPI_Offset* pdisp,
+    MPI_File fh,
+    const char* datarep,
+    buf_t* items)
+{
+    MPI_Status status;
+
+    /* get our rank */
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* nothing to do if there are no items */
+    if (items->count == 0 || items->chars == 0) {
+        return;
+    }
+
+    /* create type */
+    mfu_flist_usrgrp_create_stridtype((int)items->chars, &(items->dt));
+
+    /* get extent */
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(items->dt, &lb, &extent);
+
+    /* allocate memory to hold data */
+    size_t bufsize = items->count * (size_t)extent;
+    items->buf = (void*) MFU_MALLOC(bufsize);
+    items->bufsize = bufsize;
+
+    /* set view to read data */
+    int mpirc = MPI_File_set_view(fh, *pdisp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* read data */
+    int pack_size = (int) buft_pack_size(items);
+    if (rank == 0) {
+        char* pack_buf = (char*) MFU_MALLOC(pack_size);
+        mpirc = MPI_File_read_at(fh, 0, pack_buf, pack_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+        buft_unpack(pack_buf, items);
+        mfu_free(&pack_buf);
+    }
+    MPI_Bcast(items->buf, (int)items->count, items->dt, 0, MPI_COMM_WORLD);
+    *pdisp += (MPI_Offset) pack_size;
+}
+
 /* file format:
  * all integer values stored in network byte order
  *
@@ -846,7 +1475,8 @@ static void read_cache_v4(
     MPI_Offset* outdisp,
     MPI_File fh,
     const char* datarep,
-    flist_t* flist)
+    flist_t* flist,
+    cache_batch_t* batch)
 {
     MPI_Status status;
 
@@ -914,79 +1544,13 @@ static void read_cache_v4(
         offset = 0;
     }
 
-    /* read users, if any */
-    if (users->count > 0 && users->chars > 0) {
-        /* create type */
-        mfu_flist_usrgrp_create_stridtype((int)users->chars,  &(users->dt));
-
-        /* get extent */
-        MPI_Aint lb_user, extent_user;
-        MPI_Type_get_extent(users->dt, &lb_user, &extent_user);
-
-        /* allocate memory to hold data */
-        size_t bufsize_user = users->count * (size_t)extent_user;
-        users->buf = (void*) MFU_MALLOC(bufsize_user);
-        users->bufsize = bufsize_user;
-
-        /* set view to read data */
-        mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
-        if (mpirc != MPI_SUCCESS) {
-            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
-            MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
-        }
-
-        /* read data */
-        int user_buf_size = (int) buft_pack_size(users);
-        if (rank == 0) {
-            char* user_buf = (char*) MFU_MALLOC(user_buf_size);
-            mpirc = MPI_File_read_at(fh, 0, user_buf, user_buf_size, MPI_BYTE, &status);
-            if (mpirc != MPI_SUCCESS) {
-                MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
-                MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
-            }
-            buft_unpack(user_buf, users);
-            mfu_free(&user_buf);
-        }
-        MPI_Bcast(users->buf, (int)users->count, users->dt, 0, MPI_COMM_WORLD);
-        disp += (MPI_Offset) user_buf_size;
-    }
-
-    /* read groups, if any */
-    if (groups->count > 0 && groups->chars > 0) {
-        /* create type */
-        mfu_flist_usrgrp_create_stridtype((int)groups->chars, &(groups->dt));
-
-        /* get extent */
-        MPI_Aint lb_group, extent_group;
-        MPI_Type_get_extent(groups->dt, &lb_group, &extent_group);
-
-        /* allocate memory to hold data */
-        size_t bufsize_group = groups->count * (size_t)extent_group;
-        groups->buf = (void*) MFU_MALLOC(bufsize_group);
-        groups->bufsize = bufsize_group;
-
-        /* set view to read data */
-        mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
-        if (mpirc != MPI_SUCCESS) {
-            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
-            MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
-        }
+    /* read users and groups */
+    read_cache_usrgrp(name, &disp, fh, datarep, users);
+    read_cache_usrgrp(name, &disp, fh, datarep, groups);
 
-        /* read data */
-        int group_buf_size = (int) buft_pack_size(groups);
-        if (rank == 0) {
-            char* group_buf = (char*) MFU_MALLOC(group_buf_size);
-            mpirc = MPI_File_read_at(fh, 0, group_buf, group_buf_size, MPI_BYTE, &status);
-            if (mpirc != MPI_SUCCESS) {
-                MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
-                MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
-            }
-            buft_unpack(group_buf, groups);
-            mfu_free(&group_buf);
-        }
-        MPI_Bcast(groups->buf, (int)groups->count, groups->dt, 0, MPI_COMM_WORLD);
-        disp += (MPI_Offset) group_buf_size;
-    }
+    /* create maps of users and groups */
+    mfu_flist_usrgrp_create_map(&flist->users, flist->user_id2name);
+    mfu_flist_usrgrp_create_map(&flist->groups, flist->group_id2name);
 
     /* read files, if any */
     if (all_count > 0 && chars > 0) {
@@ -1062,6 +1626,9 @@ static void read_cache_v4(
                 list_insert_ptr(flist, ptr, 1, chars);
                 ptr += elem_size;
                 packcount++;
+
+                /* hand off full batch */
+                cache_batch_check(flist, batch, 0);
             }
 
             /* one less iteration */
@@ -1072,33 +1639,311 @@ static void read_cache_v4(
         mfu_free(&buf);
     }
 
-    /* create maps of users and groups */
-    mfu_flist_usrgrp_create_map(&flist->users, flist->user_id2name);
-    mfu_flist_usrgrp_create_map(&flist->groups, flist->group_id2name);
-
     *outdisp = disp;
     return;
 }
 
-void mfu_flist_read_cache(
+/* file format:
+ * all fixed-width integer values stored in network byte order
+ *
+ *   uint64_t file version
+ *   uint64_t total number of users
+ *   uint64_t max username length
+ *   uint64_t total number of groups
+ *   uint64_t max groupname length
+ *   uint64_t total number of files
+ *   uint64_t max filename length, including terminating NUL
+ *   uint64_t total number of blocks
+ *   uint64_t offset of block index from start of file
+ *   list of <username(str), userid(uint64_t)>
+ *   list of <groupname(str), groupid(uint64_t)>
+ *   list of blocks of files, see cache_block_encode_elem
+ *   list of <offset, stored bytes, decoded bytes, files, codec>
+ *     one uint64_t each per block
+ *
+ * version 6 files use the same layout, but store blocks by column,
+ * see cache_columns_encode_elem, and add to each index entry
+ *   <min size, max size, min mtime, max mtime, min uid, max uid,
+ *    min gid, max gid, min depth, max depth>
+ *
+ * if pred is not NULL, blocks of a version 6 file in which no item
+ * can satisfy pred are skipped, and so are items that can't satisfy
+ * it, items that are read still need to be tested against pred
+ *   */
+static void read_cache_v5(
     const char* name,
-    mfu_flist bflist)
-{
-    /* convert handle to flist_t */
-    flist_t* flist = (flist_t*) bflist;
+    MPI_Offset* outdisp,
+    MPI_File fh,
+    const char* datarep,
+    uint64_t version,
+    const mfu_pred* pred,
+    flist_t* flist,
+    cache_batch_t* batch)
+{
+    MPI_Status status;
 
-    /* start timer */
-    double start_read = MPI_Wtime();
+    MPI_Offset disp = *outdisp;
+
+    /* indicate that we have stat data */
+    flist->detail = 1;
 
     /* get our rank */
-    int rank;
+    int rank, ranks;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
 
-    /* report the filename we're writing to */
-    if (mfu_rank == 0) {
-        MFU_LOG(MFU_LOG_INFO, "Reading from input file: %s", name);
+    /* rank 0 reads and broadcasts header */
+    uint64_t header[8];
+    int header_size = 8 * 8; /* 8 consecutive uint64_t */
+    int mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    if (rank == 0) {
+        uint64_t header_packed[8];
+        mpirc = MPI_File_read_at(fh, 0, header_packed, header_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+
+        const char* ptr = (const char*) header_packed;
+        int i;
+        for (i = 0; i < 8; i++) {
+            mfu_unpack_io_uint64(&ptr, &header[i]);
+        }
+    }
+    MPI_Bcast(header, 8, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    disp += header_size;
+
+    flist->users.count  = header[0];
+    flist->users.chars  = header[1];
+    flist->groups.count = header[2];
+    flist->groups.chars = header[3];
+    uint64_t chars      = header[5];
+    uint64_t all_blocks = header[6];
+    MPI_Offset index_disp = (MPI_Offset) header[7];
+
+    /* read users and groups */
+    read_cache_usrgrp(name, &disp, fh, datarep, &flist->users);
+    read_cache_usrgrp(name, &disp, fh, datarep, &flist->groups);
+
+    /* create maps of users and groups */
+    mfu_flist_usrgrp_create_map(&flist->users, flist->user_id2name);
+    mfu_flist_usrgrp_create_map(&flist->groups, flist->group_id2name);
+
+    /* divide blocks evenly among processes */
+    uint64_t count = all_blocks / (uint64_t)ranks;
+    uint64_t remainder = all_blocks - count * (uint64_t)ranks;
+    if ((uint64_t)rank < remainder) {
+        count++;
+    }
+
+    /* get index of our first block */
+    uint64_t offset;
+    MPI_Exscan(&count, &offset, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) {
+        offset = 0;
+    }
+
+    /* set view to access blocks and index by offset from start of file */
+    mpirc = MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* version 6 index entries carry zone maps */
+    int columns = (version == 6);
+    uint64_t fields = columns ? 15 : 5;
+    size_t entry_size = columns ? CACHE_ZONE_INDEX_ENTRY_SIZE : CACHE_INDEX_ENTRY_SIZE;
+
+    uint64_t skipped = 0;
+    if (count > 0) {
+        /* read index entries of our blocks */
+        size_t index_size = (size_t)count * entry_size;
+        char* index_buf = (char*) MFU_MALLOC(index_size);
+        MPI_Offset index_offset = index_disp + (MPI_Offset)offset * (MPI_Offset)entry_size;
+        mpirc = MPI_File_read_at(fh, index_offset, index_buf, (int)index_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+
+        /* unpack index, and find largest block and which blocks
+         * may hold items that satisfy pred */
+        uint64_t* index = (uint64_t*) MFU_MALLOC(count * fields * sizeof(uint64_t));
+        char* keep_blocks = (char*) MFU_MALLOC((size_t)count);
+        uint64_t max_stored = 0;
+        uint64_t max_decoded = 0;
+        uint64_t max_items = 0;
+        const char* ptr = index_buf;
+        uint64_t i;
+        for (i = 0; i < count * fields; i++) {
+            mfu_unpack_io_uint64(&ptr, &index[i]);
+        }
+        for (i = 0; i < count; i++) {
+            uint64_t* entry = &index[i * fields];
+            keep_blocks[i] = 1;
+            if (columns && pred != NULL) {
+                mfu_pred_zone zone;
+                zone.min_size  = entry[5];
+                zone.max_size  = entry[6];
+                zone.min_mtime = entry[7];
+                zone.max_mtime = entry[8];
+                zone.min_uid   = entry[9];
+                zone.max_uid   = entry[10];
+                zone.min_gid   = entry[11];
+                zone.max_gid   = entry[12];
+                zone.min_depth = entry[13];
+                zone.max_depth = entry[14];
+                keep_blocks[i] = (char) mfu_pred_zone_may_match(pred, &zone);
+            }
+            if (!keep_blocks[i]) {
+                skipped++;
+                continue;
+            }
+            if (entry[1] > max_stored) {
+                max_stored = entry[1];
+            }
+            if (entry[2] > max_decoded) {
+                max_decoded = entry[2];
+            }
+            if (entry[3] > max_items) {
+                max_items = entry[3];
+            }
+        }
+        mfu_free(&index_buf);
+
+        /* our blocks are contiguous in the file, read as many as fit
+         * in a buffer at a time, ensure it can hold the largest block */
+        size_t bufsize = 16 * 1024 * 1024;
+        if (bufsize < (size_t)max_stored) {
+            bufsize = (size_t)max_stored;
+        }
+        char* buf = (char*) MFU_MALLOC(bufsize);
+        char* decode_buf = (char*) MFU_MALLOC((size_t)max_decoded + 1);
+
+        /* allocate a buffer to rebuild names in */
+        char* path = (char*) MFU_MALLOC((size_t)chars + 1);
+
+        /* allocate buffers to decode columns of a block into */
+        uint64_t* vals = NULL;
+        char* keep_items = NULL;
+        if (columns) {
+            vals = (uint64_t*) MFU_MALLOC((size_t)max_items * CACHE_COLUMNS * sizeof(uint64_t));
+            keep_items = (char*) MFU_MALLOC((size_t)max_items);
+        }
+
+        uint64_t first = 0;
+        while (first < count) {
+            /* advance to next block we need */
+            if (!keep_blocks[first]) {
+                first++;
+                continue;
+            }
+
+            /* determine consecutive blocks we need that fit in buffer */
+            uint64_t last = first;
+            uint64_t read_size = 0;
+            while (last < count && keep_blocks[last] &&
+                   read_size + index[last * fields + 1] <= (uint64_t)bufsize)
+            {
+                read_size += index[last * fields + 1];
+                last++;
+            }
+
+            /* read blocks */
+            MPI_Offset read_offset = (MPI_Offset) index[first * fields + 0];
+            mpirc = MPI_File_read_at(fh, read_offset, buf, (int)read_size, MPI_BYTE, &status);
+            if (mpirc != MPI_SUCCESS) {
+                MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+                MFU_ABORT(1, "Failed to read file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+            }
+
+            /* decode each block into list */
+            char* block = buf;
+            for (i = first; i < last; i++) {
+                uint64_t* entry = &index[i * fields];
+                uint64_t stored  = entry[1];
+                uint64_t decoded = entry[2];
+                uint64_t items   = entry[3];
+                uint64_t codec   = entry[4];
+
+                const char* data = block;
+                if (codec == CACHE_CODEC_BZ2) {
+                    unsigned int out_size = (unsigned int) decoded;
+                    int ret = BZ2_bzBuffToBuffDecompress(decode_buf, &out_size,
+                        block, (unsigned int) stored, 0, 0);
+                    if (ret != BZ_OK || out_size != (unsigned int) decoded) {
+                        MFU_ABORT(1, "Failed to decompress block %llu of file: `%s' rc=%d",
+                            (unsigned long long)(offset + i), name, ret);
+                    }
+                    data = decode_buf;
+                }
+                else if (codec != CACHE_CODEC_NONE || stored != decoded) {
+                    MFU_ABORT(1, "Unknown encoding of block %llu in file: `%s'",
+                        (unsigned long long)(offset + i), name);
+                }
+
+                int rc;
+                if (columns) {
+                    rc = cache_columns_decode(flist, batch, pred, data, (size_t)decoded, items,
+                        vals, keep_items, path, (size_t)chars + 1);
+                } else {
+                    rc = cache_block_decode(flist, batch, data, (size_t)decoded, items,
+                        1, path, (size_t)chars + 1);
+                }
+                if (rc != 0) {
+                    MFU_ABORT(1, "Invalid block %llu in file: `%s'",
+                        (unsigned long long)(offset + i), name);
+                }
+
+                block += stored;
+            }
+
+            first = last;
+        }
+
+        mfu_free(&keep_items);
+        mfu_free(&vals);
+        mfu_free(&path);
+        mfu_free(&decode_buf);
+        mfu_free(&buf);
+        mfu_free(&keep_blocks);
+        mfu_free(&index);
+    }
+
+    /* report how many blocks the filter let us skip */
+    if (columns && pred != NULL) {
+        uint64_t all_skipped;
+        MPI_Allreduce(&skipped, &all_skipped, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_VERBOSE, "Skipped %llu of %llu blocks",
+                (unsigned long long)all_skipped, (unsigned long long)all_blocks);
+        }
     }
 
+    *outdisp = disp;
+    return;
+}
+
+/* open cache file and read items into flist, items are handed off
+ * in batches if batch is not NULL, if pred is not NULL, items that
+ * can't satisfy it may be left out, returns 0 on success and -1 if
+ * the file can't be opened */
+static int read_cache(
+    const char* name,
+    const mfu_pred* pred,
+    flist_t* flist,
+    cache_batch_t* batch)
+{
+    /* get our rank */
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
     /* open file */
     MPI_Status status;
     MPI_File fh;
@@ -1109,7 +1954,7 @@ void mfu_flist_read_cache(
         if (rank == 0) {
             MFU_LOG(MFU_LOG_ERR, "Failed to open file %s", name);
         }
-        return;
+        return -1;
     }
 
     /* set file view */
@@ -1138,9 +1983,11 @@ void mfu_flist_read_cache(
     MPI_Bcast(&version, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
     disp += 1 * 8; /* 9 consecutive uint64_t types in external32 */
 
-    /* read data from file */
-    if (version == 4) {
-        read_cache_v4(name, &disp, fh, datarep, flist);
+    /* read data from file, older formats are read whole */
+    if (version == 5 || version == 6) {
+        read_cache_v5(name, &disp, fh, datarep, version, pred, flist, batch);
+    } else if (version == 4) {
+        read_cache_v4(name, &disp, fh, datarep, flist, batch);
     } else if (version == 3) {
         /* need a couple of dummy params to record walk start and end times */
         uint64_t outstart = 0;
@@ -1152,6 +1999,9 @@ void mfu_flist_read_cache(
         read_cache_variable(name, fh, datarep, flist);
     }
 
+    /* hand off any remaining items */
+    cache_batch_check(flist, batch, 1);
+
     /* close file */
     mpirc = MPI_File_close(&fh);
     if (mpirc != MPI_SUCCESS) {
@@ -1159,6 +2009,30 @@ void mfu_flist_read_cache(
         MFU_ABORT(1, "Failed to close file: `%s' rc=%d %s", name, mpirc, mpierrstr);
     }
 
+    return 0;
+}
+
+void mfu_flist_read_cache_pred(
+    const char* name,
+    mfu_flist bflist,
+    mfu_pred* pred)
+{
+    /* convert handle to flist_t */
+    flist_t* flist = (flist_t*) bflist;
+
+    /* start timer */
+    double start_read = MPI_Wtime();
+
+    /* report the filename we're writing to */
+    if (mfu_rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "Reading from input file: %s", name);
+    }
+
+    /* read items into list */
+    if (read_cache(name, pred, flist, NULL) != 0) {
+        return;
+    }
+
     /* compute global summary */
     mfu_flist_summarize(bflist);
 
@@ -1184,6 +2058,69 @@ void mfu_flist_read_cache(
     return;
 }
 
+void mfu_flist_read_cache(
+    const char* name,
+    mfu_flist bflist)
+{
+    mfu_flist_read_cache_pred(name, bflist, NULL);
+}
+
+void mfu_flist_read_cache_batches(
+    const char* name,
+    mfu_pred* pred,
+    uint64_t batch_size,
+    mfu_flist_batch_fn fn,
+    void* arg)
+{
+    /* start timer */
+    double start_read = MPI_Wtime();
+
+    /* report the filename we're reading from */
+    if (mfu_rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "Reading from input file: %s", name);
+    }
+
+    /* describe where to hand off items */
+    cache_batch_t batch;
+    batch.size  = (batch_size > 0) ? batch_size : 1;
+    batch.fn    = fn;
+    batch.arg   = arg;
+    batch.count = 0;
+
+    /* read items into a list that holds one batch at a time */
+    mfu_flist bflist = mfu_flist_new();
+    flist_t* flist = (flist_t*) bflist;
+    int rc = read_cache(name, pred, flist, &batch);
+    mfu_flist_free(&bflist);
+    if (rc != 0) {
+        return;
+    }
+
+    /* get total number of items read */
+    uint64_t all_count;
+    MPI_Allreduce(&batch.count, &all_count, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    /* end timer */
+    double end_read = MPI_Wtime();
+
+    /* report read count, time, and rate */
+    if (mfu_rank == 0) {
+        double time_diff = end_read - start_read;
+        double rate = 0.0;
+        if (time_diff > 0.0) {
+            rate = ((double)all_count) / time_diff;
+        }
+        MFU_LOG(MFU_LOG_INFO, "Read %lu files in %.3lf seconds (%.3lf files/sec)",
+               all_count, time_diff, rate
+              );
+    }
+
+    /* wait for summary to be printed */
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    return;
+}
+
 /****************************************
  * Write file list to file
  ***************************************/
@@ -1193,7 +2130,13 @@ void mfu_flist_read_cache(
  * 2: version, start, end, files, file chars, list (file, type)
  * 3: version, start, end, files, users, user chars, groups, group chars,
  *    files, file chars, list (user, userid), list (group, groupid),
- *    list (stat) */
+ *    list (stat)
+ * 4: version, users, user chars, groups, group chars, files, file chars,
+ *    list (user, userid), list (group, groupid), list (stat)
+ * 5: version, users, user chars, groups, group chars, files, file chars,
+ *    blocks, index offset, list (user, userid), list (group, groupid),
+ *    blocks (stat), index (block)
+ * 6: as 5, with blocks stored by column and index (block, zone map) */
 
 /* write each record in ASCII format, terminated with newlines */
 static void write_cache_readdir_variable(
@@ -1326,6 +2269,48 @@ static void write_cache_readdir_variable(
     return;
 }
 
+/* write list of user or group names and ids starting at disp,
+ * and advance disp past the list */
+static void write_cache_usrgrp(
+    const char* name,
+    MPI_Offset* pdisp,
+    MPI_File fh,
+    const char* datarep,
+    const buf_t* items)
+{
+    MPI_Status status;
+
+    /* get our rank */
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* nothing to do if there are no items */
+    if (items->dt == MPI_DATATYPE_NULL) {
+        return;
+    }
+
+    /* set view to write out items */
+    int mpirc = MPI_File_set_view(fh, *pdisp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* write out items */
+    int pack_size = (int) buft_pack_size(items);
+    if (rank == 0) {
+        char* pack_buf = (char*) MFU_MALLOC(pack_size);
+        buft_pack(pack_buf, items);
+        mpirc = MPI_File_write_at(fh, 0, pack_buf, pack_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+        mfu_free(&pack_buf);
+    }
+    *pdisp += (MPI_Offset) pack_size;
+}
+
 static void write_cache_stat_v4(
     const char* name,
     flist_t* flist)
@@ -1415,51 +2400,9 @@ static void write_cache_stat_v4(
     }
     disp += header_bytes;
 
-    if (users->dt != MPI_DATATYPE_NULL) {
-        /* set view to write out users */
-        mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
-        if (mpirc != MPI_SUCCESS) {
-            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
-            MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
-        }
-
-        /* write out users */
-        int user_buf_size = (int) buft_pack_size(users);
-        if (rank == 0) {
-            char* user_buf = (char*) MFU_MALLOC(user_buf_size);
-            buft_pack(user_buf, users);
-            mpirc = MPI_File_write_at(fh, 0, user_buf, user_buf_size, MPI_BYTE, &status);
-            if (mpirc != MPI_SUCCESS) {
-                MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
-                MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
-            }
-            mfu_free(&user_buf);
-        }
-        disp += (MPI_Offset)user_buf_size;
-    }
-
-    if (groups->dt != MPI_DATATYPE_NULL) {
-        /* set view to write out groups */
-        mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
-        if (mpirc != MPI_SUCCESS) {
-            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
-            MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
-        }
-
-        /* write out groups */
-        int group_buf_size = (int) buft_pack_size(groups);
-        if (rank == 0) {
-            char* group_buf = (char*) MFU_MALLOC(group_buf_size);
-            buft_pack(group_buf, groups);
-            mpirc = MPI_File_write_at(fh, 0, group_buf, group_buf_size, MPI_BYTE, &status);
-            if (mpirc != MPI_SUCCESS) {
-                MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
-                MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
-            }
-            mfu_free(&group_buf);
-        }
-        disp += (MPI_Offset)group_buf_size;
-    }
+    /* write users and groups */
+    write_cache_usrgrp(name, &disp, fh, datarep, users);
+    write_cache_usrgrp(name, &disp, fh, datarep, groups);
 
     /* in order to avoid blowing out memory, we'll pack into a smaller
      * buffer and iteratively make many collective writes */
@@ -1543,37 +2486,385 @@ static void write_cache_stat_v4(
     return;
 }
 
-void mfu_flist_write_cache(
-    const char* name,
-    mfu_flist bflist)
+/* select how blocks of a version 5 cache are stored,
+ * which can be overridden through an environment variable */
+static int select_cache_codec(void)
 {
-    /* convert handle to flist_t */
-    flist_t* flist = (flist_t*) bflist;
-
-    /* start timer */
-    double start_write = MPI_Wtime();
-
-    /* total list items */
-    uint64_t all_count = mfu_flist_global_size(flist);
-
-    /* report the filename we're writing to */
-    if (mfu_rank == 0) {
-        MFU_LOG(MFU_LOG_INFO, "Writing to output file: %s", name);
-    }
-
-    if (all_count > 0) {
-        if (flist->detail) {
-            write_cache_stat_v4(name, flist);
-        }
-        else {
-            write_cache_readdir_variable(name, flist);
+    int codec = CACHE_CODEC_NONE;
+
+    char varname[] = "MFU_FLIST_CACHE_COMPRESS";
+    const char* value = getenv(varname);
+    if (value != NULL) {
+        if (strcmp(value, "NONE") == 0) {
+            codec = CACHE_CODEC_NONE;
+        } else if (strcmp(value, "BZ2") == 0) {
+            codec = CACHE_CODEC_BZ2;
+        } else {
+            if (mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_ERR, "%s: Unknown value: %s", varname, value);
+            }
         }
     }
 
-    /* end timer */
-    double end_write = MPI_Wtime();
+    return codec;
+}
 
-    /* report write count, time, and rate */
+/* write list in version 5 format, or in version 6 format if
+ * version is 6, see read_cache_v5 */
+static void write_cache_stat_v5(
+    const char* name,
+    uint64_t version,
+    flist_t* flist)
+{
+    buf_t* users  = &flist->users;
+    buf_t* groups = &flist->groups;
+
+    /* get our rank in job & number of ranks */
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* use mpi io hints to stripe across OSTs */
+    MPI_Info info;
+    MPI_Info_create(&info);
+
+    /* get total file count and longest name */
+    uint64_t all_count = flist->total_files;
+    uint64_t chars     = flist->max_file_name;
+
+    /* select how to store blocks */
+    int codec = select_cache_codec();
+
+    /* version 6 stores blocks by column and adds zone maps to index */
+    int columns = (version == 6);
+    uint64_t fields = columns ? 15 : 5;
+    size_t entry_size = columns ? CACHE_ZONE_INDEX_ENTRY_SIZE : CACHE_INDEX_ENTRY_SIZE;
+
+    /* encode our items into blocks, since encoded blocks are much
+     * smaller than the list itself we hold all of them in memory
+     * to learn where each process writes */
+    size_t raw_size = CACHE_COLUMNS * VARINT_MAX + CACHE_BLOCK_BYTES + cache_block_elem_max(chars);
+    char* raw = (char*) MFU_MALLOC(raw_size);
+
+    /* allocate space to build each column of a block */
+    char* col_space = NULL;
+    char* col_bufs[CACHE_COLUMNS];
+    if (columns) {
+        size_t name_size = CACHE_BLOCK_BYTES + cache_block_elem_max(chars);
+        size_t col_size  = cache_column_max(CACHE_BLOCK_ITEMS);
+        col_space = (char*) MFU_MALLOC(name_size + (CACHE_COLUMNS - 1) * col_size);
+        col_bufs[CACHE_COL_NAME] = col_space;
+        int c;
+        for (c = CACHE_COL_NAME + 1; c < CACHE_COLUMNS; c++) {
+            col_bufs[c] = col_space + name_size + (size_t)(c - 1) * col_size;
+        }
+    }
+
+    /* bzip2 may expand data by up to 1% plus 600 bytes */
+    size_t zip_size = raw_size + raw_size / 100 + 600;
+    char* zip = NULL;
+    if (codec == CACHE_CODEC_BZ2) {
+        zip = (char*) MFU_MALLOC(zip_size);
+    }
+
+    size_t data_size = 0;
+    size_t data_cap  = CACHE_BLOCK_BYTES;
+    char* data = (char*) MFU_MALLOC(data_cap);
+
+    uint64_t blocks    = 0;
+    uint64_t index_cap = 0;
+    uint64_t* index = NULL;
+
+    const elem_t* current = flist->list_head;
+    while (current != NULL) {
+        mfu_pred_zone zone;
+        memset(&zone, 0, sizeof(zone));
+        uint64_t items = 0;
+        size_t decoded;
+        if (columns) {
+            decoded = cache_columns_encode_block(raw, col_bufs, &current, &zone, &items);
+        } else {
+            /* encode items until block is full */
+            char* ptr = raw;
+            const char* prev = "";
+            while (current != NULL && items < CACHE_BLOCK_ITEMS &&
+                   (size_t)(ptr - raw) < CACHE_BLOCK_BYTES)
+            {
+                ptr += cache_block_encode_elem(ptr, prev, flist->detail, current);
+                prev = current->file;
+                current = current->next;
+                items++;
+            }
+            decoded = (size_t)(ptr - raw);
+        }
+
+        /* compress block, keep it as is if that does not help */
+        const char* block = raw;
+        size_t stored = decoded;
+        uint64_t block_codec = CACHE_CODEC_NONE;
+        if (codec == CACHE_CODEC_BZ2) {
+            unsigned int out_size = (unsigned int) zip_size;
+            int ret = BZ2_bzBuffToBuffCompress(zip, &out_size, raw,
+                (unsigned int) decoded, 9, 0, 30);
+            if (ret == BZ_OK && (size_t)out_size < decoded) {
+                block = zip;
+                stored = (size_t) out_size;
+                block_codec = CACHE_CODEC_BZ2;
+            }
+        }
+
+        /* append block to our data */
+        if (data_size + stored > data_cap) {
+            data_cap = (data_size + stored) * 2;
+            data = (char*) MFU_REALLOC(data, data_cap);
+        }
+        memcpy(data + data_size, block, stored);
+
+        /* record block in index, offset is relative to our data for now */
+        if (blocks == index_cap) {
+            index_cap = (index_cap == 0) ? 1024 : index_cap * 2;
+            index = (uint64_t*) MFU_REALLOC(index, index_cap * fields * sizeof(uint64_t));
+        }
+        uint64_t* entry = &index[blocks * fields];
+        entry[0] = (uint64_t) data_size;
+        entry[1] = (uint64_t) stored;
+        entry[2] = (uint64_t) decoded;
+        entry[3] = items;
+        entry[4] = block_codec;
+        if (columns) {
+            entry[5]  = zone.min_size;
+            entry[6]  = zone.max_size;
+            entry[7]  = zone.min_mtime;
+            entry[8]  = zone.max_mtime;
+            entry[9]  = zone.min_uid;
+            entry[10] = zone.max_uid;
+            entry[11] = zone.min_gid;
+            entry[12] = zone.max_gid;
+            entry[13] = zone.min_depth;
+            entry[14] = zone.max_depth;
+        }
+        blocks++;
+
+        data_size += stored;
+    }
+
+    mfu_free(&col_space);
+    mfu_free(&zip);
+    mfu_free(&raw);
+
+    /* compute offsets of our data and index entries and global totals */
+    uint64_t sizes[2], offsets[2], totals[2];
+    sizes[0] = (uint64_t) data_size;
+    sizes[1] = blocks;
+    MPI_Exscan(sizes, offsets, 2, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) {
+        offsets[0] = 0;
+        offsets[1] = 0;
+    }
+    MPI_Allreduce(sizes, totals, 2, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    uint64_t all_blocks = totals[1];
+
+    /* open file */
+    MPI_Status status;
+    MPI_File fh;
+    const char* datarep = datarep_native;
+    int amode = MPI_MODE_WRONLY | MPI_MODE_CREATE;
+
+    /* change number of ranks to string to pass to MPI_Info */
+    char str_buf[12];
+    sprintf(str_buf, "%d", ranks);
+
+    /* no. of I/O devices for lustre striping is number of ranks */
+    MPI_Info_set(info, "striping_factor", str_buf);
+
+    int mpirc = MPI_File_open(MPI_COMM_WORLD, (char*)name, amode, info, &fh);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to open file for writing: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* truncate file to 0 bytes */
+    mpirc = MPI_File_set_size(fh, 0);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to truncate file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* compute where blocks and index start */
+    int header_bytes = 9 * 8;
+    MPI_Offset data_disp = (MPI_Offset) header_bytes;
+    if (users->dt != MPI_DATATYPE_NULL) {
+        data_disp += (MPI_Offset) buft_pack_size(users);
+    }
+    if (groups->dt != MPI_DATATYPE_NULL) {
+        data_disp += (MPI_Offset) buft_pack_size(groups);
+    }
+    MPI_Offset index_disp = data_disp + (MPI_Offset) totals[0];
+
+    /* prepare header */
+    uint64_t header[9];
+    char* ptr = (char*) header;
+    mfu_pack_io_uint64(&ptr, version);               /* file version */
+    mfu_pack_io_uint64(&ptr, users->count);          /* number of user records */
+    mfu_pack_io_uint64(&ptr, users->chars);          /* number of chars in user name */
+    mfu_pack_io_uint64(&ptr, groups->count);         /* number of group records */
+    mfu_pack_io_uint64(&ptr, groups->chars);         /* number of chars in group name */
+    mfu_pack_io_uint64(&ptr, all_count);             /* total number of stat entries */
+    mfu_pack_io_uint64(&ptr, chars);                 /* max number of chars in file name */
+    mfu_pack_io_uint64(&ptr, all_blocks);            /* total number of blocks */
+    mfu_pack_io_uint64(&ptr, (uint64_t) index_disp); /* offset of block index */
+
+    /* set view to write the header */
+    MPI_Offset disp = 0;
+    mpirc = MPI_File_set_view(fh, disp, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* write the header */
+    if (rank == 0) {
+        mpirc = MPI_File_write_at(fh, 0, header, header_bytes, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+    }
+    disp += header_bytes;
+
+    /* write users and groups */
+    write_cache_usrgrp(name, &disp, fh, datarep, users);
+    write_cache_usrgrp(name, &disp, fh, datarep, groups);
+
+    /* set view to write blocks and index by offset from start of file */
+    mpirc = MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, datarep, MPI_INFO_NULL);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to set view on file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* write our blocks in pieces that fit in an int */
+    size_t chunk = 128 * 1024 * 1024;
+    uint64_t iters = ((uint64_t)data_size + chunk - 1) / chunk;
+    uint64_t all_iters;
+    MPI_Allreduce(&iters, &all_iters, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    MPI_Offset write_offset = data_disp + (MPI_Offset) offsets[0];
+    size_t written = 0;
+    while (all_iters > 0) {
+        size_t write_size = data_size - written;
+        if (write_size > chunk) {
+            write_size = chunk;
+        }
+
+        mpirc = MPI_File_write_at_all(fh, write_offset, data + written, (int)write_size, MPI_BYTE, &status);
+        if (mpirc != MPI_SUCCESS) {
+            MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+            MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+        }
+
+        write_offset += (MPI_Offset) write_size;
+        written += write_size;
+        all_iters--;
+    }
+
+    /* pack our index entries with offsets from start of file */
+    size_t index_size = (size_t)blocks * entry_size;
+    char* index_buf = (char*) MFU_MALLOC(index_size);
+    ptr = index_buf;
+    uint64_t i;
+    for (i = 0; i < blocks; i++) {
+        uint64_t* entry = &index[i * fields];
+        mfu_pack_io_uint64(&ptr, entry[0] + (uint64_t)data_disp + offsets[0]);
+        uint64_t j;
+        for (j = 1; j < fields; j++) {
+            mfu_pack_io_uint64(&ptr, entry[j]);
+        }
+    }
+
+    /* write index */
+    MPI_Offset index_offset = index_disp + (MPI_Offset)offsets[1] * (MPI_Offset)entry_size;
+    mpirc = MPI_File_write_at_all(fh, index_offset, index_buf, (int)index_size, MPI_BYTE, &status);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    mfu_free(&index_buf);
+    mfu_free(&index);
+    mfu_free(&data);
+
+    /* close file */
+    mpirc = MPI_File_close(&fh);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to close file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
+
+    /* free mpi info */
+    MPI_Info_free(&info);
+
+    return;
+}
+
+void mfu_flist_write_cache(
+    const char* name,
+    mfu_flist bflist)
+{
+    /* convert handle to flist_t */
+    flist_t* flist = (flist_t*) bflist;
+
+    /* start timer */
+    double start_write = MPI_Wtime();
+
+    /* total list items */
+    uint64_t all_count = mfu_flist_global_size(flist);
+
+    /* report the filename we're writing to */
+    if (mfu_rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "Writing to output file: %s", name);
+    }
+
+    if (all_count > 0) {
+        if (flist->detail) {
+            /* fill in any stat fields the walk skipped */
+            elem_t* elem = flist->list_head;
+            while (elem != NULL) {
+                mfu_flist_elem_need(elem, MFU_STAT_ALL);
+                elem = elem->next;
+            }
+
+            /* write version 4, which older releases can read, unless
+             * the block format or the columnar format is requested
+             * through an environment variable */
+            int version = 4;
+            char varname[] = "MFU_FLIST_CACHE_VERSION";
+            const char* value = getenv(varname);
+            if (value != NULL) {
+                if (strcmp(value, "5") == 0) {
+                    version = 5;
+                } else if (strcmp(value, "6") == 0) {
+                    version = 6;
+                } else if (strcmp(value, "4") != 0 && mfu_rank == 0) {
+                    MFU_LOG(MFU_LOG_ERR, "%s: Unknown value: %s", varname, value);
+                }
+            }
+
+            if (version == 4) {
+                write_cache_stat_v4(name, flist);
+            } else {
+                write_cache_stat_v5(name, version, flist);
+            }
+        }
+        else {
+            write_cache_readdir_variable(name, flist);
+        }
+    }
+
+    /* end timer */
+    double end_write = MPI_Wtime();
+
+    /* report write count, time, and rate */
     if (mfu_rank == 0) {
         double secs = end_write - start_write;
         double rate = 0.0;
@@ -1591,80 +2882,434 @@ void mfu_flist_write_cache(
     return;
 }
 
-/* TODO: move this somewhere or modify existing print_file */
-/* print information about a file given the index and rank (used in print_files) */
-static size_t print_file_text(mfu_flist flist, uint64_t idx, char* buffer, size_t bufsize)
+/****************************************
+ * Checkpoint files written during a walk
+ ***************************************/
+
+/* While a walk runs, each process periodically writes the items it
+ * has added to its list since the last checkpoint to a file of its
+ * own.  Processes don't synchronize to do this, so the collective
+ * cache writers can't be used.  A part file holds a version number
+ * followed by records, each of which is the length of a packed
+ * element and the element itself.  Records are only appended, so a
+ * process that dies while writing leaves at most one partial record
+ * at the end, which readers ignore.  If an append fails, the file is
+ * truncated back to its previous end, so later appends never follow
+ * a partial record. */
+
+/* version number at the start of a part file */
+#define PART_VERSION (1)
+
+/* number of bytes buffered before writing records */
+#define PART_BUFSIZE (1024 * 1024)
+
+int mfu_flist_write_part(const char* name, int truncate, int detail, const elem_t* elem)
 {
-    size_t numbytes = 0;
+    /* write a new file under a temporary name and rename it when done,
+     * so an existing checkpoint is not lost if we die while writing */
+    char tmpname[PATH_MAX];
+    int len = snprintf(tmpname, sizeof(tmpname), "%s.tmp", name);
+    if (len < 0 || (size_t)len >= sizeof(tmpname)) {
+        MFU_LOG(MFU_LOG_ERR, "Checkpoint file name too long: '%s'", name);
+        return -1;
+    }
+
+    const char* file = truncate ? tmpname : name;
+    int flags = truncate ? (O_WRONLY | O_CREAT | O_TRUNC) : (O_WRONLY | O_APPEND);
+    int fd = mfu_open(file, flags, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open checkpoint file: '%s' (errno=%d %s)",
+                file, errno, strerror(errno));
+        return -1;
+    }
+
+    /* remember where the records we append start */
+    off_t start = 0;
+    if (! truncate) {
+        start = mfu_lseek(file, fd, 0, SEEK_END);
+        if (start == (off_t)-1) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to seek in checkpoint file: '%s' (errno=%d %s)",
+                    file, errno, strerror(errno));
+            mfu_close(file, fd);
+            return -1;
+        }
+    }
 
-    /* store types as strings for print_file */
-    char type_str_unknown[] = "UNK";
-    char type_str_dir[]     = "DIR";
-    char type_str_file[]    = "REG";
-    char type_str_link[]    = "LNK";
+    int rc = 0;
+    char* buf = (char*) MFU_MALLOC(PART_BUFSIZE);
+    char* ptr = buf;
+
+    if (truncate) {
+        mfu_pack_io_uint64(&ptr, PART_VERSION);
+    }
+
+    while (elem != NULL && rc == 0) {
+        /* flush buffer if this record doesn't fit */
+        size_t size = mfu_flist_elem_pack_size(detail, elem);
+        size_t used = (size_t)(ptr - buf);
+        if (used + 8 + size > PART_BUFSIZE && used > 0) {
+            if (mfu_write(file, fd, buf, used) != (ssize_t)used) {
+                rc = -1;
+                break;
+            }
+            ptr = buf;
+        }
+
+        /* a name longer than the buffer gets a buffer of its own */
+        if (8 + size > PART_BUFSIZE) {
+            char* rec = (char*) MFU_MALLOC(8 + size);
+            char* recptr = rec;
+            mfu_pack_io_uint64(&recptr, (uint64_t)size);
+            mfu_flist_elem_pack(recptr, detail, elem);
+            if (mfu_write(file, fd, rec, 8 + size) != (ssize_t)(8 + size)) {
+                rc = -1;
+            }
+            mfu_free(&rec);
+        } else {
+            mfu_pack_io_uint64(&ptr, (uint64_t)size);
+            ptr += mfu_flist_elem_pack(ptr, detail, elem);
+        }
+
+        elem = elem->next;
+    }
+
+    /* write what's left in the buffer */
+    size_t used = (size_t)(ptr - buf);
+    if (rc == 0 && used > 0) {
+        if (mfu_write(file, fd, buf, used) != (ssize_t)used) {
+            rc = -1;
+        }
+    }
+    mfu_free(&buf);
+
+    /* make sure records survive a node failure */
+    if (rc == 0 && mfu_fsync(file, fd) != 0) {
+        rc = -1;
+    }
+    if (rc != 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to write checkpoint file: '%s' (errno=%d %s)",
+                file, errno, strerror(errno));
+
+        /* drop any partial records we appended */
+        if (! truncate && mfu_ftruncate(fd, start) != 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to truncate checkpoint file: '%s' (errno=%d %s)",
+                    file, errno, strerror(errno));
+        }
+    }
+    mfu_close(file, fd);
+
+    if (rc == 0 && truncate) {
+        if (rename(tmpname, name) != 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to rename checkpoint file: '%s' to '%s' (errno=%d %s)",
+                    tmpname, name, errno, strerror(errno));
+            rc = -1;
+        }
+    }
+
+    return rc;
+}
+
+int mfu_flist_read_part(const char* name, flist_t* flist)
+{
+    int fd = mfu_open(name, O_RDONLY);
+    if (fd < 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open checkpoint file: '%s' (errno=%d %s)",
+                name, errno, strerror(errno));
+        return -1;
+    }
+
+    /* read the whole file, a single read may return less than asked
+     * for, and never returns more than about 2GB on Linux */
+    uint64_t filesize = get_filesize(name);
+    char* buf = (char*) MFU_MALLOC((size_t)filesize + 1);
+    size_t nread = 0;
+    while (nread < (size_t)filesize) {
+        ssize_t rc = mfu_read(name, fd, buf + nread, (size_t)filesize - nread);
+        if (rc <= 0) {
+            break;
+        }
+        nread += (size_t)rc;
+    }
+    mfu_close(name, fd);
+    if (nread < (size_t)filesize) {
+        MFU_LOG(MFU_LOG_ERR, "Read %llu of %llu bytes of checkpoint file: '%s'",
+                (unsigned long long) nread, (unsigned long long) filesize, name);
+    }
+    if (nread < 8) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to read checkpoint file: '%s'", name);
+        mfu_free(&buf);
+        return -1;
+    }
+
+    const char* ptr = buf;
+    const char* end = buf + nread;
+
+    uint64_t version;
+    mfu_unpack_io_uint64(&ptr, &version);
+    if (version != PART_VERSION) {
+        MFU_LOG(MFU_LOG_ERR, "Unsupported checkpoint file version %llu: '%s'",
+                (unsigned long long) version, name);
+        mfu_free(&buf);
+        return -1;
+    }
+
+    /* insert each complete record, a partial record at the end
+     * was cut short by a failure while it was being written */
+    while (end - ptr >= 8) {
+        uint64_t size;
+        mfu_unpack_io_uint64(&ptr, &size);
+        if (size > (uint64_t)(end - ptr)) {
+            break;
+        }
+
+        elem_t* elem = mfu_flist_elem_alloc(flist);
+        mfu_flist_elem_unpack(flist, ptr, elem);
+        mfu_flist_insert_elem(flist, elem);
+        ptr += size;
+    }
+
+    mfu_free(&buf);
+    return 0;
+}
+
+/****************************************
+ * Format list as text
+ ***************************************/
+
+/* number of formatted modify times remembered while writing text */
+#define TEXT_TIME_SLOTS (1024)
+
+/* bytes of text formatted before handing it off to be written */
+#define TEXT_CHUNK_BYTES (8 * 1024 * 1024)
+
+/* state kept while formatting lines of text, which lets consecutive
+ * items reuse the more expensive pieces of the previous ones */
+typedef struct text_format {
+    /* modify times are printed to the minute, so cache the string
+     * for each minute in a slot picked by the minute */
+    uint64_t time_minute[TEXT_TIME_SLOTS];
+    char     time_str[TEXT_TIME_SLOTS][32];
+    size_t   time_len[TEXT_TIME_SLOTS];
+    int      time_valid[TEXT_TIME_SLOTS];
+
+    /* user and group names of the previous item */
+    int have_uid;
+    uint64_t uid;
+    const char* username;
+    size_t username_len;
+    int have_gid;
+    uint64_t gid;
+    const char* groupname;
+    size_t groupname_len;
+} text_format_t;
+
+/* pieces of one line of text, the line is the pieces in order */
+#define TEXT_PIECES (14)
+typedef struct text_line {
+    const char* str[TEXT_PIECES];
+    size_t len[TEXT_PIECES];
+    int count;
+    char mode[11];
+    char size[32];
+} text_line_t;
+
+static void text_line_add(text_line_t* line, const char* str, size_t len)
+{
+    line->str[line->count] = str;
+    line->len[line->count] = len;
+    line->count++;
+}
+
+/* write value in decimal to buf, returns number of chars written */
+static size_t text_format_uint(char* buf, uint64_t value)
+{
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value > 0);
+
+    size_t i;
+    for (i = 0; i < n; i++) {
+        buf[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+/* write size as "%7.3f %3s" of the value and units reported by
+ * mfu_format_bytes without going through printf, returns number of
+ * chars written to buf, which must hold at least 32 chars */
+static size_t text_format_size(char* buf, uint64_t size)
+{
+    double val;
+    const char* units;
+    mfu_format_bytes(size, &val, &units);
+
+    /* mfu_format_bytes returns values well below 2^11, so the
+     * fraction is an exact multiple of 2^-53, round it to three
+     * digits with ties to even as printf does */
+    uint64_t whole = (uint64_t) val;
+    uint64_t frac  = (uint64_t) ((val - (double)whole) * 9007199254740992.0);
+    uint64_t scaled = frac * 1000;
+    uint64_t thousandths = scaled >> 53;
+    uint64_t rem  = scaled & ((1ULL << 53) - 1);
+    uint64_t half = 1ULL << 52;
+    if (rem > half || (rem == half && (thousandths & 1))) {
+        thousandths++;
+        if (thousandths == 1000) {
+            thousandths = 0;
+            whole++;
+        }
+    }
+
+    char num[32];
+    size_t n = text_format_uint(num, whole);
+    num[n++] = '.';
+    num[n++] = (char)('0' + thousandths / 100);
+    num[n++] = (char)('0' + (thousandths / 10) % 10);
+    num[n++] = (char)('0' + thousandths % 10);
+
+    /* pad number to 7 chars and units to 3 chars */
+    char* ptr = buf;
+    size_t i;
+    for (i = n; i < 7; i++) {
+        *ptr++ = ' ';
+    }
+    memcpy(ptr, num, n);
+    ptr += n;
+    *ptr++ = ' ';
+    size_t units_len = strlen(units);
+    for (i = units_len; i < 3; i++) {
+        *ptr++ = ' ';
+    }
+    memcpy(ptr, units, units_len);
+    ptr += units_len;
+
+    return (size_t)(ptr - buf);
+}
+
+/* look up formatted modify time in cache, formatting it on a miss */
+static void text_format_time(text_format_t* fmt, uint64_t secs, const char** str, size_t* len)
+{
+    uint64_t minute = secs / 60;
+    size_t slot = (size_t)(minute % TEXT_TIME_SLOTS);
+    if (!fmt->time_valid[slot] || fmt->time_minute[slot] != minute) {
+        time_t modify_t = (time_t) secs;
+        size_t modify_rc = strftime(fmt->time_str[slot], sizeof(fmt->time_str[slot]) - 1,
+            "%b %e %Y %H:%M", localtime(&modify_t));
+        if (modify_rc == 0) {
+            /* error */
+            fmt->time_str[slot][0] = '\0';
+        }
+        fmt->time_len[slot]    = modify_rc;
+        fmt->time_minute[slot] = minute;
+        fmt->time_valid[slot]  = 1;
+    }
+    *str = fmt->time_str[slot];
+    *len = fmt->time_len[slot];
+}
+
+/* break the line of text for an item into pieces, returns length of line */
+static size_t text_format_line(text_format_t* fmt, mfu_flist flist, uint64_t idx, text_line_t* line)
+{
+    line->count = 0;
 
     /* get filename */
     const char* file = mfu_flist_file_get_name(flist, idx);
 
+    size_t len = 0;
     if (mfu_flist_have_detail(flist)) {
         /* get mode */
         mode_t mode = (mode_t) mfu_flist_file_get_mode(flist, idx);
-
-        uint64_t acc = mfu_flist_file_get_atime(flist, idx);
-        uint64_t mod = mfu_flist_file_get_mtime(flist, idx);
-        uint64_t cre = mfu_flist_file_get_ctime(flist, idx);
-        uint64_t size = mfu_flist_file_get_size(flist, idx);
-        const char* username  = mfu_flist_file_get_username(flist, idx);
-        const char* groupname = mfu_flist_file_get_groupname(flist, idx);
-
-        char access_s[30];
-        char modify_s[30];
-        char create_s[30];
-        time_t access_t = (time_t) acc;
-        time_t modify_t = (time_t) mod;
-        time_t create_t = (time_t) cre;
-        size_t access_rc = strftime(access_s, sizeof(access_s) - 1, "%FT%T", localtime(&access_t));
-        size_t modify_rc = strftime(modify_s, sizeof(modify_s) - 1, "%b %e %Y %H:%M", localtime(&modify_t));
-        size_t create_rc = strftime(create_s, sizeof(create_s) - 1, "%FT%T", localtime(&create_t));
-        if (access_rc == 0 || modify_rc == 0 || create_rc == 0) {
-            /* error */
-            access_s[0] = '\0';
-            modify_s[0] = '\0';
-            create_s[0] = '\0';
+        mfu_format_mode(mode, line->mode);
+        text_line_add(line, line->mode, 10);
+        text_line_add(line, " ", 1);
+
+        /* looking up names by id is expensive, so reuse the names of
+         * the previous item when ids match */
+        uint64_t uid = mfu_flist_file_get_uid(flist, idx);
+        if (!fmt->have_uid || fmt->uid != uid) {
+            fmt->username = mfu_flist_file_get_username(flist, idx);
+            fmt->username_len = strlen(fmt->username);
+            fmt->uid = uid;
+            fmt->have_uid = 1;
         }
+        text_line_add(line, fmt->username, fmt->username_len);
+        text_line_add(line, " ", 1);
+
+        uint64_t gid = mfu_flist_file_get_gid(flist, idx);
+        if (!fmt->have_gid || fmt->gid != gid) {
+            fmt->groupname = mfu_flist_file_get_groupname(flist, idx);
+            fmt->groupname_len = strlen(fmt->groupname);
+            fmt->gid = gid;
+            fmt->have_gid = 1;
+        }
+        text_line_add(line, fmt->groupname, fmt->groupname_len);
+        text_line_add(line, " ", 1);
 
-        char mode_format[11];
-        mfu_format_mode(mode, mode_format);
-
-        double size_tmp;
-        const char* size_units;
-        mfu_format_bytes(size, &size_tmp, &size_units);
+        uint64_t size = mfu_flist_file_get_size(flist, idx);
+        size_t size_len = text_format_size(line->size, size);
+        text_line_add(line, line->size, size_len);
+        text_line_add(line, " ", 1);
 
-        numbytes = snprintf(buffer, bufsize, "%s %s %s %7.3f %3s %s %s\n",
-            mode_format, username, groupname,
-            size_tmp, size_units, modify_s, file
-        );
+        const char* modify_s;
+        size_t modify_len;
+        uint64_t mod = mfu_flist_file_get_mtime(flist, idx);
+        text_format_time(fmt, mod, &modify_s, &modify_len);
+        text_line_add(line, modify_s, modify_len);
+        text_line_add(line, " ", 1);
     }
     else {
         /* get type */
         mfu_filetype type = mfu_flist_file_get_type(flist, idx);
-        char* type_str = type_str_unknown;
+        const char* type_str = "UNK";
         if (type == MFU_TYPE_DIR) {
-            type_str = type_str_dir;
+            type_str = "DIR";
         }
         else if (type == MFU_TYPE_FILE) {
-            type_str = type_str_file;
+            type_str = "REG";
         }
         else if (type == MFU_TYPE_LINK) {
-            type_str = type_str_link;
+            type_str = "LNK";
         }
 
-        numbytes = snprintf(buffer, bufsize, "Type=%s File=%s\n",
-            type_str, file
-        );
+        text_line_add(line, "Type=", 5);
+        text_line_add(line, type_str, 3);
+        text_line_add(line, " File=", 6);
+    }
+
+    text_line_add(line, file, strlen(file));
+    text_line_add(line, "\n", 1);
+
+    int i;
+    for (i = 0; i < line->count; i++) {
+        len += line->len[i];
     }
+    return len;
+}
 
-    return numbytes;
+/* copy pieces of line to buf, which must have room for all of it */
+static size_t text_copy_line(const text_line_t* line, char* buf)
+{
+    char* ptr = buf;
+    int i;
+    for (i = 0; i < line->count; i++) {
+        memcpy(ptr, line->str[i], line->len[i]);
+        ptr += line->len[i];
+    }
+    return (size_t)(ptr - buf);
+}
+
+/* wait for a pending write to finish */
+static void text_write_wait(const char* name, MPI_Request* req)
+{
+    MPI_Status status;
+    int mpirc = MPI_Wait(req, &status);
+    if (mpirc != MPI_SUCCESS) {
+        MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
+        MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
+    }
 }
 
 void mfu_flist_write_text(
@@ -1690,38 +3335,33 @@ void mfu_flist_write_text(
         MFU_LOG(MFU_LOG_INFO, "Writing to output file: %s", name);
     }
 
-    /* compute size of buffer needed to hold all data */
-    size_t bufsize = 0;
+    /* measure our text, which we need to know where we write, and
+     * the longest line so that each chunk can hold a whole line */
+    text_format_t* fmt = (text_format_t*) MFU_MALLOC(sizeof(text_format_t));
+    memset(fmt, 0, sizeof(text_format_t));
+    text_line_t line;
+    size_t total = 0;
+    size_t max_line = 0;
     uint64_t idx;
     uint64_t size = mfu_flist_size(flist);
     for (idx = 0; idx < size; idx++) {
-        size_t count = print_file_text(flist, idx, NULL, 0);
-        bufsize += count + 1;
-    }
-
-    /* allocate a buffer big enough to hold all of the data */
-    char* buf = (char*) MFU_MALLOC(bufsize);
-
-    /* format data in buffer */
-    char* ptr = buf;
-    size_t total = 0;
-    for (idx = 0; idx < size; idx++) {
-        size_t count = print_file_text(flist, idx, ptr, bufsize - total);
+        size_t count = text_format_line(fmt, flist, idx, &line);
         total += count;
-        ptr += count;
+        if (count > max_line) {
+            max_line = count;
+        }
     }
 
-    /* if we block things up into 128MB chunks, how many iterations
-     * to write everything? */
-    uint64_t maxwrite = 128 * 1024 * 1024;
-    uint64_t iters = (uint64_t)total / maxwrite;
-    if (iters * maxwrite < (uint64_t)total) {
-        iters++;
+    /* format text in chunks, alternating between two buffers so we
+     * can fill one while the other is being written */
+    size_t bufsize = TEXT_CHUNK_BYTES;
+    if (bufsize < max_line) {
+        bufsize = max_line;
     }
-
-    /* get max iterations across all procs */
-    uint64_t all_iters;
-    MPI_Allreduce(&iters, &all_iters, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+    char* bufs[2];
+    bufs[0] = (char*) MFU_MALLOC(bufsize);
+    bufs[1] = (char*) MFU_MALLOC(bufsize);
+    MPI_Request reqs[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
 
     /* use mpi io hints to stripe across OSTs */
     MPI_Info info;
@@ -1735,7 +3375,6 @@ void mfu_flist_write_text(
     MPI_Info_set(info, "striping_factor", str_buf);
 
     /* open file */
-    MPI_Status status;
     MPI_File fh;
     const char* datarep = datarep_native;
     int amode = MPI_MODE_WRONLY | MPI_MODE_CREATE;
@@ -1764,39 +3403,40 @@ void mfu_flist_write_text(
     uint64_t offset = 0;
     uint64_t bytes = (uint64_t) total;
     MPI_Exscan(&bytes, &offset, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) {
+        offset = 0;
+    }
     MPI_Offset write_offset = (MPI_Offset)offset;
 
-    ptr = buf;
-    uint64_t written = 0;
-    while (all_iters > 0) {
-        /* compute number of bytes left to write */
-        uint64_t remaining = (uint64_t)total - written;
-
-        /* compute count we'll write in this iteration */
-        int write_count = (int) maxwrite;
-        if (remaining < maxwrite) {
-            write_count = (int) remaining;
+    /* our text is contiguous in the file, so each process writes its
+     * chunks independently as they fill */
+    int current = 0;
+    idx = 0;
+    while (idx < size) {
+        /* fill current buffer with whole lines */
+        size_t used = 0;
+        while (idx < size) {
+            size_t count = text_format_line(fmt, flist, idx, &line);
+            if (used + count > bufsize) {
+                break;
+            }
+            used += text_copy_line(&line, bufs[current] + used);
+            idx++;
         }
-    
-        /* collective write of file data */
-        mpirc = MPI_File_write_at_all(fh, write_offset, ptr, write_count, MPI_BYTE, &status);
+
+        /* start writing this chunk */
+        mpirc = MPI_File_iwrite_at(fh, write_offset, bufs[current], (int)used, MPI_BYTE, &reqs[current]);
         if (mpirc != MPI_SUCCESS) {
             MPI_Error_string(mpirc, mpierrstr, &mpierrlen);
             MFU_ABORT(1, "Failed to write to file: `%s' rc=%d %s", name, mpirc, mpierrstr);
         }
+        write_offset += (MPI_Offset) used;
 
-        /* update our offset into the file */
-        write_offset += (MPI_Offset) write_count;
-
-        /* update pointer into our buffer */
-        ptr += write_count;
-
-        /* update number of bytes written so far */
-        written += (uint64_t) write_count;
-
-        /* decrement our collective write loop counter */
-        all_iters--;
+        /* switch to the other buffer once its write is done */
+        current = 1 - current;
+        text_write_wait(name, &reqs[current]);
     }
+    text_write_wait(name, &reqs[1 - current]);
 
     /* close file */
     mpirc = MPI_File_close(&fh);
@@ -1808,8 +3448,10 @@ void mfu_flist_write_text(
     /* free mpi info */
     MPI_Info_free(&info);
 
-    /* free buffer */
-    mfu_free(&buf);
+    /* free buffers */
+    mfu_free(&bufs[1]);
+    mfu_free(&bufs[0]);
+    mfu_free(&fmt);
 
     /* end timer */
     double end_write = MPI_Wtime();
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h> /* makedev */
 #include <string.h>
 #include <unistd.h>
 #include <getopt.h>
@@ -32,6 +33,7 @@
 #include <string.h>
 
 #include <libgen.h> /* dirname */
+#include <pthread.h>
 
 #include "libcircle.h"
 #include "dtcmp.h"
@@ -52,6 +54,13 @@ static int SET_DIR_PERMS;
 static int REMOVE_FILES;
 static int DEREFERENCE;
 static mfu_file_t** CURRENT_PFILE;
+static int WALK_DIRFD;
+static unsigned int STAT_MASK;
+static int WALK_MAXDEPTH;
+static const mfu_pred* WALK_PRUNE;
+static strmap* WALK_BOUNDARY;
+static strmap* WALK_SEEDS;
+static strmap* WALK_PENDING;
 
 /****************************************
  * Global counter and callbacks for LIBCIRCLE reductions
@@ -122,6 +131,1008 @@ static int build_path(char* path, size_t path_len, const char* dir, const char*
     return 0;
 }
 
+/****************************************
+ * Cache of open directory file descriptors
+ ***************************************/
+
+/* When walking with directory file descriptors, items are accessed
+ * with openat/fstatat relative to their parent directory rather than
+ * by full path, which saves the kernel from resolving every component
+ * of every path.  Each process keeps a small cache of open directories,
+ * since the children of a directory are usually processed by the same
+ * process soon after the directory itself.  When the walk uses a pool
+ * of threads, each thread has its own cache so that a descriptor is
+ * never closed while another thread is using it. */
+
+/* number of directories each process keeps open */
+#define WALK_DIRFD_CACHE_SIZE (64)
+
+/* number of directories each thread keeps open, the process limit
+ * is split among the threads of the walk */
+static int walk_dirfd_limit = WALK_DIRFD_CACHE_SIZE;
+
+typedef struct {
+    char* name;    /* path of directory, NULL if entry is unused */
+    int fd;        /* open file descriptor of directory */
+    uint64_t used; /* clock value of last access */
+} walk_dirfd_entry;
+
+static __thread walk_dirfd_entry walk_dirfds[WALK_DIRFD_CACHE_SIZE];
+static __thread uint64_t walk_dirfd_clock;
+
+/* return file descriptor of directory if it is in the cache, -1 otherwise */
+static int walk_dirfd_lookup(const char* dir)
+{
+    int i;
+    for (i = 0; i < walk_dirfd_limit; i++) {
+        walk_dirfd_entry* entry = &walk_dirfds[i];
+        if (entry->name != NULL && strcmp(entry->name, dir) == 0) {
+            entry->used = ++walk_dirfd_clock;
+            return entry->fd;
+        }
+    }
+    return -1;
+}
+
+/* add an open directory to the cache, closing the least recently used
+ * directory if the cache is full */
+static void walk_dirfd_insert(const char* dir, int fd)
+{
+    walk_dirfd_entry* slot = NULL;
+    int i;
+    for (i = 0; i < walk_dirfd_limit; i++) {
+        walk_dirfd_entry* entry = &walk_dirfds[i];
+        if (entry->name == NULL) {
+            slot = entry;
+            break;
+        }
+        if (slot == NULL || entry->used < slot->used) {
+            slot = entry;
+        }
+    }
+
+    if (slot->name != NULL) {
+        mfu_close(slot->name, slot->fd);
+        mfu_free(&slot->name);
+    }
+
+    slot->name = MFU_STRDUP(dir);
+    slot->fd   = fd;
+    slot->used = ++walk_dirfd_clock;
+}
+
+/* close all directories in the cache of the calling thread */
+static void walk_dirfd_close_all(void)
+{
+    int i;
+    for (i = 0; i < walk_dirfd_limit; i++) {
+        walk_dirfd_entry* entry = &walk_dirfds[i];
+        if (entry->name != NULL) {
+            mfu_close(entry->name, entry->fd);
+            mfu_free(&entry->name);
+        }
+    }
+}
+
+/* split path into its parent directory, which is copied to parent,
+ * and its final component, which is returned, returns NULL if path
+ * has no parent we can open */
+static const char* walk_split_path(const char* path, char* parent, size_t parent_len)
+{
+    const char* slash = strrchr(path, '/');
+    if (slash == NULL || slash[1] == '\0') {
+        return NULL;
+    }
+
+    /* the parent of an item in the root directory is the root itself */
+    size_t len = (size_t)(slash - path);
+    if (len == 0) {
+        len = 1;
+    }
+    if (len >= parent_len) {
+        return NULL;
+    }
+
+    memcpy(parent, path, len);
+    parent[len] = '\0';
+    return slash + 1;
+}
+
+/* return an open file descriptor for directory, opened relative to its
+ * parent if the parent is in the cache, the descriptor is owned by the
+ * cache, returns -1 with errno set on error */
+static int walk_dirfd_open(const char* dir)
+{
+    int fd = walk_dirfd_lookup(dir);
+    if (fd >= 0) {
+        return fd;
+    }
+
+    int flags = O_RDONLY | O_DIRECTORY;
+
+    char parent[CIRCLE_MAX_STRING_LEN];
+    const char* name = walk_split_path(dir, parent, sizeof(parent));
+    int parent_fd = (name != NULL) ? walk_dirfd_lookup(parent) : -1;
+    if (parent_fd >= 0) {
+        fd = mfu_openat(parent_fd, name, flags);
+    } else {
+        fd = mfu_openat(AT_FDCWD, dir, flags);
+    }
+
+    if (fd >= 0) {
+        walk_dirfd_insert(dir, fd);
+    }
+    return fd;
+}
+
+/* open directory for reading, sets dirfd to a descriptor held in the
+ * cache that stays open while the directory is processed,
+ * the returned stream must be closed with closedir */
+static DIR* walk_dirfd_opendir(const char* dir, int* dirfd)
+{
+    *dirfd = walk_dirfd_open(dir);
+    if (*dirfd < 0) {
+        return NULL;
+    }
+
+    /* the stream takes ownership of the descriptor it is given,
+     * so give it a duplicate and keep the original in the cache */
+    int fd = dup(*dirfd);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    DIR* dirp = fdopendir(fd);
+    if (dirp == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    /* the duplicate shares its position with the cached descriptor */
+    rewinddir(dirp);
+
+    return dirp;
+}
+
+/* stat the item at path, when walking with directory file descriptors
+ * the item is looked up relative to its parent directory */
+static int walk_stat_path(const char* path, struct stat* st, int follow, mfu_file_t* mfu_file)
+{
+    if (WALK_DIRFD) {
+        char parent[CIRCLE_MAX_STRING_LEN];
+        const char* name = walk_split_path(path, parent, sizeof(parent));
+        int parent_fd = (name != NULL) ? walk_dirfd_open(parent) : -1;
+        if (parent_fd >= 0) {
+            int flags = follow ? 0 : AT_SYMLINK_NOFOLLOW;
+            return mfu_fstatat(parent_fd, name, st, flags);
+        }
+    }
+
+    if (follow) {
+        return mfu_file_stat(path, st, mfu_file);
+    }
+    return mfu_file_lstat(path, st, mfu_file);
+}
+
+/****************************************
+ * Pruning subtrees during the walk
+ ***************************************/
+
+/* return index of the longest walk path that contains path,
+ * or -1 if path is not under any walk path */
+static int walk_find_root(const char* path)
+{
+    int idx = -1;
+    size_t root_len = 0;
+    uint64_t i;
+    for (i = 0; i < CURRENT_NUM_DIRS; i++) {
+        const char* root = CURRENT_DIRS[i];
+        size_t len = strlen(root);
+        if (len <= root_len || strncmp(path, root, len) != 0) {
+            continue;
+        }
+        if (path[len] != '\0' && path[len] != '/' && root[len - 1] != '/') {
+            continue;
+        }
+        idx = (int) i;
+        root_len = len;
+    }
+    return idx;
+}
+
+/* return depth of path below the walk path it was found under,
+ * where the walk path itself has depth 0 */
+static int walk_rel_depth(const char* path)
+{
+    int depth = mfu_flist_compute_depth(path);
+
+    int root_depth = 0;
+    int idx = walk_find_root(path);
+    if (idx >= 0) {
+        /* don't count a trailing slash, as in "/" */
+        const char* root = CURRENT_DIRS[idx];
+        root_depth = mfu_flist_compute_depth(root);
+        if (root[strlen(root) - 1] == '/') {
+            root_depth--;
+        }
+    }
+
+    return depth - root_depth;
+}
+
+/* return 1 if the walk may read the entries of directory path based
+ * on its path alone, which is safe to call from any thread */
+static int walk_descend_path(const char* path)
+{
+    if (WALK_MAXDEPTH >= 0 && walk_rel_depth(path) >= WALK_MAXDEPTH) {
+        return 0;
+    }
+
+    /* entries of unchanged directories come from the previous list */
+    if (WALK_BOUNDARY != NULL && strmap_get(WALK_BOUNDARY, path) != NULL) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/* return 1 if the walk should read the entries of directory path,
+ * or 0 if it is deeper than the max depth, it matches the prune
+ * predicate, or its entries are reused from a previous list,
+ * the directory must be the last item in the list */
+static int walk_descend(const char* path)
+{
+    if (! walk_descend_path(path)) {
+        return 0;
+    }
+
+    if (WALK_PRUNE != NULL) {
+        uint64_t idx = mfu_flist_size(CURRENT_LIST) - 1;
+        if (mfu_pred_execute(CURRENT_LIST, idx, WALK_PRUNE) == 1) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/****************************************
+ * Reusing a previous list for unchanged directories
+ ***************************************/
+
+/* When given the list from a previous walk of the same paths, the walk
+ * only reads directories that changed since then.  A directory whose
+ * mtime and ctime are unchanged still holds the same entries, so those
+ * entries are taken from the previous list instead of being read again.
+ * Writing to a file does not change its directory, so entries that are
+ * not directories are stat'd again.  Reused directories keep the stat
+ * info of the previous walk, in which only the atime can be out of date.
+ *
+ * Each process stats the directories it holds in the previous list,
+ * and the paths of changed directories are shared with all processes.
+ * This set is normally small, and from it each process decides locally
+ * which of its items to reuse:
+ *   - items whose parent is unchanged are copied to the new list
+ *   - changed directories whose parent is unchanged are walked again
+ *     (seeds), starting from a fresh stat
+ *   - unchanged directories found while reading a changed directory
+ *     are not read again (boundary), since their entries are reused */
+
+/* gather key/value pairs of all processes into map on every process */
+static void walk_allgather_map(const strmap* local, strmap* map)
+{
+    /* pack our pairs as key and value strings */
+    size_t bytes = 0;
+    const strmap_node* node;
+    strmap_foreach(local, node) {
+        bytes += strlen(strmap_node_key(node)) + 1;
+        bytes += strlen(strmap_node_value(node)) + 1;
+    }
+
+    char* buf = (char*) MFU_MALLOC(bytes);
+    char* ptr = buf;
+    strmap_foreach(local, node) {
+        strcpy(ptr, strmap_node_key(node));
+        ptr += strlen(ptr) + 1;
+        strcpy(ptr, strmap_node_value(node));
+        ptr += strlen(ptr) + 1;
+    }
+
+    /* exchange sizes and compute displacements */
+    int ranks;
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    int* counts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* disps  = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int count = (int) bytes;
+    MPI_Allgather(&count, 1, MPI_INT, counts, 1, MPI_INT, MPI_COMM_WORLD);
+
+    size_t total = 0;
+    int i;
+    for (i = 0; i < ranks; i++) {
+        disps[i] = (int) total;
+        total += (size_t) counts[i];
+    }
+
+    char* all = (char*) MFU_MALLOC(total);
+    MPI_Allgatherv(buf, count, MPI_CHAR, all, counts, disps, MPI_CHAR, MPI_COMM_WORLD);
+
+    /* insert pairs into map */
+    ptr = all;
+    while (ptr < all + total) {
+        const char* key = ptr;
+        ptr += strlen(ptr) + 1;
+        const char* value = ptr;
+        ptr += strlen(ptr) + 1;
+        strmap_set(map, key, value);
+    }
+
+    mfu_free(&all);
+    mfu_free(&disps);
+    mfu_free(&counts);
+    mfu_free(&buf);
+}
+
+/* copy items of the previous list that can be reused into the current
+ * list, and set up the seed and boundary sets for the walk */
+static void walk_reuse_prepare(mfu_flist prev, mfu_file_t* mfu_file)
+{
+    /* stat our directories in the previous list to find those that changed,
+     * value is "1" if the item still exists and "0" otherwise */
+    strmap* local = strmap_new();
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(prev);
+    for (idx = 0; idx < size; idx++) {
+        if (mfu_flist_file_get_type(prev, idx) != MFU_TYPE_DIR) {
+            continue;
+        }
+
+        const char* name = mfu_flist_file_get_name(prev, idx);
+        if (walk_find_root(name) < 0) {
+            continue;
+        }
+
+        struct stat st;
+        if (mfu_file_lstat(name, &st, mfu_file) != 0) {
+            strmap_set(local, name, "0");
+            continue;
+        }
+
+        uint64_t mtime, mtime_nsec, ctime, ctime_nsec;
+        mfu_stat_get_mtimes(&st, &mtime, &mtime_nsec);
+        mfu_stat_get_ctimes(&st, &ctime, &ctime_nsec);
+        if (! S_ISDIR(st.st_mode) ||
+            mtime      != mfu_flist_file_get_mtime(prev, idx)      ||
+            mtime_nsec != mfu_flist_file_get_mtime_nsec(prev, idx) ||
+            ctime      != mfu_flist_file_get_ctime(prev, idx)      ||
+            ctime_nsec != mfu_flist_file_get_ctime_nsec(prev, idx))
+        {
+            strmap_set(local, name, "1");
+        }
+    }
+
+    strmap* changed = strmap_new();
+    walk_allgather_map(local, changed);
+    strmap_delete(&local);
+
+    /* copy items whose parent is unchanged, and note unchanged
+     * directories that the walk will find in changed directories */
+    local = strmap_new();
+    uint64_t reused = 0;
+    for (idx = 0; idx < size; idx++) {
+        const char* name = mfu_flist_file_get_name(prev, idx);
+        int root = walk_find_root(name);
+        if (root < 0) {
+            continue;
+        }
+
+        int is_dir = (mfu_flist_file_get_type(prev, idx) == MFU_TYPE_DIR);
+        int is_changed = (strmap_get(changed, name) != NULL);
+
+        /* the walk always stats the paths themselves */
+        char parent[CIRCLE_MAX_STRING_LEN];
+        const char* base = walk_split_path(name, parent, sizeof(parent));
+        if (strcmp(name, CURRENT_DIRS[root]) == 0 || base == NULL) {
+            if (is_dir && !is_changed) {
+                strmap_set(local, name, "1");
+            }
+            continue;
+        }
+
+        if (strmap_get(changed, parent) != NULL) {
+            /* parent changed, so the walk reads it and finds this item */
+            if (is_dir && !is_changed) {
+                strmap_set(local, name, "1");
+            }
+            continue;
+        }
+
+        /* changed items of unchanged directories are walked as seeds */
+        if (is_changed) {
+            continue;
+        }
+
+        if (is_dir) {
+            /* timestamps of directories were checked above */
+            mfu_flist_file_copy(prev, idx, (mfu_flist) CURRENT_LIST);
+        } else {
+            /* file contents and attributes may change without
+             * changing the directory, so refresh its stat info */
+            struct stat st;
+            if (walk_stat_path(name, &st, DEREFERENCE, mfu_file) != 0) {
+                MFU_LOG(MFU_LOG_ERR, "Failed to stat: '%s' (errno=%d %s)",
+                        name, errno, strerror(errno));
+                continue;
+            }
+            mfu_flist_insert_stat(CURRENT_LIST, name, st.st_mode, &st);
+        }
+        reused++;
+    }
+
+    WALK_BOUNDARY = strmap_new();
+    walk_allgather_map(local, WALK_BOUNDARY);
+    strmap_delete(&local);
+
+    /* changed directories that still exist and whose parent is unchanged
+     * are walked again, the walk reaches the others from their parent */
+    WALK_SEEDS = strmap_new();
+    const strmap_node* node;
+    strmap_foreach(changed, node) {
+        const char* name = strmap_node_key(node);
+        if (strcmp(strmap_node_value(node), "1") != 0) {
+            continue;
+        }
+        int root = walk_find_root(name);
+        char parent[CIRCLE_MAX_STRING_LEN];
+        const char* base = walk_split_path(name, parent, sizeof(parent));
+        if (root < 0 || strcmp(name, CURRENT_DIRS[root]) == 0 || base == NULL) {
+            continue;
+        }
+        if (strmap_get(changed, parent) == NULL) {
+            strmap_set(WALK_SEEDS, name, "1");
+        }
+    }
+
+    /* report how much of the previous list we reused */
+    uint64_t all_reused;
+    MPI_Allreduce(&reused, &all_reused, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (mfu_debug_level >= MFU_LOG_VERBOSE && mfu_rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "Reusing %llu items, %llu directories changed",
+            (unsigned long long) all_reused, (unsigned long long) strmap_size(changed));
+    }
+
+    /* count reused items in walk progress */
+    reduce_items += reused;
+
+    strmap_delete(&changed);
+}
+
+/* free sets used to reuse a previous list */
+static void walk_reuse_free(void)
+{
+    if (WALK_BOUNDARY != NULL) {
+        strmap_delete(&WALK_BOUNDARY);
+    }
+    if (WALK_SEEDS != NULL) {
+        strmap_delete(&WALK_SEEDS);
+    }
+}
+
+/****************************************
+ * Checkpointing and resuming a walk
+ ***************************************/
+
+/* When checkpointing, each process periodically appends the items it
+ * added to its list since its last checkpoint to its own part file,
+ * <prefix>.<rank>.  Processes do this independently between items,
+ * so the work queue can't be saved consistently: items may be in
+ * flight between processes at any time.  Instead, a resumed walk
+ * rebuilds its queue from the recorded items.  Every item not yet
+ * recorded is either a walk path or the entry of a directory that is
+ * recorded or not yet found, so the walk continues from the entries
+ * of recorded directories that are not recorded themselves.
+ *
+ * To decide this locally, recorded items are sent to the process
+ * that owns their parent directory, and recorded directories to the
+ * process that owns the directory itself.  Parts are written at
+ * different times, so an item may be recorded while its parent is
+ * not.  Walking the parent again would record the item twice, so
+ * such items and everything below them are dropped and found again. */
+
+static char walk_ckpt_name[PATH_MAX]; /* name of our part file */
+static int walk_ckpt_enabled;         /* set if checkpoints are written */
+static double walk_ckpt_secs;         /* seconds between checkpoints */
+static double walk_ckpt_next;         /* time of next checkpoint */
+static elem_t* walk_ckpt_tail;        /* last item written to part file */
+static int walk_ckpt_failed;          /* set if last write of part file failed */
+
+/* build name of part file of a given rank */
+static int walk_ckpt_part_name(char* name, size_t len, const char* prefix, int rank)
+{
+    int rc = snprintf(name, len, "%s.%d", prefix, rank);
+    if (rc < 0 || (size_t)rc >= len) {
+        return -1;
+    }
+    return 0;
+}
+
+/* write items of our list not yet in our part file,
+ * or all items if truncate is set */
+static void walk_ckpt_write(int truncate)
+{
+    /* rewrite the whole file if we failed to write it last time,
+     * since it may not have been restored to its previous state */
+    if (walk_ckpt_failed) {
+        truncate = 1;
+    }
+
+    const elem_t* start = CURRENT_LIST->list_head;
+    if (! truncate && walk_ckpt_tail != NULL) {
+        start = walk_ckpt_tail->next;
+    }
+
+    if (truncate || start != NULL) {
+        int rc = mfu_flist_write_part(walk_ckpt_name, truncate, CURRENT_LIST->detail, start);
+        if (rc == 0) {
+            walk_ckpt_tail = CURRENT_LIST->list_tail;
+        }
+        walk_ckpt_failed = (rc != 0);
+    }
+
+    walk_ckpt_next = MPI_Wtime() + walk_ckpt_secs;
+}
+
+/* write a checkpoint if it is time for one */
+static void walk_ckpt_check(void)
+{
+    if (walk_ckpt_enabled && MPI_Wtime() >= walk_ckpt_next) {
+        walk_ckpt_write(0);
+    }
+}
+
+/* write all items currently in the list to our part file,
+ * and remove part files left by a larger job */
+static void walk_ckpt_start(const char* prefix, int secs)
+{
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    walk_ckpt_enabled = 0;
+    walk_ckpt_tail    = NULL;
+    walk_ckpt_failed  = 0;
+    walk_ckpt_secs    = (double) secs;
+    if (walk_ckpt_part_name(walk_ckpt_name, sizeof(walk_ckpt_name), prefix, rank) != 0) {
+        MFU_LOG(MFU_LOG_ERR, "Checkpoint file name too long: '%s'", prefix);
+        return;
+    }
+    walk_ckpt_enabled = 1;
+
+    walk_ckpt_write(1);
+
+    /* wait until all parts are written before removing stale ones */
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank == 0) {
+        int i;
+        for (i = ranks; ; i++) {
+            char name[PATH_MAX];
+            if (walk_ckpt_part_name(name, sizeof(name), prefix, i) != 0 || unlink(name) != 0) {
+                break;
+            }
+        }
+    }
+}
+
+/* return rank of process owning the parent directory of path if
+ * by_parent is set, or the process owning path itself otherwise */
+static int walk_resume_key_rank(const char* path, int by_parent, int ranks)
+{
+    char parent[CIRCLE_MAX_STRING_LEN];
+    const char* key = path;
+    if (by_parent && walk_split_path(path, parent, sizeof(parent)) != NULL) {
+        key = parent;
+    }
+    uint32_t hash = mfu_hash_jenkins(key, strlen(key));
+    return (int)(hash % (uint32_t)ranks);
+}
+
+/* map function to send item to the process owning its parent directory,
+ * or the process owning the item itself if args is NULL */
+static int map_resume(mfu_flist flist, uint64_t idx, int ranks, const void* args)
+{
+    const char* name = mfu_flist_file_get_name(flist, idx);
+    return walk_resume_key_rank(name, (args != NULL), ranks);
+}
+
+/* return 1 if path or one of its parents up to its walk path is in map */
+static int walk_resume_dropped(const char* path, const strmap* dropped)
+{
+    if (strmap_size(dropped) == 0) {
+        return 0;
+    }
+
+    int root = walk_find_root(path);
+    char buf[CIRCLE_MAX_STRING_LEN];
+    strncpy(buf, path, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    while (1) {
+        if (strmap_get(dropped, buf) != NULL) {
+            return 1;
+        }
+        if (root < 0 || strcmp(buf, CURRENT_DIRS[root]) == 0) {
+            return 0;
+        }
+        char parent[CIRCLE_MAX_STRING_LEN];
+        if (walk_split_path(buf, parent, sizeof(parent)) == NULL || strcmp(parent, buf) == 0) {
+            return 0;
+        }
+        strcpy(buf, parent);
+    }
+}
+
+/* read part files written under prefix, copy recorded items into the
+ * current list, and set up the items each process enqueues to
+ * continue the walk */
+static void walk_resume_prepare(const char* prefix, mfu_file_t* mfu_file)
+{
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* count part files, which may have been written by more
+     * or fewer processes than we have now */
+    int parts = 0;
+    if (rank == 0) {
+        while (1) {
+            char name[PATH_MAX];
+            if (walk_ckpt_part_name(name, sizeof(name), prefix, parts) != 0 ||
+                mfu_access(name, R_OK) != 0)
+            {
+                break;
+            }
+            parts++;
+        }
+        if (parts == 0) {
+            MFU_LOG(MFU_LOG_WARN, "No checkpoint files found for '%s', walking all items", prefix);
+        }
+    }
+    MPI_Bcast(&parts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    /* read our share of the part files */
+    mfu_flist ckpt = mfu_flist_new();
+    int i;
+    for (i = rank; i < parts; i += ranks) {
+        char name[PATH_MAX];
+        walk_ckpt_part_name(name, sizeof(name), prefix, i);
+        mfu_flist_read_part(name, (flist_t*) ckpt);
+    }
+    ((flist_t*) ckpt)->detail = 1;
+    mfu_flist_summarize(ckpt);
+
+    /* gather each directory with its recorded entries */
+    mfu_flist dirs = mfu_flist_subset(ckpt);
+    uint64_t idx;
+    uint64_t size = mfu_flist_size(ckpt);
+    for (idx = 0; idx < size; idx++) {
+        if (mfu_flist_file_get_type(ckpt, idx) == MFU_TYPE_DIR) {
+            mfu_flist_file_copy(ckpt, idx, dirs);
+        }
+    }
+    mfu_flist_summarize(dirs);
+
+    int by_parent = 1;
+    mfu_flist entries = mfu_flist_remap(ckpt, map_resume, &by_parent);
+    mfu_flist owned   = mfu_flist_remap(dirs, map_resume, NULL);
+    mfu_flist_free(&dirs);
+    mfu_flist_free(&ckpt);
+
+    strmap* recorded_dirs = strmap_new();
+    size = mfu_flist_size(owned);
+    for (idx = 0; idx < size; idx++) {
+        strmap_set(recorded_dirs, mfu_flist_file_get_name(owned, idx), "1");
+    }
+
+    /* find directories recorded without their parent */
+    strmap* local = strmap_new();
+    size = mfu_flist_size(entries);
+    for (idx = 0; idx < size; idx++) {
+        const char* name = mfu_flist_file_get_name(entries, idx);
+        int root = walk_find_root(name);
+        if (root < 0 || strcmp(name, CURRENT_DIRS[root]) == 0) {
+            continue;
+        }
+        char parent[CIRCLE_MAX_STRING_LEN];
+        if (walk_split_path(name, parent, sizeof(parent)) != NULL &&
+            strmap_get(recorded_dirs, parent) == NULL &&
+            mfu_flist_file_get_type(entries, idx) == MFU_TYPE_DIR)
+        {
+            strmap_set(local, name, "1");
+        }
+    }
+    strmap* dropped = strmap_new();
+    walk_allgather_map(local, dropped);
+    strmap_delete(&local);
+
+    /* copy items whose parents are all recorded into the list */
+    strmap* seen = strmap_new();
+    uint64_t resumed = 0;
+    for (idx = 0; idx < size; idx++) {
+        const char* name = mfu_flist_file_get_name(entries, idx);
+        int root = walk_find_root(name);
+        if (root < 0) {
+            continue;
+        }
+        if (strcmp(name, CURRENT_DIRS[root]) != 0) {
+            char parent[CIRCLE_MAX_STRING_LEN];
+            if (walk_split_path(name, parent, sizeof(parent)) == NULL ||
+                strmap_get(recorded_dirs, parent) == NULL)
+            {
+                continue;
+            }
+        }
+        if (walk_resume_dropped(name, dropped) || strmap_get(seen, name) != NULL) {
+            continue;
+        }
+        strmap_set(seen, name, "1");
+        mfu_flist_file_copy(entries, idx, (mfu_flist) CURRENT_LIST);
+        resumed++;
+    }
+    strmap_delete(&recorded_dirs);
+
+    /* walk paths that were not recorded are walked again */
+    WALK_PENDING = strmap_new();
+    uint64_t r;
+    for (r = 0; r < CURRENT_NUM_DIRS; r++) {
+        const char* path = CURRENT_DIRS[r];
+        if (walk_resume_key_rank(path, 1, ranks) == rank && strmap_get(seen, path) == NULL) {
+            strmap_set(WALK_PENDING, path, "1");
+        }
+    }
+
+    /* read each recorded directory to find entries still to be walked */
+    strmap* read = strmap_new();
+    size = mfu_flist_size(owned);
+    for (idx = 0; idx < size; idx++) {
+        const char* dir = mfu_flist_file_get_name(owned, idx);
+        if (walk_find_root(dir) < 0 || walk_resume_dropped(dir, dropped) ||
+            strmap_get(read, dir) != NULL)
+        {
+            continue;
+        }
+        strmap_set(read, dir, "1");
+
+        /* skip directories the walk would not descend into */
+        if (! walk_descend_path(dir)) {
+            continue;
+        }
+        if (WALK_PRUNE != NULL && mfu_pred_execute(owned, idx, WALK_PRUNE) == 1) {
+            continue;
+        }
+
+        DIR* dirp = mfu_file_opendir(dir, mfu_file);
+        if (dirp == NULL) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to open directory with opendir: '%s' (errno=%d %s)",
+                    dir, errno, strerror(errno));
+            continue;
+        }
+        while (1) {
+            struct dirent* entry = mfu_file_readdir(dirp, mfu_file);
+            if (entry == NULL) {
+                break;
+            }
+
+            /* We don't care about . or .. */
+            char* name = entry->d_name;
+            if ((strncmp(name, ".", 2)) && (strncmp(name, "..", 3))) {
+                char newpath[CIRCLE_MAX_STRING_LEN];
+                int rc = build_path(newpath, CIRCLE_MAX_STRING_LEN, dir, name);
+                if (rc == 0 && strmap_get(seen, newpath) == NULL) {
+                    strmap_set(WALK_PENDING, newpath, "1");
+                }
+            }
+        }
+        mfu_file_closedir(dirp, mfu_file);
+    }
+    strmap_delete(&read);
+
+    /* report how much of the walk we resumed */
+    uint64_t counts[2], all_counts[2];
+    counts[0] = resumed;
+    counts[1] = (uint64_t) strmap_size(WALK_PENDING);
+    MPI_Allreduce(counts, all_counts, 2, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (mfu_debug_level >= MFU_LOG_VERBOSE && mfu_rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "Resuming with %llu items, %llu items left to walk",
+            (unsigned long long) all_counts[0], (unsigned long long) all_counts[1]);
+    }
+
+    /* count resumed items in walk progress */
+    reduce_items += resumed;
+
+    strmap_delete(&seen);
+    strmap_delete(&dropped);
+    mfu_flist_free(&owned);
+    mfu_flist_free(&entries);
+}
+
+/* free the set of items to continue a walk from */
+static void walk_resume_free(void)
+{
+    if (WALK_PENDING != NULL) {
+        strmap_delete(&WALK_PENDING);
+    }
+}
+
+/****************************************
+ * Splitting large directories across processes
+ ***************************************/
+
+/* A directory is normally read from start to end by the process that
+ * dequeued it.  So that a directory with millions of entries is shared
+ * among processes, a process reads at most WALK_SPLIT entries and then
+ * enqueues a continuation item, which names the directory and the
+ * position from which to resume reading.  Any process may dequeue it,
+ * since positions from telldir and getdents64 are file system cookies
+ * that are valid in any process that opens the same directory. */
+
+/* default number of entries read before handing off the rest */
+#define WALK_SPLIT_DEFAULT (100000)
+
+/* first character of a continuation item, which can't start a path */
+#define WALK_SPLIT_MARK '\001'
+
+static uint64_t WALK_SPLIT;
+
+/* enqueue an item to continue reading dir from position cookie,
+ * returns 0 on success and -1 if the item does not fit */
+static int walk_split_enqueue(CIRCLE_handle* handle, const char* dir, long cookie)
+{
+    char item[CIRCLE_MAX_STRING_LEN];
+    int len = snprintf(item, sizeof(item), "%c%ld:%s", WALK_SPLIT_MARK, cookie, dir);
+    if (len < 0 || (size_t)len >= sizeof(item)) {
+        return -1;
+    }
+    handle->enqueue(item);
+    return 0;
+}
+
+/* if item is a continuation, return the name of its directory and set
+ * cookie to the position to resume from, otherwise return NULL */
+static char* walk_split_decode(char* item, long* cookie)
+{
+    if (item[0] != WALK_SPLIT_MARK) {
+        return NULL;
+    }
+    char* end;
+    *cookie = strtol(item + 1, &end, 10);
+    return end + 1;
+}
+
+#ifdef STATX_TYPE
+/* set to 1 if statx returns ENOSYS so we stop trying it */
+static int WALK_STATX_NOSYS = 0;
+
+/* convert a mask of MFU_STAT bits to the statx fields that provide them */
+static unsigned int walk_statx_mask(unsigned int fields)
+{
+    unsigned int mask = STATX_TYPE | STATX_MODE;
+    if (fields & MFU_STAT_UID) {
+        mask |= STATX_UID;
+    }
+    if (fields & MFU_STAT_GID) {
+        mask |= STATX_GID;
+    }
+    if (fields & MFU_STAT_ATIME) {
+        mask |= STATX_ATIME;
+    }
+    if (fields & MFU_STAT_MTIME) {
+        mask |= STATX_MTIME;
+    }
+    if (fields & MFU_STAT_CTIME) {
+        mask |= STATX_CTIME;
+    }
+    if (fields & MFU_STAT_SIZE) {
+        mask |= STATX_SIZE;
+    }
+    if (fields & MFU_STAT_INO) {
+        mask |= STATX_INO | STATX_NLINK;
+    }
+    return mask;
+}
+
+/* lstat the item at path with statx, asking the file system for only
+ * the fields in STAT_MASK, sets valid to the MFU_STAT bits returned */
+static int walk_statx_path(const char* path, struct stat* st, unsigned int* valid)
+{
+    int dirfd = AT_FDCWD;
+    const char* name = path;
+
+    char parent[CIRCLE_MAX_STRING_LEN];
+    const char* base = walk_split_path(path, parent, sizeof(parent));
+    int parent_fd = (base != NULL) ? walk_dirfd_open(parent) : -1;
+    if (parent_fd >= 0) {
+        dirfd = parent_fd;
+        name  = base;
+    }
+
+    struct statx stx;
+    int rc = mfu_statx(dirfd, name, AT_SYMLINK_NOFOLLOW, walk_statx_mask(STAT_MASK), &stx);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* we at least need the file type */
+    if (!(stx.stx_mask & STATX_TYPE)) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    memset(st, 0, sizeof(*st));
+    st->st_mode  = (mode_t) stx.stx_mode;
+    st->st_uid   = (uid_t) stx.stx_uid;
+    st->st_gid   = (gid_t) stx.stx_gid;
+    st->st_size  = (off_t) stx.stx_size;
+    st->st_dev   = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    st->st_ino   = (ino_t) stx.stx_ino;
+    st->st_nlink = (nlink_t) stx.stx_nlink;
+    st->st_atim.tv_sec  = (time_t) stx.stx_atime.tv_sec;
+    st->st_atim.tv_nsec = (long) stx.stx_atime.tv_nsec;
+    st->st_mtim.tv_sec  = (time_t) stx.stx_mtime.tv_sec;
+    st->st_mtim.tv_nsec = (long) stx.stx_mtime.tv_nsec;
+    st->st_ctim.tv_sec  = (time_t) stx.stx_ctime.tv_sec;
+    st->st_ctim.tv_nsec = (long) stx.stx_ctime.tv_nsec;
+
+    /* record which fields the file system actually filled in */
+    unsigned int v = MFU_STAT_MODE;
+    if (stx.stx_mask & STATX_UID) {
+        v |= MFU_STAT_UID;
+    }
+    if (stx.stx_mask & STATX_GID) {
+        v |= MFU_STAT_GID;
+    }
+    if (stx.stx_mask & STATX_ATIME) {
+        v |= MFU_STAT_ATIME;
+    }
+    if (stx.stx_mask & STATX_MTIME) {
+        v |= MFU_STAT_MTIME;
+    }
+    if (stx.stx_mask & STATX_CTIME) {
+        v |= MFU_STAT_CTIME;
+    }
+    if (stx.stx_mask & STATX_SIZE) {
+        v |= MFU_STAT_SIZE;
+    }
+    if ((stx.stx_mask & STATX_INO) && (stx.stx_mask & STATX_NLINK)) {
+        v |= MFU_STAT_INO;
+    }
+    *valid = v;
+
+    return 0;
+}
+#endif /* STATX_TYPE */
+
+/* stat the item at path for the walk, when the caller only needs some
+ * of the stat fields, use statx so the file system can skip the rest,
+ * sets valid to the MFU_STAT bits that hold meaningful values */
+static int walk_stat_path_mask(const char* path, struct stat* st, unsigned int* valid, mfu_file_t* mfu_file)
+{
+#ifdef STATX_TYPE
+    if (STAT_MASK != MFU_STAT_ALL && !DEREFERENCE && WALK_DIRFD && !WALK_STATX_NOSYS) {
+        int rc = walk_statx_path(path, st, valid);
+        if (rc == 0) {
+            return rc;
+        }
+        if (errno == ENOSYS || errno == EOPNOTSUPP) {
+            /* no statx support, use a full stat from here on */
+            WALK_STATX_NOSYS = 1;
+        } else {
+            return rc;
+        }
+    }
+#endif
+
+    *valid = MFU_STAT_ALL;
+    return walk_stat_path(path, st, DEREFERENCE, mfu_file);
+}
+
 #ifdef LUSTRE_SUPPORT
 /****************************************
  * Walk directory tree using Lustre's MDS stat
@@ -168,38 +1179,74 @@ static void lustre_stripe_info(void* buf)
  * Walk directory tree using stat at top level and getdents system call
  ***************************************/
 
-struct linux_dirent {
-    long           d_ino;
-    off_t          d_off;
+#ifdef SYS_getdents64
+/* record layout returned by the getdents64 system call */
+struct linux_dirent64 {
+    uint64_t       d_ino;
+    int64_t        d_off;
     unsigned short d_reclen;
+    unsigned char  d_type;
     char           d_name[];
 };
 
-//#define BUF_SIZE 10*1024*1024
-#define BUF_SIZE 128*1024U
+/* initial and maximum size of buffer used to read directory entries,
+ * the buffer grows while we find directories with many entries */
+#define WALK_GETDENTS_MIN_SIZE (128 * 1024)
+#define WALK_GETDENTS_MAX_SIZE (8 * 1024 * 1024)
+
+static char* walk_getdents_buf = NULL;
+static size_t walk_getdents_size = 0;
 
-static void walk_getdents_process_dir(const char* dir, CIRCLE_handle* handle)
+/* free buffer used to read directory entries */
+static void walk_getdents_free(void)
 {
-    char buf[BUF_SIZE];
+    mfu_free(&walk_getdents_buf);
+    walk_getdents_size = 0;
+}
 
-    /* TODO: may need to try these functions multiple times */
-    mfu_file_t* mfu_file = *CURRENT_PFILE;
-    mfu_file_open(dir, O_RDONLY | O_DIRECTORY, mfu_file);
-    if (mfu_file->fd == -1) {
+static void walk_getdents_process_dir(const char* dir, long cookie, CIRCLE_handle* handle)
+{
+    if (walk_getdents_buf == NULL) {
+        walk_getdents_size = WALK_GETDENTS_MIN_SIZE;
+        walk_getdents_buf  = (char*) MFU_MALLOC(walk_getdents_size);
+    }
+
+    /* open directory, relative to its parent if we can */
+    int fd;
+    int close_fd = 0;
+    if (WALK_DIRFD) {
+        fd = walk_dirfd_open(dir);
+    } else {
+        fd = mfu_open(dir, O_RDONLY | O_DIRECTORY);
+        close_fd = 1;
+    }
+
+    /* the cached descriptor may have been read before, so always seek
+     * to the position we want to start from */
+    if (fd >= 0 && lseek(fd, (off_t)cookie, SEEK_SET) == (off_t)-1) {
+        if (close_fd) {
+            mfu_close(dir, fd);
+        }
+        fd = -1;
+    }
+    if (fd < 0) {
         /* print error */
         MFU_LOG(MFU_LOG_ERR, "Failed to open directory for reading: `%s' (errno=%d %s)", dir, errno, strerror(errno));
         return;
     }
 
-#if !defined(SYS_getdents) && defined(SYS_getdents64)
-#define SYS_getdents SYS_getdents64
-#endif
     /* Read all directory entries */
-    while (1) {
+    mfu_file_t* mfu_file = *CURRENT_PFILE;
+    uint64_t count = 0;
+    int split = 0;
+    while (! split) {
         /* execute system call to get block of directory entries */
-        int nread = syscall(SYS_getdents, mfu_file->fd, buf, (int) BUF_SIZE);
+        long nread = syscall(SYS_getdents64, fd, walk_getdents_buf, walk_getdents_size);
         if (nread == -1) {
-            MFU_LOG(MFU_LOG_ERR, "syscall to getdents failed when reading `%s' (errno=%d %s)", dir, errno, strerror(errno));
+            if (errno == EINTR) {
+                continue;
+            }
+            MFU_LOG(MFU_LOG_ERR, "syscall to getdents64 failed when reading `%s' (errno=%d %s)", dir, errno, strerror(errno));
             break;
         }
 
@@ -209,68 +1256,94 @@ static void walk_getdents_process_dir(const char* dir, CIRCLE_handle* handle)
         }
 
         /* otherwise, we read some bytes, so process each record */
-        int bpos = 0;
-        while (bpos < nread) {
+        long bpos = 0;
+        while (bpos < nread && ! split) {
             /* get pointer to current record */
-            struct linux_dirent* d = (struct linux_dirent*)(buf + bpos);
+            struct linux_dirent64* d = (struct linux_dirent64*)(walk_getdents_buf + bpos);
+
+            /* advance to next record */
+            bpos += d->d_reclen;
 
             /* get name of directory item, skip d_ino== 0, ".", and ".." entries */
             char* name = d->d_name;
-            if (d->d_ino != 0 && (strncmp(name, ".", 2)) && (strncmp(name, "..", 3))) {
-                /* check whether we can define path to item:
-                 * <dir> + '/' + <name> + '/0' */
-                char newpath[CIRCLE_MAX_STRING_LEN];
-                int rc = build_path(newpath, CIRCLE_MAX_STRING_LEN, dir, name);
-                if (rc == 0) {
-                    /* get type of item */
-                    char d_type = *(buf + bpos + d->d_reclen - 1);
-
-#if 0
-                    printf("%-10s ", (d_type == DT_REG) ?  "regular" :
-                           (d_type == DT_DIR) ?  "directory" :
-                           (d_type == DT_FIFO) ? "FIFO" :
-                           (d_type == DT_SOCK) ? "socket" :
-                           (d_type == DT_LNK) ?  "symlink" :
-                           (d_type == DT_BLK) ?  "block dev" :
-                           (d_type == DT_CHR) ?  "char dev" : "???");
-
-                    printf("%4d %10lld  %s\n", d->d_reclen,
-                           (long long) d->d_off, (char*) d->d_name);
-#endif
+            if (d->d_ino == 0 || !(strncmp(name, ".", 2)) || !(strncmp(name, "..", 3))) {
+                continue;
+            }
 
-                    /* TODO: this is hacky, would be better to create list elem directly */
-                    /* determine type of item (just need to set bits in mode
-                     * that get_mfu_filetype checks for) */
-                    mode_t mode = 0;
-                    if (d_type == DT_REG) {
-                        mode |= S_IFREG;
-                    }
-                    else if (d_type == DT_DIR) {
-                        mode |= S_IFDIR;
-                    }
-                    else if (d_type == DT_LNK) {
-                        mode |= S_IFLNK;
-                    }
+            /* check whether we can define path to item:
+             * <dir> + '/' + <name> + '/0' */
+            char newpath[CIRCLE_MAX_STRING_LEN];
+            int rc = build_path(newpath, CIRCLE_MAX_STRING_LEN, dir, name);
+            if (rc != 0) {
+                continue;
+            }
+
+            /* get type of item, stat it if the file system doesn't say */
+            mode_t mode;
+            struct stat st;
+            struct stat* sb = NULL;
+            if (d->d_type != DT_UNKNOWN) {
+                mode = DTTOIF(d->d_type);
+            } else {
+                int status;
+                if (WALK_DIRFD) {
+                    status = mfu_fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW);
+                } else {
+                    status = mfu_file_lstat(newpath, &st, mfu_file);
+                }
+                if (status != 0) {
+                    MFU_LOG(MFU_LOG_ERR, "Failed to stat: '%s' (errno=%d %s)",
+                            newpath, errno, strerror(errno));
+                    continue;
+                }
+                mode = st.st_mode;
+                sb = &st;
+            }
 
-                    /* insert a record for this item into our list */
-                    mfu_flist_insert_stat(CURRENT_LIST, newpath, mode, NULL);
+            if (REMOVE_FILES && !S_ISDIR(mode)) {
+                /* unlink files here if remove option is on */
+                if (WALK_DIRFD) {
+                    mfu_unlinkat(fd, name, 0);
+                } else {
+                    mfu_file_unlink(newpath, mfu_file);
+                }
+            } else {
+                /* insert a record for this item into our list */
+                mfu_flist_insert_stat(CURRENT_LIST, newpath, mode, sb);
+            }
 
-                    /* recurse on directory if we have one */
-                    if (d_type == DT_DIR) {
-                        handle->enqueue(newpath);
-                    } else {
-                        /* increment our item count */
-                        reduce_items++;
-                    }
+            /* recurse on directory if we have one */
+            if (S_ISDIR(mode) && walk_descend(newpath)) {
+                handle->enqueue(newpath);
+            } else {
+                /* increment our item count */
+                reduce_items++;
+            }
+
+            /* hand off the rest of a large directory */
+            count++;
+            if (WALK_SPLIT > 0 && count >= WALK_SPLIT) {
+                if (walk_split_enqueue(handle, dir, (long) d->d_off) == 0) {
+                    split = 1;
                 }
+                count = 0;
             }
+        }
 
-            /* advance to next record */
-            bpos += d->d_reclen;
+        /* if the directory filled most of the buffer, it likely has many
+         * more entries, so use a larger buffer to cut down on system calls */
+        if ((size_t)nread > walk_getdents_size / 2 &&
+            walk_getdents_size < WALK_GETDENTS_MAX_SIZE)
+        {
+            mfu_free(&walk_getdents_buf);
+            walk_getdents_size *= 2;
+            walk_getdents_buf = (char*) MFU_MALLOC(walk_getdents_size);
         }
     }
 
-    mfu_file_close(dir, mfu_file);
+    if (close_fd) {
+        mfu_close(dir, fd);
+    }
 
     return;
 }
@@ -299,8 +1372,8 @@ static void walk_getdents_create(CIRCLE_handle* handle)
         mfu_flist_insert_stat(CURRENT_LIST, path, st.st_mode, &st);
 
         /* recurse into directory */
-        if (S_ISDIR(st.st_mode)) {
-            walk_getdents_process_dir(path, handle);
+        if (S_ISDIR(st.st_mode) && walk_descend(path)) {
+            walk_getdents_process_dir(path, 0, handle);
         }
     }
 
@@ -313,20 +1386,43 @@ static void walk_getdents_process(CIRCLE_handle* handle)
     /* in this case, only items on queue are directories */
     char path[CIRCLE_MAX_STRING_LEN];
     handle->dequeue(path);
-    walk_getdents_process_dir(path, handle);
+
+    /* continue reading part of a large directory */
+    long cookie;
+    char* dir = walk_split_decode(path, &cookie);
+    if (dir != NULL) {
+        walk_getdents_process_dir(dir, cookie, handle);
+        return;
+    }
+
+    walk_getdents_process_dir(path, 0, handle);
     reduce_items++;
     return;
 }
+#endif /* SYS_getdents64 */
 
 /****************************************
  * Walk directory tree using stat at top level and readdir
  ***************************************/
 
-static void walk_readdir_process_dir(const char* dir, CIRCLE_handle* handle)
+/* open directory for reading, when walking with directory file
+ * descriptors, dirfd is set to a descriptor for the directory,
+ * otherwise it is set to -1 */
+static DIR* walk_opendir(const char* dir, int* dirfd, mfu_file_t* mfu_file)
+{
+    *dirfd = -1;
+    if (WALK_DIRFD) {
+        return walk_dirfd_opendir(dir, dirfd);
+    }
+    return mfu_file_opendir(dir, mfu_file);
+}
+
+static void walk_readdir_process_dir(const char* dir, long cookie, CIRCLE_handle* handle)
 {
     /* TODO: may need to try these functions multiple times */
     mfu_file_t* mfu_file = *CURRENT_PFILE;
-    DIR* dirp = mfu_file_opendir(dir, mfu_file);
+    int dirfd;
+    DIR* dirp = walk_opendir(dir, &dirfd, mfu_file);
 
     /* if there is a permissions error and the usr read & execute are being turned
      * on when walk_stat=0 then catch the permissions error and turn the bits on */
@@ -339,7 +1435,7 @@ static void walk_readdir_process_dir(const char* dir, CIRCLE_handle* handle)
             st.st_mode |= S_IRUSR;
             st.st_mode |= S_IXUSR;
             mfu_file_chmod(dir, st.st_mode, mfu_file);
-            dirp = mfu_file_opendir(dir, mfu_file);
+            dirp = walk_opendir(dir, &dirfd, mfu_file);
         }
     }
 
@@ -348,13 +1444,28 @@ static void walk_readdir_process_dir(const char* dir, CIRCLE_handle* handle)
                 dir, errno, strerror(errno));
     }
     else {
+        /* resume from where another process left off */
+        if (cookie != 0) {
+            seekdir(dirp, cookie);
+        }
+
         /* Read all directory entries */
+        uint64_t count = 0;
         while (1) {
+            /* hand off the rest of a large directory */
+            if (WALK_SPLIT > 0 && count >= WALK_SPLIT) {
+                if (walk_split_enqueue(handle, dir, telldir(dirp)) == 0) {
+                    break;
+                }
+                count = 0;
+            }
+
             /* read next directory entry */
             struct dirent* entry = mfu_file_readdir(dirp, mfu_file);
             if (entry == NULL) {
                 break;
             }
+            count++;
 
             /* process component, unless it's "." or ".." */
             char* name = entry->d_name;
@@ -371,7 +1482,11 @@ static void walk_readdir_process_dir(const char* dir, CIRCLE_handle* handle)
                         /* unlink files here if remove option is on,
                          * and dtype is known without a stat */
                         if (REMOVE_FILES && (entry->d_type != DT_DIR)) {
-                            mfu_file_unlink(newpath, mfu_file);
+                            if (dirfd >= 0) {
+                                mfu_unlinkat(dirfd, name, 0);
+                            } else {
+                                mfu_file_unlink(newpath, mfu_file);
+                            }
                         } else {
                             /* we can read object type from directory entry */
                             have_mode = 1;
@@ -382,14 +1497,23 @@ static void walk_readdir_process_dir(const char* dir, CIRCLE_handle* handle)
                     else {
                         /* type is unknown, we need to stat it */
                         struct stat st;
-                        int status = mfu_file_lstat(newpath, &st, mfu_file);
+                        int status;
+                        if (dirfd >= 0) {
+                            status = mfu_fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW);
+                        } else {
+                            status = mfu_file_lstat(newpath, &st, mfu_file);
+                        }
                         if (status == 0) {
                             have_mode = 1;
                             mode = st.st_mode;
                             /* unlink files here if remove option is on,
                              * and stat was necessary to get type */
                             if (REMOVE_FILES && !S_ISDIR(st.st_mode)) {
-                                mfu_file_unlink(newpath, mfu_file);
+                                if (dirfd >= 0) {
+                                    mfu_unlinkat(dirfd, name, 0);
+                                } else {
+                                    mfu_file_unlink(newpath, mfu_file);
+                                }
                             } else {
                                 mfu_flist_insert_stat(CURRENT_LIST, newpath, mode, &st);
                             }
@@ -401,7 +1525,7 @@ static void walk_readdir_process_dir(const char* dir, CIRCLE_handle* handle)
                     }
 
                     /* recurse into directories */
-                    if (have_mode && S_ISDIR(mode)) {
+                    if (have_mode && S_ISDIR(mode) && walk_descend(newpath)) {
                         handle->enqueue(newpath);
                     } else {
                         /* increment our item count */
@@ -415,157 +1539,612 @@ static void walk_readdir_process_dir(const char* dir, CIRCLE_handle* handle)
 
     mfu_file_closedir(dirp, mfu_file);
 
-    return;
+    return;
+}
+
+/** Call back given to initialize the dataset. */
+static void walk_readdir_create(CIRCLE_handle* handle)
+{
+    uint64_t i;
+    for (i = 0; i < CURRENT_NUM_DIRS; i++) {
+        const char* path = CURRENT_DIRS[i];
+
+        /* stat top level item */
+        struct stat st;
+        mfu_file_t* mfu_file = *CURRENT_PFILE;
+        int status = mfu_file_lstat(path, &st, mfu_file);
+        if (status != 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to stat: '%s' (errno=%d %s)",
+                    path, errno, strerror(errno));
+            return;
+        }
+
+        /* increment our item count */
+        reduce_items++;
+
+        /* record item info */
+        mfu_flist_insert_stat(CURRENT_LIST, path, st.st_mode, &st);
+
+        /* recurse into directory */
+        if (S_ISDIR(st.st_mode) && walk_descend(path)) {
+            walk_readdir_process_dir(path, 0, handle);
+        }
+    }
+
+    return;
+}
+
+/** Callback given to process the dataset. */
+static void walk_readdir_process(CIRCLE_handle* handle)
+{
+    /* in this case, only items on queue are directories */
+    char path[CIRCLE_MAX_STRING_LEN];
+    handle->dequeue(path);
+
+    /* continue reading part of a large directory */
+    long cookie;
+    char* dir = walk_split_decode(path, &cookie);
+    if (dir != NULL) {
+        walk_readdir_process_dir(dir, cookie, handle);
+        return;
+    }
+
+    walk_readdir_process_dir(path, 0, handle);
+    reduce_items++;
+    return;
+}
+
+/****************************************
+ * Walk directory tree using stat on every object
+ ***************************************/
+
+static void walk_stat_process_dir(const char* dir, long cookie, CIRCLE_handle* handle)
+{
+    /* TODO: may need to try these functions multiple times */
+    mfu_file_t* mfu_file = *CURRENT_PFILE;
+    int dirfd;
+    DIR* dirp = walk_opendir(dir, &dirfd, mfu_file);
+
+    if (! dirp) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open directory with opendir: '%s' (errno=%d %s)",
+                dir, errno, strerror(errno));
+    }
+    else {
+        /* resume from where another process left off */
+        if (cookie != 0) {
+            seekdir(dirp, cookie);
+        }
+
+        uint64_t count = 0;
+        while (1) {
+            /* hand off the rest of a large directory */
+            if (WALK_SPLIT > 0 && count >= WALK_SPLIT) {
+                if (walk_split_enqueue(handle, dir, telldir(dirp)) == 0) {
+                    break;
+                }
+                count = 0;
+            }
+
+            /* read next directory entry */
+            struct dirent* entry = mfu_file_readdir(dirp, mfu_file);
+            if (entry == NULL) {
+                break;
+            }
+            count++;
+
+            /* We don't care about . or .. */
+            char* name = entry->d_name;
+            if ((strncmp(name, ".", 2)) && (strncmp(name, "..", 3))) {
+                /* <dir> + '/' + <name> + '/0' */
+                char newpath[CIRCLE_MAX_STRING_LEN];
+                int rc = build_path(newpath, CIRCLE_MAX_STRING_LEN, dir, name);
+                if (rc == 0) {
+                    /* add item to queue */
+                    handle->enqueue(newpath);
+                }
+            }
+        }
+    }
+    mfu_file_closedir(dirp, mfu_file);
+    return;
+}
+
+/** Call back given to initialize the dataset. */
+static void walk_stat_create(CIRCLE_handle* handle)
+{
+    /* when resuming, each process enqueues the items it found left to walk */
+    if (WALK_PENDING != NULL) {
+        const strmap_node* node;
+        strmap_foreach(WALK_PENDING, node) {
+            handle->enqueue(strmap_node_key(node));
+        }
+        return;
+    }
+
+    uint64_t i;
+    for (i = 0; i < CURRENT_NUM_DIRS; i++) {
+        /* we'll call stat on every item */
+        const char* path = CURRENT_DIRS[i];
+        handle->enqueue((char*)path);
+    }
+
+    /* walk changed directories found in a previous list */
+    if (WALK_SEEDS != NULL) {
+        const strmap_node* node;
+        strmap_foreach(WALK_SEEDS, node) {
+            handle->enqueue(strmap_node_key(node));
+        }
+    }
+}
+
+/* turn on the usr read and execute bits of a directory if they are
+ * not already on, so that we can recurse into it */
+static void walk_set_dir_perms(const char* path, struct stat* st, mfu_file_t* mfu_file)
+{
+    /* use masks to check if usr_r and usr_x are already on */
+    long usr_r_mask = 1 << 8;
+    long usr_x_mask = 1 << 6;
+    /* turn on the usr read & execute bits if they are not already on*/
+    if (!((usr_r_mask & st->st_mode) && (usr_x_mask & st->st_mode))) {
+        st->st_mode |= S_IRUSR;
+        st->st_mode |= S_IXUSR;
+        mfu_file_chmod(path, st->st_mode, mfu_file);
+    }
+}
+
+/** Callback given to process the dataset. */
+static void walk_stat_process(CIRCLE_handle* handle)
+{
+    /* save items recorded so far if it's time */
+    walk_ckpt_check();
+
+    /* get path from queue */
+    char path[CIRCLE_MAX_STRING_LEN];
+    handle->dequeue(path);
+    mfu_file_t* mfu_file = *CURRENT_PFILE;
+
+    /* continue reading part of a large directory */
+    long cookie;
+    char* dir = walk_split_decode(path, &cookie);
+    if (dir != NULL) {
+        walk_stat_process_dir(dir, cookie, handle);
+        return;
+    }
+
+    /* stat item */
+    /* if symlink, stat the symlink value when dereferencing,
+     * otherwise stat the symlink itself */
+    struct stat st;
+    unsigned int valid;
+    int status = walk_stat_path_mask(path, &st, &valid, mfu_file);
+    if (status != 0) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to stat: '%s' (errno=%d %s)",
+                path, errno, strerror(errno));
+        return;
+    }
+
+    /* increment our item count */
+    reduce_items++;
+
+    /* TODO: filter items by stat info */
+
+    if (REMOVE_FILES && !S_ISDIR(st.st_mode)) {
+        mfu_file_unlink(path, mfu_file);
+    } else {
+        /* record info for item in list */
+        mfu_flist_insert_stat_valid(CURRENT_LIST, path, st.st_mode, &st, valid);
+    }
+
+    /* recurse into directory */
+    if (S_ISDIR(st.st_mode) && walk_descend(path)) {
+        /* before more processing check if SET_DIR_PERMS is set,
+         * and set usr read and execute bits if need be */
+        if (SET_DIR_PERMS) {
+            walk_set_dir_perms(path, &st, mfu_file);
+        }
+        /* TODO: check that we can recurse into directory */
+        walk_stat_process_dir(path, 0, handle);
+    }
+    return;
+}
+
+/****************************************
+ * Walk directory tree using stat on every object with a pool of threads
+ ***************************************/
+
+/* On file systems where each metadata operation is a round trip to a
+ * server, a single process issuing one stat at a time spends most of
+ * its time waiting.  In this mode, each libcircle callback takes a
+ * batch of items from the local queue and a pool of threads stats them
+ * and reads directories concurrently.  Only the main thread of a
+ * process touches libcircle and the file list, it records results and
+ * enqueues children after the whole batch is done. */
+
+/* number of items each thread works on per batch */
+#define WALK_THREAD_BATCH (8)
+
+typedef struct {
+    char path[CIRCLE_MAX_STRING_LEN];
+    char* dir;          /* directory to read, set if item is a continuation */
+    long cookie;        /* position to read dir from */
+    int more;           /* set if dir has entries left past cookie */
+    struct stat st;     /* stat info for item */
+    unsigned int valid; /* MFU_STAT bits set in st */
+    int status;         /* return code of stat */
+    int err;            /* errno if stat failed */
+    char* names;        /* names of entries if item is a directory */
+    size_t names_len;   /* number of bytes used in names */
+    size_t names_size;  /* number of bytes allocated for names */
+} walk_item_t;
+
+typedef struct {
+    int count;                /* number of threads, including main thread */
+    pthread_t* threads;       /* handles of helper threads */
+    pthread_mutex_t lock;     /* protects fields below */
+    pthread_cond_t work_cond; /* signals helpers that a batch is ready */
+    pthread_cond_t done_cond; /* signals main thread that helpers are done */
+    uint64_t generation;      /* incremented for each new batch */
+    int busy;                 /* number of helpers working on batch */
+    int shutdown;             /* set to tell helpers to exit */
+    walk_item_t* items;       /* items in current batch */
+    int nitems;               /* number of items in current batch */
+    int next;                 /* index of next item to be claimed */
+} walk_pool_t;
+
+static int WALK_THREADS;
+static walk_pool_t walk_pool;
+
+/* append a name to the list of entries of a directory item */
+static void walk_item_add_name(walk_item_t* item, const char* name)
+{
+    size_t len = strlen(name) + 1;
+    if (item->names_len + len > item->names_size) {
+        size_t size = item->names_size * 2;
+        if (size < item->names_len + len) {
+            size = item->names_len + len + 4096;
+        }
+        char* names = (char*) MFU_MALLOC(size);
+        if (item->names_len > 0) {
+            memcpy(names, item->names, item->names_len);
+        }
+        mfu_free(&item->names);
+        item->names      = names;
+        item->names_size = size;
+    }
+    memcpy(item->names + item->names_len, name, len);
+    item->names_len += len;
+}
+
+/* read entries of directory dir starting from position cookie into the
+ * list of names of item, stops after WALK_SPLIT entries and sets
+ * item->more and item->cookie if entries are left */
+static void walk_item_read_dir(walk_item_t* item, const char* dir, long cookie)
+{
+    mfu_file_t* mfu_file = *CURRENT_PFILE;
+    int dirfd;
+    DIR* dirp = walk_opendir(dir, &dirfd, mfu_file);
+    if (! dirp) {
+        MFU_LOG(MFU_LOG_ERR, "Failed to open directory with opendir: '%s' (errno=%d %s)",
+                dir, errno, strerror(errno));
+        return;
+    }
+
+    /* resume from where another process left off */
+    if (cookie != 0) {
+        seekdir(dirp, cookie);
+    }
+
+    uint64_t count = 0;
+    while (1) {
+        /* leave the rest of a large directory for a continuation */
+        if (WALK_SPLIT > 0 && count >= WALK_SPLIT) {
+            item->more   = 1;
+            item->cookie = telldir(dirp);
+            break;
+        }
+
+        /* read next directory entry */
+        struct dirent* entry = mfu_file_readdir(dirp, mfu_file);
+        if (entry == NULL) {
+            break;
+        }
+        count++;
+
+        /* We don't care about . or .. */
+        char* name = entry->d_name;
+        if ((strncmp(name, ".", 2)) && (strncmp(name, "..", 3))) {
+            walk_item_add_name(item, name);
+        }
+    }
+    mfu_file_closedir(dirp, mfu_file);
+}
+
+/* stat an item, and read its entries if it is a directory,
+ * this is called from any thread in the pool */
+static void walk_item_process(walk_item_t* item)
+{
+    mfu_file_t* mfu_file = *CURRENT_PFILE;
+
+    item->names_len = 0;
+    item->more      = 0;
+
+    /* continue reading part of a large directory */
+    long cookie;
+    item->dir = walk_split_decode(item->path, &cookie);
+    if (item->dir != NULL) {
+        item->status = 0;
+        walk_item_read_dir(item, item->dir, cookie);
+        return;
+    }
+
+    item->status = walk_stat_path_mask(item->path, &item->st, &item->valid, mfu_file);
+    if (item->status != 0) {
+        item->err = errno;
+        return;
+    }
+
+    if (REMOVE_FILES && !S_ISDIR(item->st.st_mode)) {
+        mfu_file_unlink(item->path, mfu_file);
+        return;
+    }
+
+    if (S_ISDIR(item->st.st_mode)) {
+        if (SET_DIR_PERMS) {
+            walk_set_dir_perms(item->path, &item->st, mfu_file);
+        }
+
+        /* the prune predicate needs the item in the list, so in that
+         * case the main thread decides whether to read the directory */
+        if (WALK_PRUNE == NULL && walk_descend_path(item->path)) {
+            walk_item_read_dir(item, item->path, 0);
+        }
+    }
+}
+
+/* claim and process items of the current batch until none are left */
+static void walk_pool_work(void)
+{
+    while (1) {
+        int idx = __sync_fetch_and_add(&walk_pool.next, 1);
+        if (idx >= walk_pool.nitems) {
+            break;
+        }
+        walk_item_process(&walk_pool.items[idx]);
+    }
+}
+
+/* main loop of helper threads */
+static void* walk_pool_thread(void* arg)
+{
+    uint64_t generation = 0;
+
+    pthread_mutex_lock(&walk_pool.lock);
+    while (1) {
+        /* wait for a new batch or for shutdown */
+        while (!walk_pool.shutdown && walk_pool.generation == generation) {
+            pthread_cond_wait(&walk_pool.work_cond, &walk_pool.lock);
+        }
+        if (walk_pool.shutdown) {
+            break;
+        }
+        generation = walk_pool.generation;
+        pthread_mutex_unlock(&walk_pool.lock);
+
+        walk_pool_work();
+
+        /* let the main thread know we're done with this batch */
+        pthread_mutex_lock(&walk_pool.lock);
+        walk_pool.busy--;
+        if (walk_pool.busy == 0) {
+            pthread_cond_signal(&walk_pool.done_cond);
+        }
+    }
+    pthread_mutex_unlock(&walk_pool.lock);
+
+    walk_dirfd_close_all();
+    return NULL;
 }
 
-/** Call back given to initialize the dataset. */
-static void walk_readdir_create(CIRCLE_handle* handle)
+/* start helper threads, the calling thread counts as one of them */
+static void walk_pool_start(int count)
 {
-    uint64_t i;
-    for (i = 0; i < CURRENT_NUM_DIRS; i++) {
-        const char* path = CURRENT_DIRS[i];
+    walk_pool.count      = count;
+    walk_pool.generation = 0;
+    walk_pool.busy       = 0;
+    walk_pool.shutdown   = 0;
+    walk_pool.nitems     = 0;
+    walk_pool.next       = 0;
+
+    size_t max_items = (size_t)count * WALK_THREAD_BATCH;
+    walk_pool.items = (walk_item_t*) MFU_MALLOC(max_items * sizeof(walk_item_t));
+    size_t i;
+    for (i = 0; i < max_items; i++) {
+        walk_pool.items[i].names      = NULL;
+        walk_pool.items[i].names_len  = 0;
+        walk_pool.items[i].names_size = 0;
+    }
 
-        /* stat top level item */
-        struct stat st;
-        mfu_file_t* mfu_file = *CURRENT_PFILE;
-        int status = mfu_file_lstat(path, &st, mfu_file);
-        if (status != 0) {
-            MFU_LOG(MFU_LOG_ERR, "Failed to stat: '%s' (errno=%d %s)",
-                    path, errno, strerror(errno));
-            return;
+    pthread_mutex_init(&walk_pool.lock, NULL);
+    pthread_cond_init(&walk_pool.work_cond, NULL);
+    pthread_cond_init(&walk_pool.done_cond, NULL);
+
+    walk_pool.threads = (pthread_t*) MFU_MALLOC((size_t)(count - 1) * sizeof(pthread_t));
+    int t;
+    for (t = 0; t < count - 1; t++) {
+        int rc = pthread_create(&walk_pool.threads[t], NULL, walk_pool_thread, NULL);
+        if (rc != 0) {
+            MFU_ABORT(-1, "Failed to create walk thread (errno=%d %s)",
+                rc, strerror(rc));
         }
+    }
+}
 
-        /* increment our item count */
-        reduce_items++;
-
-        /* record item info */
-        mfu_flist_insert_stat(CURRENT_LIST, path, st.st_mode, &st);
+/* stop helper threads and free the pool */
+static void walk_pool_stop(void)
+{
+    pthread_mutex_lock(&walk_pool.lock);
+    walk_pool.shutdown = 1;
+    pthread_cond_broadcast(&walk_pool.work_cond);
+    pthread_mutex_unlock(&walk_pool.lock);
+
+    int t;
+    for (t = 0; t < walk_pool.count - 1; t++) {
+        pthread_join(walk_pool.threads[t], NULL);
+    }
+    mfu_free(&walk_pool.threads);
 
-        /* recurse into directory */
-        if (S_ISDIR(st.st_mode)) {
-            walk_readdir_process_dir(path, handle);
-        }
+    size_t max_items = (size_t)walk_pool.count * WALK_THREAD_BATCH;
+    size_t i;
+    for (i = 0; i < max_items; i++) {
+        mfu_free(&walk_pool.items[i].names);
     }
+    mfu_free(&walk_pool.items);
 
-    return;
+    pthread_cond_destroy(&walk_pool.done_cond);
+    pthread_cond_destroy(&walk_pool.work_cond);
+    pthread_mutex_destroy(&walk_pool.lock);
 }
 
-/** Callback given to process the dataset. */
-static void walk_readdir_process(CIRCLE_handle* handle)
+/* process nitems items of the pool concurrently, returns once all are done */
+static void walk_pool_run(int nitems)
 {
-    /* in this case, only items on queue are directories */
-    char path[CIRCLE_MAX_STRING_LEN];
-    handle->dequeue(path);
-    walk_readdir_process_dir(path, handle);
-    reduce_items++;
-    return;
+    pthread_mutex_lock(&walk_pool.lock);
+    walk_pool.nitems = nitems;
+    walk_pool.next   = 0;
+    walk_pool.busy   = walk_pool.count - 1;
+    walk_pool.generation++;
+    pthread_cond_broadcast(&walk_pool.work_cond);
+    pthread_mutex_unlock(&walk_pool.lock);
+
+    /* help out with the batch */
+    walk_pool_work();
+
+    /* wait for helpers to finish */
+    pthread_mutex_lock(&walk_pool.lock);
+    while (walk_pool.busy > 0) {
+        pthread_cond_wait(&walk_pool.done_cond, &walk_pool.lock);
+    }
+    pthread_mutex_unlock(&walk_pool.lock);
 }
 
-/****************************************
- * Walk directory tree using stat on every object
- ***************************************/
-
-static void walk_stat_process_dir(char* dir, CIRCLE_handle* handle)
+/** Callback given to process the dataset with a pool of threads. */
+static void walk_stat_process_threaded(CIRCLE_handle* handle)
 {
-    /* TODO: may need to try these functions multiple times */
-    mfu_file_t* mfu_file = *CURRENT_PFILE;
-    DIR* dirp = mfu_file_opendir(dir, mfu_file);
+    /* save items recorded so far if it's time */
+    walk_ckpt_check();
+
+    /* take a batch of items from our local queue */
+    int max_items = walk_pool.count * WALK_THREAD_BATCH;
+    int nitems = 0;
+    do {
+        handle->dequeue(walk_pool.items[nitems].path);
+        nitems++;
+    } while (nitems < max_items && handle->local_queue_size() > 0);
+
+    /* stat items and read directories concurrently */
+    walk_pool_run(nitems);
+
+    /* record results and enqueue children from the main thread */
+    int i;
+    for (i = 0; i < nitems; i++) {
+        walk_item_t* item = &walk_pool.items[i];
+        if (item->status != 0) {
+            MFU_LOG(MFU_LOG_ERR, "Failed to stat: '%s' (errno=%d %s)",
+                    item->path, item->err, strerror(item->err));
+            continue;
+        }
 
-    if (! dirp) {
-        MFU_LOG(MFU_LOG_ERR, "Failed to open directory with opendir: '%s' (errno=%d %s)",
-                dir, errno, strerror(errno));
-    }
-    else {
-        while (1) {
-            /* read next directory entry */
-            struct dirent* entry = mfu_file_readdir(dirp, mfu_file);
-            if (entry == NULL) {
-                break;
+        const char* dir = item->dir;
+        if (dir == NULL) {
+            /* increment our item count */
+            reduce_items++;
+
+            if (! (REMOVE_FILES && !S_ISDIR(item->st.st_mode))) {
+                /* record info for item in list */
+                mfu_flist_insert_stat_valid(CURRENT_LIST, item->path, item->st.st_mode, &item->st, item->valid);
             }
 
-            /* We don't care about . or .. */
-            char* name = entry->d_name;
-            if ((strncmp(name, ".", 2)) && (strncmp(name, "..", 3))) {
-                /* <dir> + '/' + <name> + '/0' */
-                char newpath[CIRCLE_MAX_STRING_LEN];
-                int rc = build_path(newpath, CIRCLE_MAX_STRING_LEN, dir, name);
-                if (rc == 0) {
-                    /* add item to queue */
-                    handle->enqueue(newpath);
+            /* read directory in a later batch if it is not pruned */
+            if (WALK_PRUNE != NULL && S_ISDIR(item->st.st_mode) && walk_descend(item->path)) {
+                if (walk_split_enqueue(handle, item->path, 0) != 0) {
+                    MFU_LOG(MFU_LOG_ERR, "Failed to enqueue directory: '%s'", item->path);
                 }
             }
+
+            dir = item->path;
+        }
+
+        /* add entries of directory to queue */
+        size_t offset = 0;
+        while (offset < item->names_len) {
+            const char* name = item->names + offset;
+            offset += strlen(name) + 1;
+
+            /* <dir> + '/' + <name> + '/0' */
+            char newpath[CIRCLE_MAX_STRING_LEN];
+            int rc = build_path(newpath, CIRCLE_MAX_STRING_LEN, dir, name);
+            if (rc == 0) {
+                handle->enqueue(newpath);
+            }
+        }
+
+        /* hand off the rest of a large directory */
+        if (item->more) {
+            if (walk_split_enqueue(handle, dir, item->cookie) != 0) {
+                MFU_LOG(MFU_LOG_ERR, "Failed to continue reading directory: '%s'", dir);
+            }
         }
     }
-    mfu_file_closedir(dirp, mfu_file);
     return;
 }
 
-/** Call back given to initialize the dataset. */
-static void walk_stat_create(CIRCLE_handle* handle)
-{
-    uint64_t i;
-    for (i = 0; i < CURRENT_NUM_DIRS; i++) {
-        /* we'll call stat on every item */
-        const char* path = CURRENT_DIRS[i];
-        handle->enqueue((char*)path);
-    }
-}
+/* methods to read directories when walking without stat */
+typedef enum {
+    WALK_ENGINE_READDIR,  /* opendir/readdir from libc */
+    WALK_ENGINE_GETDENTS, /* getdents64 system call with a large buffer */
+} walk_engine_t;
 
-/** Callback given to process the dataset. */
-static void walk_stat_process(CIRCLE_handle* handle)
+/* select directory reader, which can be set via environment variable */
+static walk_engine_t select_walk_engine(mfu_file_t* mfu_file)
 {
-    /* get path from queue */
-    char path[CIRCLE_MAX_STRING_LEN];
-    handle->dequeue(path);
-    mfu_file_t* mfu_file = *CURRENT_PFILE;
+    walk_engine_t engine = WALK_ENGINE_READDIR;
 
-    /* stat item */
-    struct stat st;
-    int status;
-    if (DEREFERENCE) {
-        /* if symlink, stat the symlink value */
-        status = mfu_file_stat(path, &st, mfu_file);
-    } else {
-        /* if symlink, stat the symlink itself */
-        status = mfu_file_lstat(path, &st, mfu_file);
-    }
-    if (status != 0) {
-        MFU_LOG(MFU_LOG_ERR, "Failed to stat: '%s' (errno=%d %s)",
-                path, errno, strerror(errno));
-        return;
+    const char varname[] = "MFU_FLIST_WALK_ENGINE";
+    const char* value = getenv(varname);
+    if (value == NULL) {
+        return engine;
     }
 
-    /* increment our item count */
-    reduce_items++;
-
-    /* TODO: filter items by stat info */
-
-    if (REMOVE_FILES && !S_ISDIR(st.st_mode)) {
-        mfu_file_unlink(path, mfu_file);
+    if (strcmp(value, "READDIR") == 0) {
+        engine = WALK_ENGINE_READDIR;
+    } else if (strcmp(value, "GETDENTS") == 0) {
+#ifdef SYS_getdents64
+        if (mfu_file->type == POSIX) {
+            engine = WALK_ENGINE_GETDENTS;
+        } else {
+            if (mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_WARN, "%s: GETDENTS only supported for POSIX", varname);
+            }
+            value = "READDIR";
+        }
+#else
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "%s: GETDENTS not supported on this system", varname);
+        }
+        value = "READDIR";
+#endif
     } else {
-        /* record info for item in list */
-        mfu_flist_insert_stat(CURRENT_LIST, path, st.st_mode, &st);
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "%s: unknown value %s", varname, value);
+        }
+        value = "READDIR";
     }
 
-    /* recurse into directory */
-    if (S_ISDIR(st.st_mode)) {
-        /* before more processing check if SET_DIR_PERMS is set,
-         * and set usr read and execute bits if need be */
-        if (SET_DIR_PERMS) {
-            /* use masks to check if usr_r and usr_x are already on */
-            long usr_r_mask = 1 << 8;
-            long usr_x_mask = 1 << 6;
-            /* turn on the usr read & execute bits if they are not already on*/
-            if (!((usr_r_mask & st.st_mode) && (usr_x_mask & st.st_mode))) {
-                st.st_mode |= S_IRUSR;
-                st.st_mode |= S_IXUSR;
-                mfu_file_chmod(path, st.st_mode, mfu_file);
-            }
-        }
-        /* TODO: check that we can recurse into directory */
-        walk_stat_process_dir(path, handle);
+    if (mfu_rank == 0) {
+        MFU_LOG(MFU_LOG_INFO, "%s: %s", varname, value);
     }
-    return;
+
+    return engine;
 }
 
 /* Set up and execute directory walk */
@@ -578,6 +2157,32 @@ void mfu_flist_walk_path(const char* dirpath,
     return;
 }
 
+/* set WALK_DIRFD to decide whether items are looked up relative to
+ * open directories or by full path */
+static void walk_lookup_init(mfu_file_t* mfu_file)
+{
+    /* by default, access items relative to open directories,
+     * this is only supported for POSIX file systems */
+    WALK_DIRFD = (mfu_file->type == POSIX);
+
+    /* allow override of how items are looked up via environment variable */
+    char varname[] = "MFU_FLIST_WALK_LOOKUP";
+    const char* value = getenv(varname);
+    if (value != NULL) {
+        if (strcmp(value, "PATH") == 0) {
+            WALK_DIRFD = 0;
+        } else if (strcmp(value, "DIRFD") == 0) {
+            if (mfu_file->type != POSIX && mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_WARN, "%s: DIRFD only supported for POSIX, using PATH", varname);
+            }
+        } else {
+            if (mfu_rank == 0) {
+                MFU_LOG(MFU_LOG_ERR, "%s: Unknown value: %s", varname, value);
+            }
+        }
+    }
+}
+
 /* Set up and execute directory walk */
 void mfu_flist_walk_paths(uint64_t num_paths, const char** paths,
                           mfu_walk_opts_t* walk_opts, mfu_flist bflist,
@@ -604,6 +2209,17 @@ void mfu_flist_walk_paths(uint64_t num_paths, const char** paths,
         DEREFERENCE = 1;
     }
 
+    /* stat fields the caller needs from the walk, items can only be
+     * stat'd on demand later for POSIX, so collect everything otherwise */
+    STAT_MASK = walk_opts->stat_mask;
+    if (mfu_file->type != POSIX) {
+        STAT_MASK = MFU_STAT_ALL;
+    }
+
+    /* limit on depth and predicate for directories not to descend into */
+    WALK_MAXDEPTH = walk_opts->maxdepth;
+    WALK_PRUNE    = walk_opts->prune;
+
     /* convert handle to flist_t */
     flist_t* flist = (flist_t*) bflist;
 
@@ -620,8 +2236,22 @@ void mfu_flist_walk_paths(uint64_t num_paths, const char** paths,
         }
     }
 
-    /* initialize libcircle */
-    CIRCLE_init(0, NULL, CIRCLE_SPLIT_EQUAL | CIRCLE_TERM_TREE);
+    /* a walk can only be resumed from items recorded with stat */
+    int resume = 0;
+    if (walk_opts->resume != NULL) {
+        if (walk_opts->use_stat) {
+            resume = 1;
+        } else if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Resuming a walk needs stat info, walking all items");
+        }
+    }
+
+    /* initialize libcircle, when resuming every process seeds the queue */
+    int circle_flags = CIRCLE_SPLIT_EQUAL | CIRCLE_TERM_TREE;
+    if (resume) {
+        circle_flags |= CIRCLE_CREATE_GLOBAL;
+    }
+    CIRCLE_init(0, NULL, circle_flags);
 
     /* set libcircle verbosity level */
     enum CIRCLE_loglevel loglevel = CIRCLE_LOG_WARN;
@@ -648,24 +2278,128 @@ void mfu_flist_walk_paths(uint64_t num_paths, const char** paths,
         }
     }
 
+    /* select how items are looked up */
+    walk_lookup_init(mfu_file);
+
+    /* select how directories are read when not stating every item */
+    walk_engine_t walk_engine = WALK_ENGINE_READDIR;
+    if (! walk_opts->use_stat) {
+        walk_engine = select_walk_engine(mfu_file);
+    }
+
+    /* number of threads each process uses to stat items */
+    WALK_THREADS = walk_opts->threads;
+
+    /* allow override of thread count via environment variable */
+    char threads_varname[] = "MFU_FLIST_WALK_THREADS";
+    const char* threads_value = getenv(threads_varname);
+    if (threads_value != NULL) {
+        int threads = atoi(threads_value);
+        if (threads > 0) {
+            WALK_THREADS = threads;
+        } else if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "%s: Invalid value: %s", threads_varname, threads_value);
+        }
+    }
+
+    /* threads are only supported with the stat walk on POSIX */
+    if (WALK_THREADS > 1 && (!walk_opts->use_stat || mfu_file->type != POSIX)) {
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Walk threads only supported with stat on POSIX, using 1 thread");
+        }
+        WALK_THREADS = 1;
+    }
+    if (WALK_THREADS < 1) {
+        WALK_THREADS = 1;
+    }
+
+    /* by default, hand off the rest of a directory after this many
+     * entries, seek positions are only supported for POSIX */
+    WALK_SPLIT = WALK_SPLIT_DEFAULT;
+
+    /* allow override of split size via environment variable, 0 disables */
+    char split_varname[] = "MFU_FLIST_WALK_SPLIT";
+    const char* split_value = getenv(split_varname);
+    if (split_value != NULL) {
+        WALK_SPLIT = (uint64_t) strtoull(split_value, NULL, 10);
+    }
+    if (mfu_file->type != POSIX) {
+        WALK_SPLIT = 0;
+    }
+
+    /* split the directory cache among the threads */
+    walk_dirfd_limit = WALK_DIRFD_CACHE_SIZE / WALK_THREADS;
+    if (walk_dirfd_limit < 4) {
+        walk_dirfd_limit = 4;
+    }
+
     /* register callbacks */
     CURRENT_PFILE = &mfu_file;
-    if (walk_opts->use_stat) {
+    if (walk_opts->use_stat && WALK_THREADS > 1) {
+        /* walk directories by calling stat on every item from a pool of threads */
+        walk_pool_start(WALK_THREADS);
+        CIRCLE_cb_create(&walk_stat_create);
+        CIRCLE_cb_process(&walk_stat_process_threaded);
+    }
+    else if (walk_opts->use_stat) {
         /* walk directories by calling stat on every item */
         CIRCLE_cb_create(&walk_stat_create);
         CIRCLE_cb_process(&walk_stat_process);
     }
+#ifdef SYS_getdents64
+    else if (walk_engine == WALK_ENGINE_GETDENTS) {
+        /* walk directories using file types from getdents64 */
+        CIRCLE_cb_create(&walk_getdents_create);
+        CIRCLE_cb_process(&walk_getdents_process);
+    }
+#endif
     else {
         /* walk directories using file types in readdir */
         CIRCLE_cb_create(&walk_readdir_create);
         CIRCLE_cb_process(&walk_readdir_process);
-        //        CIRCLE_cb_create(&walk_getdents_create);
-        //        CIRCLE_cb_process(&walk_getdents_process);
     }
 
     /* prepare callbacks and initialize variables for reductions */
     reduce_start = start_walk;
     reduce_items = 0;
+
+    /* reuse entries of unchanged directories from a previous walk,
+     * this needs stat info for every item in both lists */
+    WALK_BOUNDARY = NULL;
+    WALK_SEEDS    = NULL;
+    WALK_PENDING  = NULL;
+    if (walk_opts->prev != NULL && resume) {
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring previous list when resuming a walk");
+        }
+    } else if (walk_opts->prev != NULL && (WALK_MAXDEPTH >= 0 || WALK_PRUNE != NULL)) {
+        /* entries are reused without regard to depth or pruning */
+        if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Ignoring previous list when limiting depth or pruning a walk");
+        }
+    } else if (walk_opts->prev != NULL) {
+        if (walk_opts->use_stat && mfu_flist_have_detail(walk_opts->prev)) {
+            walk_reuse_prepare(walk_opts->prev, mfu_file);
+        } else if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Previous list needs stat info for an incremental walk, walking all items");
+        }
+    }
+
+    /* continue from the items recorded by an interrupted walk */
+    if (resume) {
+        walk_resume_prepare(walk_opts->resume, mfu_file);
+    }
+
+    /* start checkpoints with the items we already have */
+    walk_ckpt_enabled = 0;
+    if (walk_opts->checkpoint != NULL) {
+        if (walk_opts->use_stat) {
+            walk_ckpt_start(walk_opts->checkpoint, walk_opts->checkpoint_secs);
+        } else if (mfu_rank == 0) {
+            MFU_LOG(MFU_LOG_WARN, "Checkpoints need stat info, not writing checkpoints");
+        }
+    }
+
     CIRCLE_cb_reduce_init(&reduce_init);
     CIRCLE_cb_reduce_op(&reduce_exec);
     CIRCLE_cb_reduce_fini(&reduce_fini);
@@ -681,6 +2415,32 @@ void mfu_flist_walk_paths(uint64_t num_paths, const char** paths,
     CIRCLE_begin();
     CIRCLE_finalize();
 
+    /* shut down threads, which close their own directories */
+    if (WALK_THREADS > 1) {
+        walk_pool_stop();
+    }
+
+#ifdef SYS_getdents64
+    /* free buffer used to read directory entries */
+    walk_getdents_free();
+#endif
+
+    /* close directories we kept open during the walk */
+    walk_dirfd_close_all();
+
+    /* free sets used to reuse a previous list */
+    walk_reuse_free();
+
+    /* record the complete list, so a job that dies after the walk
+     * can resume without walking again */
+    if (walk_ckpt_enabled) {
+        walk_ckpt_write(0);
+        walk_ckpt_enabled = 0;
+    }
+
+    /* free items used to resume a walk */
+    walk_resume_free();
+
     /* compute global summary */
     mfu_flist_summarize(bflist);
 
@@ -741,6 +2501,322 @@ void mfu_flist_walk_param_paths(uint64_t num,
     return;
 }
 
+/****************************************
+ * Stat items of an existing list
+ ***************************************/
+
+/* When a list is read from a file without stat info, each process
+ * would otherwise stat its items one at a time, and a list read from a
+ * file may be unevenly divided.  The names of items to be stat'd are
+ * sent so that each process stats an even share, with more than one
+ * thread per process on POSIX.  The results are then sent back, so each
+ * process inserts its own items into the output list in its own order,
+ * which keeps the distribution of the input list.  Items are exchanged
+ * in rounds of a bounded number of items per process, which limits the
+ * memory used for names and results and keeps message sizes within the
+ * int counts MPI takes. */
+
+/* max number of items each process sends to be stat'd in one round,
+ * which bounds the names and results exchanged in a round so that
+ * their byte counts fit in an int */
+#define STAT_ROUND_ITEMS (256 * 1024)
+
+typedef struct {
+    uint64_t idx; /* index of item in input list */
+    int follow;   /* whether to dereference symbolic links */
+} stat_todo_t;
+
+typedef struct {
+    int status;     /* return code of stat */
+    int err;        /* errno if stat failed */
+    struct stat st; /* stat info for item */
+} stat_result_t;
+
+typedef struct {
+    mfu_file_t* mfu_file;    /* I/O functions used to stat items */
+    const char** names;      /* names of items to stat */
+    const int* follow;       /* whether to dereference each item */
+    stat_result_t* results;  /* stat info for each item */
+    uint64_t count;          /* number of items */
+    pthread_mutex_t lock;    /* protects next */
+    uint64_t next;           /* index of next item to be claimed */
+} stat_pool_t;
+
+/* stat item i of the pool */
+static void stat_pool_item(stat_pool_t* pool, uint64_t i)
+{
+    stat_result_t* res = &pool->results[i];
+    res->status = walk_stat_path(pool->names[i], &res->st, pool->follow[i], pool->mfu_file);
+    res->err = (res->status != 0) ? errno : 0;
+}
+
+/* main loop of helper threads, claims items until all are taken */
+static void* stat_pool_thread(void* arg)
+{
+    stat_pool_t* pool = (stat_pool_t*) arg;
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        uint64_t i = pool->next;
+        pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (i >= pool->count) {
+            break;
+        }
+        stat_pool_item(pool, i);
+    }
+
+    walk_dirfd_close_all();
+    return NULL;
+}
+
+/* return number of items of a list with total items
+ * that precede those assigned to rank when split evenly */
+static uint64_t stat_share_start(uint64_t total, int ranks, int rank)
+{
+    uint64_t base = total / (uint64_t) ranks;
+    uint64_t rem  = total % (uint64_t) ranks;
+    uint64_t r    = (uint64_t) rank;
+    return r * base + (r < rem ? r : rem);
+}
+
+/* given a range of global indices [start, end) held by one process,
+ * compute number of those items assigned to each rank */
+static void stat_share_counts(uint64_t start, uint64_t end, uint64_t total,
+                              int ranks, uint64_t* counts)
+{
+    int i;
+    for (i = 0; i < ranks; i++) {
+        uint64_t lo = stat_share_start(total, ranks, i);
+        uint64_t hi = stat_share_start(total, ranks, i + 1);
+        if (lo < start) {
+            lo = start;
+        }
+        if (hi > end) {
+            hi = end;
+        }
+        counts[i] = (hi > lo) ? (hi - lo) : 0;
+    }
+}
+
+/* stat count items given their names and whether to dereference each,
+ * using a pool of threads if requested */
+static void stat_items(uint64_t count, const char** names, const int* follow,
+                       stat_result_t* results, mfu_file_t* mfu_file)
+{
+    /* use as many threads as the walk, which can be set via environment
+     * variable, threads are only supported on POSIX */
+    int threads = 1;
+    const char* threads_value = getenv("MFU_FLIST_WALK_THREADS");
+    if (threads_value != NULL && atoi(threads_value) > 0) {
+        threads = atoi(threads_value);
+    }
+    if (mfu_file->type != POSIX || (uint64_t)threads > count) {
+        threads = 1;
+    }
+
+    /* split the directory cache among the helper threads */
+    walk_dirfd_limit = WALK_DIRFD_CACHE_SIZE / threads;
+    if (walk_dirfd_limit < 4) {
+        walk_dirfd_limit = 4;
+    }
+
+    stat_pool_t pool;
+    pool.mfu_file = mfu_file;
+    pool.names    = names;
+    pool.follow   = follow;
+    pool.results  = results;
+    pool.count    = count;
+    pool.next     = 0;
+
+    if (threads > 1) {
+        pthread_mutex_init(&pool.lock, NULL);
+
+        pthread_t* handles = (pthread_t*) MFU_MALLOC((size_t)threads * sizeof(pthread_t));
+        int t;
+        for (t = 0; t < threads; t++) {
+            int rc = pthread_create(&handles[t], NULL, stat_pool_thread, &pool);
+            if (rc != 0) {
+                MFU_ABORT(-1, "Failed to create stat thread (errno=%d %s)",
+                    rc, strerror(rc));
+            }
+        }
+        for (t = 0; t < threads; t++) {
+            pthread_join(handles[t], NULL);
+        }
+        mfu_free(&handles);
+
+        pthread_mutex_destroy(&pool.lock);
+    } else {
+        /* stat each item in turn */
+        uint64_t i;
+        for (i = 0; i < count; i++) {
+            stat_pool_item(&pool, i);
+        }
+        walk_dirfd_close_all();
+    }
+}
+
+/* convert a count of bytes for an MPI call to an int,
+ * abort if it does not fit */
+static int stat_count_int(uint64_t bytes)
+{
+    if (bytes > (uint64_t) INT_MAX) {
+        MFU_ABORT(-1, "Too many bytes to exchange while stating items: %llu",
+            (unsigned long long) bytes);
+    }
+    return (int) bytes;
+}
+
+/* stat count items of input_flist listed in todo and insert them into
+ * flist in order, each process stats an even share of the items of all
+ * processes in this round, must be called by all processes */
+static void stat_round(mfu_flist input_flist, mfu_flist flist,
+                       const stat_todo_t* todo, uint64_t count,
+                       mfu_file_t* mfu_file)
+{
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    /* get number of items to stat on each process */
+    uint64_t* all_counts = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    MPI_Allgather(&count, 1, MPI_UINT64_T, all_counts, 1, MPI_UINT64_T, MPI_COMM_WORLD);
+
+    /* compute our global offset and the total count */
+    int i;
+    uint64_t offset = 0;
+    uint64_t total  = 0;
+    for (i = 0; i < ranks; i++) {
+        if (i < rank) {
+            offset += all_counts[i];
+        }
+        total += all_counts[i];
+    }
+
+    /* compute number of our items to send to each rank,
+     * and number of items we receive from each rank */
+    uint64_t* send_items = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    uint64_t* recv_items = (uint64_t*) MFU_MALLOC((size_t)ranks * sizeof(uint64_t));
+    stat_share_counts(offset, offset + count, total, ranks, send_items);
+    uint64_t my_start = stat_share_start(total, ranks, rank);
+    uint64_t my_end   = stat_share_start(total, ranks, rank + 1);
+    uint64_t start = 0;
+    for (i = 0; i < ranks; i++) {
+        uint64_t end = start + all_counts[i];
+        uint64_t lo = (start > my_start) ? start : my_start;
+        uint64_t hi = (end < my_end) ? end : my_end;
+        recv_items[i] = (hi > lo) ? (hi - lo) : 0;
+        start = end;
+    }
+    uint64_t recv_count = my_end - my_start;
+
+    /* pack a flag to dereference and the name of each item,
+     * items are in order, so those for each rank are contiguous */
+    int* send_counts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* send_disps  = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* recv_counts = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+    int* recv_disps  = (int*) MFU_MALLOC((size_t)ranks * sizeof(int));
+
+    uint64_t send_bytes = 0;
+    uint64_t n;
+    for (n = 0; n < count; n++) {
+        const char* name = mfu_flist_file_get_name(input_flist, todo[n].idx);
+        send_bytes += 1 + strlen(name) + 1;
+    }
+    char* sendbuf = (char*) MFU_MALLOC((size_t)send_bytes);
+
+    char* ptr = sendbuf;
+    n = 0;
+    for (i = 0; i < ranks; i++) {
+        char* rank_start = ptr;
+        uint64_t k;
+        for (k = 0; k < send_items[i]; k++) {
+            const char* name = mfu_flist_file_get_name(input_flist, todo[n].idx);
+            size_t len = strlen(name) + 1;
+            *ptr = (char) todo[n].follow;
+            ptr++;
+            memcpy(ptr, name, len);
+            ptr += len;
+            n++;
+        }
+        send_counts[i] = stat_count_int((uint64_t)(ptr - rank_start));
+        send_disps[i]  = stat_count_int((uint64_t)(rank_start - sendbuf));
+    }
+
+    /* exchange names */
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, MPI_COMM_WORLD);
+    uint64_t recv_bytes = 0;
+    for (i = 0; i < ranks; i++) {
+        recv_disps[i] = stat_count_int(recv_bytes);
+        recv_bytes += (uint64_t) recv_counts[i];
+    }
+    char* recvbuf = (char*) MFU_MALLOC((size_t)recv_bytes);
+    MPI_Alltoallv(sendbuf, send_counts, send_disps, MPI_BYTE,
+                  recvbuf, recv_counts, recv_disps, MPI_BYTE, MPI_COMM_WORLD);
+    mfu_free(&sendbuf);
+
+    /* unpack names of items we have been assigned */
+    const char** names = (const char**) MFU_MALLOC(recv_count * sizeof(char*));
+    int* follow = (int*) MFU_MALLOC(recv_count * sizeof(int));
+    ptr = recvbuf;
+    for (n = 0; n < recv_count; n++) {
+        follow[n] = (int) *ptr;
+        ptr++;
+        names[n] = ptr;
+        ptr += strlen(ptr) + 1;
+    }
+
+    /* stat our share of items */
+    stat_result_t* results = (stat_result_t*) MFU_MALLOC(recv_count * sizeof(stat_result_t));
+    stat_items(recv_count, names, follow, results, mfu_file);
+
+    mfu_free(&follow);
+    mfu_free(&names);
+    mfu_free(&recvbuf);
+
+    /* send results back to the processes holding each item */
+    uint64_t send_disp = 0;
+    uint64_t recv_disp = 0;
+    for (i = 0; i < ranks; i++) {
+        uint64_t send_size = recv_items[i] * sizeof(stat_result_t);
+        uint64_t recv_size = send_items[i] * sizeof(stat_result_t);
+        send_counts[i] = stat_count_int(send_size);
+        recv_counts[i] = stat_count_int(recv_size);
+        send_disps[i]  = stat_count_int(send_disp);
+        recv_disps[i]  = stat_count_int(recv_disp);
+        send_disp += send_size;
+        recv_disp += recv_size;
+    }
+    stat_result_t* mine = (stat_result_t*) MFU_MALLOC(count * sizeof(stat_result_t));
+    MPI_Alltoallv(results, send_counts, send_disps, MPI_BYTE,
+                  mine, recv_counts, recv_disps, MPI_BYTE, MPI_COMM_WORLD);
+    mfu_free(&results);
+
+    /* insert items into output list in the order of the input list */
+    for (n = 0; n < count; n++) {
+        const char* name = mfu_flist_file_get_name(input_flist, todo[n].idx);
+        stat_result_t* res = &mine[n];
+        if (res->status != 0) {
+            MFU_LOG(MFU_LOG_ERR, "%s failed: '%s' rc=%d (errno=%d %s)",
+                    todo[n].follow ? "mfu_file_stat()" : "mfu_file_lstat()",
+                    name, res->status, res->err, strerror(res->err));
+            continue;
+        }
+        mfu_flist_insert_stat(flist, name, res->st.st_mode, &res->st);
+    }
+
+    mfu_free(&mine);
+    mfu_free(&recv_disps);
+    mfu_free(&recv_counts);
+    mfu_free(&send_disps);
+    mfu_free(&send_counts);
+    mfu_free(&recv_items);
+    mfu_free(&send_items);
+    mfu_free(&all_counts);
+}
+
 /* Given an input file list, stat each file and enqueue details
  * in output file list, skip entries excluded by skip function
  * and skip args */
@@ -767,9 +2843,12 @@ void mfu_flist_stat(
         mfu_flist_usrgrp_get_groups(flist);
     }
 
-    /* step through each item in input list and stat it */
+    /* decide which items to stat from the main thread,
+     * so the skip function is never called concurrently */
     uint64_t idx;
     uint64_t size = mfu_flist_size(input_flist);
+    stat_todo_t* todo = (stat_todo_t*) MFU_MALLOC(size * sizeof(stat_todo_t));
+    uint64_t count = 0;
     for (idx = 0; idx < size; idx++) {
         /* get name of item */
         const char* name = mfu_flist_file_get_name(input_flist, idx);
@@ -777,7 +2856,7 @@ void mfu_flist_stat(
         /* check whether we should skip this item */
         if (skip_fn != NULL && skip_fn(name, skip_args)) {
             /* skip this file, don't include it in new list */
-            MFU_LOG(MFU_LOG_INFO, "skip %s");
+            MFU_LOG(MFU_LOG_INFO, "skip %s", name);
             continue;
         }
 
@@ -786,41 +2865,46 @@ void mfu_flist_stat(
          * not a link, then try to dereference it.
          * This accounts for dwalk --dereference, because a link might be
          * stored as a file, meaning that it should be dereferenced */
-        bool do_dereference = false;
+        int do_dereference = 0;
         if (dereference) {
-            do_dereference = true;
+            do_dereference = 1;
         } else {
             mode_t mode = mfu_flist_file_get_mode(input_flist, idx);
             if (mode && !S_ISLNK(mode)) {
-                do_dereference = true;
+                do_dereference = 1;
             }
         }
-        
-        /* stat the item */
-        struct stat st;
-        int status;
-        if (do_dereference) {
-            /* dereference symbolic link */
-            status = mfu_file_stat(name, &st, mfu_file);
-            if (status != 0) {
-                MFU_LOG(MFU_LOG_ERR, "mfu_file_stat() failed: '%s' rc=%d (errno=%d %s)",
-                        name, status, errno, strerror(errno));
-                continue;
-            }
-        } else {
-            /* don't dereference symbolic links */
-            status = mfu_file_lstat(name, &st, mfu_file);
-            if (status != 0) {
-                MFU_LOG(MFU_LOG_ERR, "mfu_file_lstat() failed: '%s' rc=%d (errno=%d %s)",
-                        name, status, errno, strerror(errno));
-                continue;
+
+        todo[count].idx    = idx;
+        todo[count].follow = do_dereference;
+        count++;
+    }
+
+    /* look up items as configured for the walk */
+    walk_lookup_init(mfu_file);
+
+    /* stat items in rounds, so the names and results exchanged in each
+     * round stay bounded however many items a process holds */
+    uint64_t rounds = (count + STAT_ROUND_ITEMS - 1) / STAT_ROUND_ITEMS;
+    uint64_t all_rounds;
+    MPI_Allreduce(&rounds, &all_rounds, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    uint64_t r;
+    for (r = 0; r < all_rounds; r++) {
+        uint64_t start = r * STAT_ROUND_ITEMS;
+        uint64_t round_count = 0;
+        if (start < count) {
+            round_count = count - start;
+            if (round_count > STAT_ROUND_ITEMS) {
+                round_count = STAT_ROUND_ITEMS;
             }
         }
-
-        /* insert item into output list */
-        mfu_flist_insert_stat(flist, name, st.st_mode, &st);
+        const stat_todo_t* round_todo = (start < count) ? &todo[start] : NULL;
+        stat_round(input_flist, flist, round_todo, round_count, mfu_file);
     }
 
+    mfu_free(&todo);
+
     /* compute global summary */
     mfu_flist_summarize(flist);
 }
@@ -334,6 +334,50 @@ retry:
     return rc;
 }
 
+/* calls fstatat, and retries a few times if we get EIO or EINTR */
+int mfu_fstatat(int dirfd, const char* path, struct stat* buf, int flags)
+{
+    int rc;
+    int tries = MFU_IO_TRIES;
+retry:
+    errno = 0;
+    rc = fstatat(dirfd, path, buf, flags);
+    if (rc != 0) {
+        if (errno == EINTR || errno == EIO) {
+            tries--;
+            if (tries > 0) {
+                /* sleep a bit before consecutive tries */
+                usleep(MFU_IO_USLEEP);
+                goto retry;
+            }
+        }
+    }
+    return rc;
+}
+
+#ifdef STATX_TYPE
+/* calls statx, and retries a few times if we get EIO or EINTR */
+int mfu_statx(int dirfd, const char* path, int flags, unsigned int mask, struct statx* buf)
+{
+    int rc;
+    int tries = MFU_IO_TRIES;
+retry:
+    errno = 0;
+    rc = statx(dirfd, path, flags, mask, buf);
+    if (rc != 0) {
+        if (errno == EINTR || errno == EIO) {
+            tries--;
+            if (tries > 0) {
+                /* sleep a bit before consecutive tries */
+                usleep(MFU_IO_USLEEP);
+                goto retry;
+            }
+        }
+    }
+    return rc;
+}
+#endif
+
 /* calls lstat, and retries a few times if we get EIO or EINTR */
 int mfu_file_lstat(const char* path, struct stat* buf, mfu_file_t* mfu_file)
 {
@@ -680,6 +724,27 @@ int mfu_open(const char* file, int flags, ...)
     return fd;
 }
 
+/* open file relative to directory fd, retry a few times on EINTR or EIO */
+int mfu_openat(int dirfd, const char* file, int flags)
+{
+    int fd;
+    int tries = MFU_IO_TRIES;
+retry:
+    errno = 0;
+    fd = openat(dirfd, file, flags);
+    if (fd < 0) {
+        if (errno == EINTR || errno == EIO) {
+            tries--;
+            if (tries > 0) {
+                /* sleep a bit before consecutive tries */
+                usleep(MFU_IO_USLEEP);
+                goto retry;
+            }
+        }
+    }
+    return fd;
+}
+
 /* Open a file.
  * Return 0 on success, -1 on error */
 int mfu_file_open(const char* file, int flags, mfu_file_t* mfu_file, ...)
@@ -1211,6 +1276,27 @@ retry:
     return rc;
 }
 
+/* delete a file relative to directory fd, retry a few times on EINTR or EIO */
+int mfu_unlinkat(int dirfd, const char* file, int flags)
+{
+    int rc;
+    int tries = MFU_IO_TRIES;
+retry:
+    errno = 0;
+    rc = unlinkat(dirfd, file, flags);
+    if (rc != 0) {
+        if (errno == EINTR || errno == EIO) {
+            tries--;
+            if (tries > 0) {
+                /* sleep a bit before consecutive tries */
+                usleep(MFU_IO_USLEEP);
+                goto retry;
+            }
+        }
+    }
+    return rc;
+}
+
 /* force flush of written data */
 int mfu_fsync(const char* file, int fd)
 {
@@ -1232,6 +1318,143 @@ retry:
     return rc;
 }
 
+/* point file handle at the file held in a cache entry */
+static void mfu_file_cache_set(mfu_file_cache_entry* entry, mfu_file_t* mfu_file)
+{
+    mfu_file->fd = entry->fd;
+#ifdef DAOS_SUPPORT
+    mfu_file->obj = entry->obj;
+#endif
+}
+
+/* sync if needed and close the file held in a cache entry,
+ * returns 0 on success, -1 on error */
+static int mfu_file_cache_evict(mfu_file_cache_entry* entry, mfu_file_t* mfu_file)
+{
+    int rc = 0;
+
+    /* if open for write, fsync */
+    mfu_file_cache_set(entry, mfu_file);
+    if (entry->sync && mfu_file->type == POSIX) {
+        if (mfu_fsync(entry->name, entry->fd) != 0) {
+            rc = -1;
+        }
+    }
+
+    /* close the file and delete the name string */
+    if (mfu_file_close(entry->name, mfu_file) != 0) {
+        rc = -1;
+    }
+    mfu_free(&entry->name);
+
+    return rc;
+}
+
+void mfu_file_cache_init(mfu_file_cache* cache, int capacity)
+{
+    if (capacity < 1) {
+        capacity = 1;
+    }
+
+    cache->capacity = capacity;
+    cache->clock    = 0;
+    cache->entries  = (mfu_file_cache_entry*) MFU_MALLOC((size_t)capacity * sizeof(mfu_file_cache_entry));
+
+    int i;
+    for (i = 0; i < capacity; i++) {
+        cache->entries[i].name = NULL;
+    }
+}
+
+int mfu_file_cache_open(mfu_file_cache* cache, const char* file, int flags, mode_t mode, int sync, mfu_file_t* mfu_file)
+{
+    cache->clock++;
+
+    /* look for the file while tracking a free entry
+     * and the least recently used one */
+    mfu_file_cache_entry* slot = NULL;
+    mfu_file_cache_entry* lru  = NULL;
+    int i;
+    for (i = 0; i < cache->capacity; i++) {
+        mfu_file_cache_entry* entry = &cache->entries[i];
+        if (entry->name == NULL) {
+            if (slot == NULL) {
+                slot = entry;
+            }
+            continue;
+        }
+
+        if (strcmp(entry->name, file) == 0) {
+            if (entry->flags == flags) {
+                /* the file is already open in the mode we need */
+                entry->used = cache->clock;
+                mfu_file_cache_set(entry, mfu_file);
+                return 0;
+            }
+
+            /* the file is open in another mode, close it */
+            mfu_file_cache_evict(entry, mfu_file);
+            if (slot == NULL) {
+                slot = entry;
+            }
+            continue;
+        }
+
+        if (lru == NULL || entry->used < lru->used) {
+            lru = entry;
+        }
+    }
+
+    /* make room if all entries are in use */
+    if (slot == NULL) {
+        mfu_file_cache_evict(lru, mfu_file);
+        slot = lru;
+    }
+
+    /* open the new file, this sets mfu_file->fd/obj */
+    int rc;
+    if (flags & O_CREAT) {
+        rc = mfu_file_open(file, flags, mfu_file, mode);
+    } else {
+        rc = mfu_file_open(file, flags, mfu_file);
+    }
+    if (rc != 0) {
+        return -1;
+    }
+
+    /* cache the file descriptor */
+    slot->name  = MFU_STRDUP(file);
+    slot->flags = flags;
+    slot->sync  = sync;
+    slot->fd    = mfu_file->fd;
+#ifdef DAOS_SUPPORT
+    slot->obj   = mfu_file->obj;
+#endif
+    slot->used  = cache->clock;
+
+    return 1;
+}
+
+int mfu_file_cache_close(mfu_file_cache* cache, mfu_file_t* mfu_file)
+{
+    int rc = 0;
+
+    int i;
+    for (i = 0; i < cache->capacity; i++) {
+        mfu_file_cache_entry* entry = &cache->entries[i];
+        if (entry->name != NULL) {
+            if (mfu_file_cache_evict(entry, mfu_file) != 0) {
+                rc = -1;
+            }
+        }
+    }
+
+    mfu_free(&cache->entries);
+    cache->capacity = 0;
+
+    return rc;
+}
+
 /*****************************
  * Directories
  ****************************/
@@ -28,6 +28,7 @@ extern "C" {
 #endif
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdarg.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -86,6 +87,14 @@ int mfu_file_lstat(const char* path, struct stat* buf, mfu_file_t* mfu_file);
 int mfu_lstat(const char* path, struct stat* buf);
 int daos_lstat(const char* path, struct stat* buf, mfu_file_t* mfu_file);
 
+/* calls fstatat, and retries a few times if we get EIO or EINTR */
+int mfu_fstatat(int dirfd, const char* path, struct stat* buf, int flags);
+
+#ifdef STATX_TYPE
+/* calls statx, and retries a few times if we get EIO or EINTR */
+int mfu_statx(int dirfd, const char* path, int flags, unsigned int mask, struct statx* buf);
+#endif
+
 /* only dcp1 calls mfu_lstat64, is it necessary? */
 int mfu_lstat64(const char* path, struct stat64* buf);
 
@@ -167,6 +176,10 @@ int mfu_file_open(const char* file, int flags, mfu_file_t* mfu_file, ...);
 int daos_open(const char* file, int flags, mode_t mode, mfu_file_t* mfu_file);
 int mfu_open(const char* file, int flags, ...);
 
+/* open file relative to directory fd with specified flags, without creating it,
+ * retries a few times if we get EIO or EINTR */
+int mfu_openat(int dirfd, const char* file, int flags);
+
 /* close file */
 int mfu_file_close(const char* file, mfu_file_t* mfu_file);
 int daos_close(const char* file, mfu_file_t* mfu_file);
@@ -213,9 +226,50 @@ int mfu_file_unlink(const char* file, mfu_file_t* mfu_file);
 int daos_unlink(const char* file, mfu_file_t* mfu_file);
 int mfu_unlink(const char* file);
 
+/* delete a file relative to directory fd */
+int mfu_unlinkat(int dirfd, const char* file, int flags);
+
 /* force flush of written data */
 int mfu_fsync(const char* file, int fd);
 
+/* default number of files kept open by a file cache */
+#define MFU_OPEN_FILES_STR "16"
+#define MFU_OPEN_FILES (16)
+
+/* an open file held in a file cache */
+typedef struct {
+    char*    name;  /* name of open file (NULL if entry is free) */
+    int      flags; /* flags the file was opened with */
+    int      sync;  /* whether to fsync file on close (1) or not (0) */
+    int      fd;    /* file descriptor */
+#ifdef DAOS_SUPPORT
+    dfs_obj_t* obj; /* open object */
+#endif
+    uint64_t used;  /* value of cache clock when entry was last used */
+} mfu_file_cache_entry;
+
+/* cache of open files, so that accessing the same files repeatedly
+ * costs one open and one close, once all entries are in use, the
+ * least recently used file is closed to make room for another */
+typedef struct {
+    int capacity;                  /* maximum number of open files */
+    uint64_t clock;                /* incremented on each access to order entries */
+    mfu_file_cache_entry* entries; /* array of capacity entries */
+} mfu_file_cache;
+
+/* initialize a cache to hold up to capacity open files */
+void mfu_file_cache_init(mfu_file_cache* cache, int capacity);
+
+/* open file with specified flags through the cache, mode is used
+ * if the file is created, sets mfu_file to refer to the open file,
+ * returns 0 if the file was already open, 1 if it was opened by this
+ * call, and -1 on error, a file open with different flags is reopened */
+int mfu_file_cache_open(mfu_file_cache* cache, const char* file, int flags, mode_t mode, int sync, mfu_file_t* mfu_file);
+
+/* close all files in the cache and release its memory,
+ * returns 0 on success, -1 if any file failed to sync or close */
+int mfu_file_cache_close(mfu_file_cache* cache, mfu_file_t* mfu_file);
+
 /*****************************
  * Directories
  ****************************/
@@ -107,14 +107,47 @@ void mfu_param_path_check_copy(
     int* flag_copy_into_dir         /* OUT - flag indicating whether source items should be copied into destination directory (1) or not (0) */
 );
 
+/* fields of stat data that a walk can be asked to collect,
+ * fields that are not collected are filled in when first read */
+#define MFU_STAT_MODE  (1 << 0) /* file type and permissions, always collected */
+#define MFU_STAT_UID   (1 << 1) /* user id */
+#define MFU_STAT_GID   (1 << 2) /* group id */
+#define MFU_STAT_ATIME (1 << 3) /* access time */
+#define MFU_STAT_MTIME (1 << 4) /* modify time */
+#define MFU_STAT_CTIME (1 << 5) /* change time */
+#define MFU_STAT_SIZE  (1 << 6) /* file size */
+#define MFU_STAT_INO   (1 << 7) /* device, inode number, and link count */
+#define MFU_STAT_ALL   (0xff)
+
 /* options passed to walk that effect how the walk is executed */
 typedef struct {
     int dir_perms;      /* flag option to update dir perms during walk */
     int remove;         /* flag option to remove files during walk */
     int use_stat;       /* flag option on whether or not to stat files during walk */
     int dereference;    /* flag option to dereference symbolic links */
+    unsigned int stat_mask; /* MFU_STAT bits of fields to collect when use_stat is set */
+    int threads;        /* number of threads each process uses to stat items */
+    int maxdepth;       /* levels below each path to descend, -1 for no limit */
+    struct mfu_pred_item_t* prune; /* don't descend into directories matching this predicate */
+    void* prev;         /* list from a previous walk to reuse entries of unchanged directories */
+    const char* checkpoint; /* prefix of files each process periodically writes its items to */
+    int checkpoint_secs;    /* seconds between checkpoints */
+    const char* resume;     /* prefix of checkpoint files of an interrupted walk to continue */
 } mfu_walk_opts_t;
 
+/* engines used to read and write file data during a copy */
+typedef enum {
+    MFU_IO_ENGINE_POSIX = 0, /* blocking read and write calls */
+    MFU_IO_ENGINE_URING,     /* batched asynchronous requests through io_uring */
+} mfu_io_engine;
+
+/* how data and metadata written during a copy are forced to disk */
+typedef enum {
+    MFU_SYNC_NODE = 0, /* sync() everything cached on the node */
+    MFU_SYNC_FS,       /* syncfs() only the file system holding the destination */
+    MFU_SYNC_FILE,     /* write back each file as it is copied, syncfs() after metadata updates */
+} mfu_sync_mode;
+
 /* options passed to mfu_ */
 typedef struct {
     int    copy_into_dir;  /* flag indicating whether copying into existing dir */
@@ -127,10 +160,18 @@ typedef struct {
     int    no_dereference; /* if true, don't dereference source symbolic links */
     bool   direct;         /* whether to use O_DIRECT */
     bool   sparse;         /* whether to create sparse files */
+    bool   offload;        /* whether to try reflink and copy_file_range before copying through buffers */
+    bool   hardlinks;      /* whether to copy data once per inode and link other names to it */
     size_t chunk_size;     /* size to chunk files by */
     size_t buf_size;       /* buffer size to read/write to file system */
     char*  block_buf1;     /* buffer to read / write data */
     char*  block_buf2;     /* another buffer to read / write data */
+    int    io_depth;       /* number of buffers kept in flight when copying file data, 1 disables pipelining */
+    char** io_bufs;        /* array of io_depth buffers used by the pipelined copy */
+    mfu_io_engine io_engine; /* engine used to read and write file data */
+    mfu_sync_mode sync_mode; /* how written data and metadata are flushed to disk */
+    bool   dynamic;        /* whether idle processes take chunks from busy ones during the copy */
+    int    open_files;     /* number of files each process keeps open for reading and for writing */
     int    grouplock_id;   /* Lustre grouplock ID */
     uint64_t batch_files;  /* max batch size to copy files, 0 implies no limit */
 } mfu_copy_opts_t;
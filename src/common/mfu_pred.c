@@ -287,18 +287,24 @@ int MFU_PRED_SIZE (mfu_flist flist, uint64_t idx, void* arg)
     return ret;
 }
 
-static int check_time (uint64_t secs, uint64_t nsecs, uint64_t units, void* arg)
+/* compute age of item relative to base time in integer number of units */
+static uint64_t time_age (uint64_t secs, uint64_t nsecs, uint64_t units, const mfu_pred_times_rel* r)
 {
-    mfu_pred_times_rel* r = (mfu_pred_times_rel*) arg;
-
-    /* compute age of item in integer number of days */
     uint64_t item_nsecs = secs      * 1000000000 + nsecs;
     uint64_t now_nsecs  = r->t.secs * 1000000000 + r->t.nsecs;
     uint64_t age_nsecs = 0;
     if (item_nsecs < now_nsecs) {
         age_nsecs = now_nsecs - item_nsecs;
     }
-    uint64_t age = age_nsecs / units;
+    return age_nsecs / units;
+}
+
+static int check_time (uint64_t secs, uint64_t nsecs, uint64_t units, void* arg)
+{
+    mfu_pred_times_rel* r = (mfu_pred_times_rel*) arg;
+
+    /* compute age of item in integer number of days */
+    uint64_t age = time_age(secs, nsecs, units, r);
 
     /* parse parameter from user */
     int cmp = r->direction;
@@ -414,3 +420,88 @@ int MFU_PRED_CNEWER (mfu_flist flist, uint64_t idx, void * arg)
         return 0;
     }
 }
+
+/* returns 1 if some value in [min, max] compares to val as cmp asks:
+ * greater than (cmp > 0), less than (cmp < 0), or equal (cmp == 0) */
+static int range_may_match (int cmp, uint64_t val, uint64_t min, uint64_t max)
+{
+    if (cmp > 0) {
+        return (max > val);
+    } else if (cmp < 0) {
+        return (min < val);
+    }
+    return (min <= val && val <= max);
+}
+
+/* returns 1 if an item with mtime in [min_secs, max_secs] may have an
+ * age that satisfies the relative time in arg */
+static int time_may_match (uint64_t min_secs, uint64_t max_secs, uint64_t units, void* arg)
+{
+    mfu_pred_times_rel* r = (mfu_pred_times_rel*) arg;
+
+    /* age decreases as time increases, nanoseconds are not recorded
+     * in the zone so cover the whole last second */
+    uint64_t min_age = time_age(max_secs, 999999999, units, r);
+    uint64_t max_age = time_age(min_secs, 0, units, r);
+    return range_may_match(r->direction, r->magnitude, min_age, max_age);
+}
+
+int mfu_pred_zone_may_match (const mfu_pred* root, const mfu_pred_zone* zone)
+{
+    const mfu_pred* p;
+    for (p = root; p != NULL; p = p->next) {
+        /* skip the empty head of the list */
+        if (p->f == NULL) {
+            continue;
+        }
+
+        int cmp;
+        uint64_t val;
+        int ret = 1;
+        if (p->f == MFU_PRED_SIZE) {
+            char* str = (char*) p->arg;
+            unsigned long long bytes;
+            if (str[0] == '+' || str[0] == '-') {
+                cmp = (str[0] == '+') ? 1 : -1;
+                mfu_abtoull(&str[1], &bytes);
+            } else {
+                cmp = 0;
+                mfu_abtoull(str, &bytes);
+            }
+            ret = range_may_match(cmp, (uint64_t)bytes, zone->min_size, zone->max_size);
+        } else if (p->f == MFU_PRED_UID) {
+            parse_number((char*)p->arg, &cmp, &val);
+            ret = range_may_match(cmp, val, zone->min_uid, zone->max_uid);
+        } else if (p->f == MFU_PRED_GID) {
+            parse_number((char*)p->arg, &cmp, &val);
+            ret = range_may_match(cmp, val, zone->min_gid, zone->max_gid);
+        } else if (p->f == MFU_PRED_MTIME) {
+            ret = time_may_match(zone->min_mtime, zone->max_mtime, NSECS_IN_DAY, p->arg);
+        } else if (p->f == MFU_PRED_MMIN) {
+            ret = time_may_match(zone->min_mtime, zone->max_mtime, NSECS_IN_MIN, p->arg);
+        } else if (p->f == MFU_PRED_MNEWER) {
+            /* nanoseconds are not recorded, so equal seconds may be newer */
+            mfu_pred_times* times = (mfu_pred_times*) p->arg;
+            ret = (zone->max_mtime >= times->secs);
+        } else if (p->f == MFU_PRED_NAME  || p->f == MFU_PRED_PATH  ||
+                   p->f == MFU_PRED_REGEX || p->f == MFU_PRED_GROUP ||
+                   p->f == MFU_PRED_USER  || p->f == MFU_PRED_TYPE  ||
+                   p->f == MFU_PRED_AMIN  || p->f == MFU_PRED_CMIN  ||
+                   p->f == MFU_PRED_ATIME || p->f == MFU_PRED_CTIME ||
+                   p->f == MFU_PRED_ANEWER || p->f == MFU_PRED_CNEWER)
+        {
+            /* tests on fields the zone does not cover */
+            ret = 1;
+        } else {
+            /* unknown predicate, which may be an action,
+             * so the items must be read */
+            return 1;
+        }
+
+        if (!ret) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
@@ -39,6 +39,22 @@ void mfu_pred_add(mfu_pred* pred, mfu_pred_fn predicate, void* arg);
  * returns 1 if item satisfies predicate, 0 if not, and -1 if error */
 int mfu_pred_execute(mfu_flist flist, uint64_t idx, const mfu_pred*);
 
+/* ranges of field values over a set of items, such as a block of
+ * a cache file, all ranges are inclusive */
+typedef struct mfu_pred_zone_t {
+    uint64_t min_size,  max_size;  /* size in bytes */
+    uint64_t min_mtime, max_mtime; /* mtime in seconds */
+    uint64_t min_uid,   max_uid;   /* user id */
+    uint64_t min_gid,   max_gid;   /* group id */
+    uint64_t min_depth, max_depth; /* depth of path */
+} mfu_pred_zone;
+
+/* returns 0 if no item whose fields fall in zone can satisfy the
+ * predicate chain and 1 if some item might, tests are only considered
+ * up to the first predicate that is not a test defined here, since it
+ * may be an action that must run on every item */
+int mfu_pred_zone_may_match(const mfu_pred* root, const mfu_pred_zone* zone);
+
 /* captures current time and returns it in an mfu_pred_times structure,
  * must be freed by caller with mfu_free */
 mfu_pred_times* mfu_pred_now(void);
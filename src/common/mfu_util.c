@@ -23,6 +23,12 @@
 #define ULLONG_MAX (__LONG_LONG_MAX__ * 2UL + 1UL)
 #endif
 
+/* SSE2 is part of the x86_64 baseline, AVX2 is selected at run time */
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define MFU_ZERO_SCAN_X86 1
+#endif
+
 #ifdef LUSTRE_SUPPORT
 #include <lustre/lustreapi.h>
 #include <lustre/lustre_user.h>
@@ -100,6 +106,30 @@ void* mfu_malloc(size_t size, const char* file, int line)
     return NULL;
 }
 
+/* if size > 0 resizes the buffer at ptr to size bytes and returns
+ * pointer, calls mfu_abort if realloc fails,
+ * frees ptr and returns NULL if size == 0 */
+void* mfu_realloc(void* ptr, size_t size, const char* file, int line)
+{
+    /* only bother if size > 0 */
+    if (size > 0) {
+        /* try to resize memory and check whether we succeeded */
+        void* newptr = realloc(ptr, size);
+        if (newptr == NULL) {
+            /* allocate failed, abort */
+            mfu_abort(file, line, 1, "Failed to allocate %llu bytes. Try using more nodes.",
+                        (unsigned long long) size
+                       );
+        }
+
+        /* return the pointer */
+        return newptr;
+    }
+
+    free(ptr);
+    return NULL;
+}
+
 /* if size > 0 allocates size bytes and returns pointer,
  * calls mfu_abort if calloc fails, returns NULL if size == 0 */
 void* mfu_calloc(size_t nelem, size_t elsize, const char* file, int line)
@@ -587,6 +617,102 @@ uint32_t mfu_hash_jenkins(const char* key, size_t len)
     return hash;
 }
 
+/* scan for a nonzero byte one 64-bit word at a time,
+ * returns 1 if all size bytes of buf are 0 and 0 otherwise */
+static int mfu_is_zero_words(const unsigned char* buf, size_t size)
+{
+    /* check leading bytes until buf is aligned on a word boundary */
+    while (size > 0 && ((uintptr_t)buf & (sizeof(uint64_t) - 1)) != 0) {
+        if (*buf != 0) {
+            return 0;
+        }
+        buf++;
+        size--;
+    }
+
+    /* OR together 8 words at a time so we only branch once per 64 bytes,
+     * memcpy keeps the loads legal under strict aliasing and compiles
+     * to plain loads */
+    uint64_t w[8];
+    while (size >= sizeof(w)) {
+        memcpy(w, buf, sizeof(w));
+        if ((w[0] | w[1] | w[2] | w[3] | w[4] | w[5] | w[6] | w[7]) != 0) {
+            return 0;
+        }
+        buf  += sizeof(w);
+        size -= sizeof(w);
+    }
+
+    /* check any remaining bytes */
+    while (size > 0) {
+        if (*buf != 0) {
+            return 0;
+        }
+        buf++;
+        size--;
+    }
+
+    return 1;
+}
+
+#ifdef MFU_ZERO_SCAN_X86
+/* scan 64 bytes per iteration with SSE2 */
+static int mfu_is_zero_sse2(const unsigned char* buf, size_t size)
+{
+    while (size >= 64) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(buf +  0));
+        x = _mm_or_si128(x, _mm_loadu_si128((const __m128i*)(buf + 16)));
+        x = _mm_or_si128(x, _mm_loadu_si128((const __m128i*)(buf + 32)));
+        x = _mm_or_si128(x, _mm_loadu_si128((const __m128i*)(buf + 48)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) != 0xFFFF) {
+            return 0;
+        }
+        buf  += 64;
+        size -= 64;
+    }
+    return mfu_is_zero_words(buf, size);
+}
+
+/* scan 128 bytes per iteration with AVX2 */
+__attribute__((target("avx2")))
+static int mfu_is_zero_avx2(const unsigned char* buf, size_t size)
+{
+    while (size >= 128) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(buf +  0));
+        x = _mm256_or_si256(x, _mm256_loadu_si256((const __m256i*)(buf + 32)));
+        x = _mm256_or_si256(x, _mm256_loadu_si256((const __m256i*)(buf + 64)));
+        x = _mm256_or_si256(x, _mm256_loadu_si256((const __m256i*)(buf + 96)));
+        if (! _mm256_testz_si256(x, x)) {
+            return 0;
+        }
+        buf  += 128;
+        size -= 128;
+    }
+    return mfu_is_zero_sse2(buf, size);
+}
+#endif /* MFU_ZERO_SCAN_X86 */
+
+/* scan routine picked for this processor on first call */
+static int (*mfu_is_zero_fn)(const unsigned char* buf, size_t size) = NULL;
+
+int mfu_is_zero(const void* buf, size_t size)
+{
+    if (mfu_is_zero_fn == NULL) {
+#ifdef MFU_ZERO_SCAN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            mfu_is_zero_fn = mfu_is_zero_avx2;
+        } else {
+            mfu_is_zero_fn = mfu_is_zero_sse2;
+        }
+#else
+        mfu_is_zero_fn = mfu_is_zero_words;
+#endif
+    }
+
+    return mfu_is_zero_fn((const unsigned char*) buf, size);
+}
+
 void mfu_stat_get_atimes(const struct stat* sb, uint64_t* secs, uint64_t* nsecs)
 {
     *secs = (uint64_t) sb->st_atime;
@@ -701,6 +827,12 @@ void mfu_stat_set_ctimes (struct stat* sb, uint64_t secs, uint64_t nsecs)
 #endif
 }
 
+/* files kept open by mfu_compare_contents between calls,
+ * chunks of the same files are often compared in a row */
+static mfu_file_cache mfu_compare_src_cache;
+static mfu_file_cache mfu_compare_dst_cache;
+static int mfu_compare_cache_init = 0;
+
 /* compares contents of two files and optionally overwrite dest with source,
  * returns -1 on error, 0 if equal, 1 if different */
 int mfu_compare_contents(
@@ -736,9 +868,16 @@ int mfu_compare_contents(
         src_flags |= O_DIRECT;
     }
 
+    /* set up caches of open files on first use */
+    if (! mfu_compare_cache_init) {
+        mfu_file_cache_init(&mfu_compare_src_cache, copy_opts->open_files);
+        mfu_file_cache_init(&mfu_compare_dst_cache, copy_opts->open_files);
+        mfu_compare_cache_init = 1;
+    }
+
     /* open source file */
-    int src_rc = mfu_file_open(src_name, src_flags, mfu_src_file);
-    if (src_rc != 0) {
+    int src_rc = mfu_file_cache_open(&mfu_compare_src_cache, src_name, src_flags, 0, 0, mfu_src_file);
+    if (src_rc < 0) {
         /* log error if there is an open failure on the src side */
         MFU_LOG(MFU_LOG_ERR, "Failed to open source file `%s' (errno=%d %s)",
                 src_name, errno, strerror(errno));
@@ -756,12 +895,11 @@ int mfu_compare_contents(
     }
 
     /* open destination file */
-    int dst_rc = mfu_file_open(dst_name, dst_flags, mfu_dst_file);
-    if (dst_rc != 0) {
+    int dst_rc = mfu_file_cache_open(&mfu_compare_dst_cache, dst_name, dst_flags, 0, 0, mfu_dst_file);
+    if (dst_rc < 0) {
         /* log error if there is an open failure on the dst side */
         MFU_LOG(MFU_LOG_ERR, "Failed to open destination file `%s' (errno=%d %s)",
                 dst_name, errno, strerror(errno));
-        mfu_file_close(src_name, mfu_src_file);
         return -1;
     }
 
@@ -977,9 +1115,26 @@ int mfu_compare_contents(
     mfu_free(&src_buf);
     mfu_free(&dst_buf);
 
-    /* close files */
-    mfu_file_close(dst_name, mfu_dst_file);
-    mfu_file_close(src_name, mfu_src_file);
+    return rc;
+}
+
+/* close files left open by mfu_compare_contents,
+ * returns 0 on success, -1 on error */
+int mfu_compare_contents_close(
+    mfu_file_t* mfu_src_file,
+    mfu_file_t* mfu_dst_file)
+{
+    int rc = 0;
+
+    if (mfu_compare_cache_init) {
+        if (mfu_file_cache_close(&mfu_compare_dst_cache, mfu_dst_file) != 0) {
+            rc = -1;
+        }
+        if (mfu_file_cache_close(&mfu_compare_src_cache, mfu_src_file) != 0) {
+            rc = -1;
+        }
+        mfu_compare_cache_init = 0;
+    }
 
     return rc;
 }
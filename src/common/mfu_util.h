@@ -131,6 +131,17 @@ void* mfu_malloc(
   int line
 );
 
+/* if size > 0 resizes the buffer at ptr to size bytes and returns
+ * pointer, calls mfu_abort if realloc fails,
+ * frees ptr and returns NULL if size == 0 */
+#define MFU_REALLOC(X, Y) mfu_realloc(X, Y, __FILE__, __LINE__)
+void* mfu_realloc(
+  void* ptr,
+  size_t size,
+  const char* file,
+  int line
+);
+
 /* if size > 0 allocates size bytes and returns pointer,
  * calls mfu_abort if calloc fails, returns NULL if size == 0 */
 #define MFU_CALLOC(X, Y) mfu_calloc(X, Y, __FILE__, __LINE__)
@@ -233,6 +244,10 @@ void mfu_unpack_uint64(const char** pptr, uint64_t* value);
 /* Bob Jenkins one-at-a-time hash: http://en.wikipedia.org/wiki/Jenkins_hash_function */
 uint32_t mfu_hash_jenkins(const char* key, size_t len);
 
+/* return 1 if all size bytes of buf are 0, and 0 otherwise,
+ * uses vector instructions when the processor supports them */
+int mfu_is_zero(const void* buf, size_t size);
+
 /* get secs and nsecs values from stat structure */
 void mfu_stat_get_atimes(const struct stat* sb, uint64_t* secs, uint64_t* nsecs);
 void mfu_stat_get_mtimes(const struct stat* sb, uint64_t* secs, uint64_t* nsecs);
@@ -260,6 +275,14 @@ int mfu_compare_contents(
     mfu_file_t* mfu_dst_file  /* IN  - I/O filesystem functions to use for destination */
 );
 
+/* close files kept open by mfu_compare_contents, call this once
+ * done comparing and before modifying the files in other ways,
+ * returns 0 on success, -1 on error */
+int mfu_compare_contents_close(
+    mfu_file_t* mfu_src_file, /* IN  - I/O filesystem functions to use for source */
+    mfu_file_t* mfu_dst_file  /* IN  - I/O filesystem functions to use for destination */
+);
+
 /* uses the lustre api to obtain stripe count and stripe size of a file */
 int mfu_stripe_get(const char *path, uint64_t *stripe_size, uint64_t *stripe_count);
 
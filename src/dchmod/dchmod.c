@@ -248,6 +248,9 @@ int main(int argc, char** argv)
             walk_opts->use_stat = 0;
         }
 
+        /* otherwise we only need the mode and ownership */
+        walk_opts->stat_mask = MFU_STAT_MODE | MFU_STAT_UID | MFU_STAT_GID;
+
         /* walk list of input paths */
         mfu_flist_walk_param_paths(numpaths, paths, walk_opts, flist, mfu_file);
     }
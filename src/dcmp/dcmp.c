@@ -17,7 +17,7 @@
 #include <assert.h>
 
 #include "mfu.h"
-#include "strmap.h"
+#include "mfu_cmpmap.h"
 #include "list.h"
 
 /* for daos */
@@ -364,131 +364,63 @@ static int dcmp_state_from_string(const char* string, dcmp_state *state)
     return -ENOENT;
 }
 
-/* given a filename as the key, encode an index followed
- * by the init state */
-static void dcmp_strmap_item_init(
-    strmap* map,
-    const char *key,
-    uint64_t item_index)
-{
-    /* Should be long enough for 64 bit number and DCMPF_MAX */
-    char val[21 + DCMPF_MAX];
-    int i;
-
-    /* encode the index */
-    int len = snprintf(val, sizeof(val), "%llu",
-                       (unsigned long long) item_index);
-
-    /* encode the state (state characters and trailing NUL) */
-    assert((size_t)len + DCMPF_MAX + 1 <= (sizeof(val)));
-    size_t position = strlen(val);
-    for (i = 0; i < DCMPF_MAX; i++) {
-        val[position] = DCMPS_INIT;
-        position++;
-    }
-    val[position] = '\0';
-
-    /* add item to map */
-    strmap_set(map, key, val);
-}
-
+/* record the state of a field of the item with the given key */
 static void dcmp_strmap_item_update(
-    strmap* map,
+    mfu_cmpmap* map,
     const char *key,
     dcmp_field field,
     dcmp_state state)
 {
-    /* Should be long enough for 64 bit number and DCMPF_MAX */
-    char new_val[21 + DCMPF_MAX];
-
     /* lookup item from map */
-    const char* val = strmap_get(map, key);
+    uint64_t idx;
+    if (mfu_cmpmap_lookup(map, key, &idx) != 0) {
+        MFU_ABORT(-1, "Failed to find item in comparison map: '%s'", key);
+    }
 
-    /* copy existing index over */
+    /* states are stored relative to the initial state */
     assert(field < DCMPF_MAX);
-    assert(strlen(val) + 1 <= sizeof(new_val));
-    strcpy(new_val, val);
-
-    /* set new state value */
-    size_t position = strlen(new_val) - DCMPF_MAX;
-    new_val[position + field] = state;
-
-    /* reinsert item in map */
-    strmap_set(map, key, new_val);
+    mfu_cmpmap_set_state(map, idx, field, state - DCMPS_INIT);
 }
 
 static int dcmp_strmap_item_index(
-    strmap* map,
+    mfu_cmpmap* map,
     const char *key,
     uint64_t *item_index)
 {
-    /* Should be long enough for 64 bit number and DCMPF_MAX */
-    char new_val[21 + DCMPF_MAX];
-
     /* lookup item from map */
-    const char* val = strmap_get(map, key);
-    if (val == NULL) {
-        return -1;
-    }
-
-    /* extract index */
-    assert(strlen(val) + 1 <= sizeof(new_val));
-    strcpy(new_val, val);
-    new_val[strlen(new_val) - DCMPF_MAX] = '\0';
-    *item_index = strtoull(new_val, NULL, 0);
-
-    return 0;
+    return mfu_cmpmap_lookup(map, key, item_index);
 }
 
 static int dcmp_strmap_item_state(
-    strmap* map,
+    mfu_cmpmap* map,
     const char *key,
     dcmp_field field,
     dcmp_state *state)
 {
     /* lookup item from map */
-    const char* val = strmap_get(map, key);
-    if (val == NULL) {
+    uint64_t idx;
+    if (mfu_cmpmap_lookup(map, key, &idx) != 0) {
         return -1;
     }
 
     /* extract state */
-    assert(strlen(val) > DCMPF_MAX);
     assert(field < DCMPF_MAX);
-    size_t position = strlen(val) - DCMPF_MAX;
-    *state = val[position + field];
+    *state = (dcmp_state)(DCMPS_INIT + mfu_cmpmap_get_state(map, idx, field));
 
     return 0;
 }
 
 /* map each file name to its index in the file list and initialize
  * its state for comparison operation */
-static strmap* dcmp_strmap_creat(mfu_flist list, const char* prefix)
+static mfu_cmpmap* dcmp_strmap_creat(mfu_flist list, const char* prefix)
 {
-    /* create a new string map to map a file name to a string
-     * encoding its index and state */
-    strmap* map = strmap_new();
-
-    /* determine length of prefix string */
-    size_t prefix_len = strlen(prefix);
-
-    /* iterate over each item in the file list */
-    uint64_t i = 0;
-    uint64_t count = mfu_flist_size(list);
-    while (i < count) {
-        /* get full path of file name */
-        const char* name = mfu_flist_file_get_name(list, i);
-
-        /* ignore prefix portion of path */
-        name += prefix_len;
-
-        /* create entry for this file */
-        dcmp_strmap_item_init(map, name, i);
-
-        /* go to next item in list */
-        i++;
-    }
+    /* each state must fit in the map */
+    assert(DCMPF_MAX <= MFU_CMPMAP_FIELDS);
+    assert(DCMPS_MAX - DCMPS_INIT <= MFU_CMPMAP_STATE_MAX);
 
+    /* keys are file names without the prefix portion of the path,
+     * every field starts in DCMPS_INIT */
+    mfu_cmpmap* map = mfu_cmpmap_new(list, strlen(prefix));
     return map;
 }
 
@@ -498,8 +430,8 @@ static void dcmp_compare_acl(
     uint64_t src_index,
     mfu_flist dst_list,
     uint64_t dst_index,
-    strmap* src_map,
-    strmap* dst_map,
+    mfu_cmpmap* src_map,
+    mfu_cmpmap* dst_map,
     int *diff)
 {
     void *src_val, *dst_val;
@@ -570,10 +502,10 @@ static int dcmp_option_need_compare(dcmp_field field)
 /* Return -1 when error, return 0 when equal, return > 0 when diff */
 static int dcmp_compare_metadata(
     mfu_flist src_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     uint64_t src_index,
     mfu_flist dst_list,
-    strmap* dst_map,
+    mfu_cmpmap* dst_map,
     uint64_t dst_index,
     const char* key)
 {
@@ -768,9 +700,9 @@ static void compare_progress_fn(const uint64_t* vals, int count, int complete, i
  * in comparison results in source and dest string maps */
 static int dcmp_strmap_compare_data(
     mfu_flist src_compare_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_compare_list,
-    strmap* dst_map,
+    mfu_cmpmap* dst_map,
     size_t strlen_prefix,
     mfu_copy_opts_t* copy_opts,
     mfu_file_t* mfu_src_file,
@@ -860,6 +792,9 @@ static int dcmp_strmap_compare_data(
         dst_p = dst_p->next;
     }
 
+    /* close files left open while comparing */
+    mfu_compare_contents_close(mfu_src_file, mfu_dst_file);
+
     /* finalize progress messages */
     uint64_t count_bytes[2];
     count_bytes[0] = bytes_read;
@@ -872,9 +807,9 @@ static int dcmp_strmap_compare_data(
     /* execute logical OR over chunks for each file */
     mfu_file_chunk_list_lor(src_compare_list, src_head, vals, results);
 
-    /* unpack contents of recv buffer & store results in strmap */
+    /* unpack contents of recv buffer & store results in map */
     for (i = 0; i < size; i++) {
-        /* lookup name of file based on id to send to strmap updata call */
+        /* lookup name of file based on id to send to map update call */
         const char* name = mfu_flist_file_get_name(src_compare_list, i);
 
         /* ignore prefix portion of path to use as key */
@@ -883,7 +818,7 @@ static int dcmp_strmap_compare_data(
         /* get comparison results for this item */
         int flag = results[i];
 
-        /* set flag in strmap to record status of file */
+        /* set flag in map to record status of file */
         if (flag != 0) {
             /* update to say contents of the files were found to be different */
             dcmp_strmap_item_update(src_map, name, DCMPF_CONTENT, DCMPS_DIFFER);
@@ -970,9 +905,9 @@ static void time_strmap_compare(mfu_flist src_list, double start_compare,
 /* compare entries from src into dst */
 static int dcmp_strmap_compare(
     mfu_flist src_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_list,
-    strmap* dst_map,
+    mfu_cmpmap* dst_map,
     size_t strlen_prefix,
     mfu_copy_opts_t* copy_opts,
     const mfu_param_path* src_path,
@@ -1009,11 +944,11 @@ static int dcmp_strmap_compare(
     uint64_t dst_mtime_nsec;
 
     /* iterate over each item in source map */
-    const strmap_node* node;
-    strmap_foreach(src_map, node) {
+    uint64_t node;
+    mfu_cmpmap_foreach(src_map, node) {
 
         /* get file name */
-        const char* key = strmap_node_key(node);
+        const char* key = mfu_cmpmap_key(src_map, node);
 
         /* get index of source file */
         uint64_t src_index;
@@ -1168,15 +1103,15 @@ static int dcmp_strmap_compare(
 }
 
 /* loop on the src map to check the results */
-static void dcmp_strmap_check_src(strmap* src_map,
-                                  strmap* dst_map)
+static void dcmp_strmap_check_src(mfu_cmpmap* src_map,
+                                  mfu_cmpmap* dst_map)
 {
     assert(dcmp_option_need_compare(DCMPF_EXIST));
     /* iterate over each item in source map */
-    const strmap_node* node;
-    strmap_foreach(src_map, node) {
+    uint64_t node;
+    mfu_cmpmap_foreach(src_map, node) {
         /* get file name */
-        const char* key = strmap_node_key(node);
+        const char* key = mfu_cmpmap_key(src_map, node);
         int only_src = 0;
 
         /* get index of source file */
@@ -1256,16 +1191,16 @@ static void dcmp_strmap_check_src(strmap* src_map,
 }
 
 /* loop on the dest map to check the results */
-static void dcmp_strmap_check_dst(strmap* src_map,
-    strmap* dst_map)
+static void dcmp_strmap_check_dst(mfu_cmpmap* src_map,
+    mfu_cmpmap* dst_map)
 {
     assert(dcmp_option_need_compare(DCMPF_EXIST));
 
     /* iterate over each item in dest map */
-    const strmap_node* node;
-    strmap_foreach(dst_map, node) {
+    uint64_t node;
+    mfu_cmpmap_foreach(dst_map, node) {
         /* get file name */
-        const char* key = strmap_node_key(node);
+        const char* key = mfu_cmpmap_key(dst_map, node);
         int only_dest = 0;
 
         /* get index of destination file */
@@ -1357,8 +1292,8 @@ static void dcmp_strmap_check_dst(strmap* src_map,
 
 /* check the result maps are valid */
 static void dcmp_strmap_check(
-    strmap* src_map,
-    strmap* dst_map)
+    mfu_cmpmap* src_map,
+    mfu_cmpmap* dst_map)
 {
     dcmp_strmap_check_src(src_map, dst_map);
     dcmp_strmap_check_dst(src_map, dst_map);
@@ -1452,7 +1387,7 @@ static void dcmp_expression_print(
 
 static int dcmp_expression_match(
     struct dcmp_expression *expression,
-    strmap* map,
+    mfu_cmpmap* map,
     const char* key)
 {
     int ret;
@@ -1581,7 +1516,7 @@ static void dcmp_conjunction_print(
 /* if matched return 1, else return 0 */
 static int dcmp_conjunction_match(
     struct dcmp_conjunction *conjunction,
-    strmap* map,
+    mfu_cmpmap* map,
     const char* key)
 {
     struct dcmp_expression* expression;
@@ -1680,7 +1615,7 @@ static void dcmp_disjunction_print(
 /* if matched return 1, else return 0 */
 static int dcmp_disjunction_match(
     struct dcmp_disjunction* disjunction,
-    strmap* map,
+    mfu_cmpmap* map,
     const char* key,
     int is_src)
 {
@@ -1773,30 +1708,29 @@ static void dcmp_option_add_comparison(dcmp_field field)
 
 static int dcmp_output_flist_match(
     struct dcmp_output *output,
-    strmap* map,
+    mfu_cmpmap* map,
     mfu_flist flist,
     mfu_flist new_flist,
     mfu_flist *matched_flist,
     int is_src)
 {
-    const strmap_node* node;
     struct dcmp_conjunction *conjunction;
 
-    /* iterate over each item in map */
-    strmap_foreach(map, node) {
+    /* iterate over each item in map ordered by name */
+    uint64_t count;
+    uint64_t* sorted = mfu_cmpmap_sorted(map, &count);
+    uint64_t i;
+    for (i = 0; i < count; i++) {
         /* get file name */
-        const char* key = strmap_node_key(node);
-
-        /* get index of file */
-        uint64_t idx;
-        int ret = dcmp_strmap_item_index(map, key, &idx);
-        assert(ret == 0);
+        uint64_t idx = sorted[i];
+        const char* key = mfu_cmpmap_key(map, idx);
 
         if (dcmp_disjunction_match(output->disjunction, map, key, is_src)) {
             mfu_flist_increase(matched_flist);
             mfu_flist_file_copy(flist, idx, new_flist);
         }
     }
+    mfu_free(&sorted);
 
     list_for_each_entry(conjunction,
                         &output->disjunction->conjunctions,
@@ -1816,9 +1750,9 @@ static int dcmp_output_flist_match(
 static int dcmp_output_write(
     struct dcmp_output *output,
     mfu_flist src_flist,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_flist,
-    strmap* dst_map)
+    mfu_cmpmap* dst_map)
 {
     int ret = 0;
     mfu_flist new_flist = mfu_flist_subset(src_flist);
@@ -1873,9 +1807,9 @@ static int dcmp_output_write(
 
 static int dcmp_outputs_write(
     mfu_flist src_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_list,
-    strmap* dst_map)
+    mfu_cmpmap* dst_map)
 {
     struct dcmp_output* output;
     int ret = 0;
@@ -2343,8 +2277,8 @@ int main(int argc, char **argv)
     mfu_flist flist4 = mfu_flist_remap(flist2, (mfu_flist_map_fn)dcmp_map_fn, (const void*)path2);
 
     /* map each file name to its index and its comparison state */
-    strmap* map1 = dcmp_strmap_creat(flist3, path1);
-    strmap* map2 = dcmp_strmap_creat(flist4, path2);
+    mfu_cmpmap* map1 = dcmp_strmap_creat(flist3, path1);
+    mfu_cmpmap* map2 = dcmp_strmap_creat(flist4, path2);
 
     /* compare files in map1 with those in map2 */
     int tmp_rc = dcmp_strmap_compare(flist3, map1, flist4, map2, strlen(path1), copy_opts, srcpath, destpath,
@@ -2363,8 +2297,8 @@ int main(int argc, char **argv)
     dcmp_outputs_write(flist3, map1, flist4, map2);
 
     /* free maps of file names to comparison state info */
-    strmap_delete(&map1);
-    strmap_delete(&map2);
+    mfu_cmpmap_delete(&map1);
+    mfu_cmpmap_delete(&map2);
 
     /* free file lists */
     mfu_flist_free(&flist1);
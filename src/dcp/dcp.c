@@ -87,12 +87,19 @@ void print_usage(void)
     					 "to write the metadata to is expected\n");
 #endif
 #endif
+    printf("      --dynamic            - let idle processes take chunks from busy ones while copying\n");
+    printf("  -H, --hardlinks          - copy data of hard linked files once and link other names to it\n");
     printf("  -i, --input <file>       - read source list from file\n");
+    printf("      --iodepth <N>        - number of buffers to keep in flight per process (default " MFU_IO_DEPTH_STR ")\n");
+    printf("      --ioengine <ENGINE>  - engine to read and write file data in {posix, uring} (default posix)\n");
     printf("  -L, --dereference        - copy original files instead of links\n");
+    printf("      --open-files <N>     - number of files to keep open per process (default " MFU_OPEN_FILES_STR ")\n");
     printf("  -P, --no-dereference     - don't follow links in source\n");
+    printf("      --offload            - try reflink and copy_file_range before copying through buffers\n");
     printf("  -p, --preserve           - preserve permissions, ownership, timestamps, extended attributes\n");
     printf("  -s, --direct             - open files with O_DIRECT\n");
     printf("  -S, --sparse             - create sparse files when possible\n");
+    printf("      --sync-mode <MODE>   - how to flush copied data to disk in {node, fs, file} (default fs)\n");
     printf("      --progress <N>       - print progress every N seconds\n");
     printf("  -v, --verbose            - verbose output\n");
     printf("  -q, --quiet              - quiet output\n");
@@ -148,14 +155,21 @@ int main(int argc, char** argv)
         {"daos-prefix"          , required_argument, 0, 'X'},
         {"daos-api"             , required_argument, 0, 'x'},
         {"daos-preserve"        , required_argument, 0, 'D'},
+        {"dynamic"              , no_argument      , 0, 'Z'},
+        {"hardlinks"            , no_argument      , 0, 'H'},
         {"input"                , required_argument, 0, 'i'},
+        {"iodepth"              , required_argument, 0, 'I'},
+        {"ioengine"             , required_argument, 0, 'E'},
         {"chunksize"            , required_argument, 0, 'k'},
         {"dereference"          , no_argument      , 0, 'L'},
         {"no-dereference"       , no_argument      , 0, 'P'},
+        {"offload"              , no_argument      , 0, 'O'},
+        {"open-files"           , required_argument, 0, 'F'},
         {"preserve"             , no_argument      , 0, 'p'},
         {"synchronous"          , no_argument      , 0, 's'},
         {"direct"               , no_argument      , 0, 's'},
         {"sparse"               , no_argument      , 0, 'S'},
+        {"sync-mode"            , required_argument, 0, 'Y'},
         {"progress"             , required_argument, 0, 'R'},
         {"verbose"              , no_argument      , 0, 'v'},
         {"quiet"                , no_argument      , 0, 'q'},
@@ -168,7 +182,7 @@ int main(int argc, char** argv)
     int usage = 0;
     while(1) {
         int c = getopt_long(
-                    argc, argv, "b:d:g:i:k:LPpsSvqh",
+                    argc, argv, "b:d:g:i:k:HLPpsSvqh",
                     long_options, &option_index
                 );
 
@@ -264,6 +278,38 @@ int main(int argc, char** argv)
                     MFU_LOG(MFU_LOG_INFO, "Using input list.");
                 }
                 break;
+            case 'F':
+                mfu_copy_opts->open_files = atoi(optarg);
+                if (mfu_copy_opts->open_files < 1) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR,
+                                "Number of open files must be a positive integer: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
+            case 'Z':
+                mfu_copy_opts->dynamic = true;
+                break;
+            case 'E':
+                if (mfu_io_engine_parse(optarg, &mfu_copy_opts->io_engine) != MFU_SUCCESS) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR,
+                                "Invalid I/O engine: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
+            case 'I':
+                mfu_copy_opts->io_depth = atoi(optarg);
+                if (mfu_copy_opts->io_depth < 1) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR,
+                                "I/O depth must be a positive integer: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
             case 'k':
                 if (mfu_abtoull(optarg, &bytes) != MFU_SUCCESS || bytes == 0) {
                     if (rank == 0) {
@@ -301,12 +347,33 @@ int main(int argc, char** argv)
                     MFU_LOG(MFU_LOG_INFO, "Using O_DIRECT");
                 }
                 break;
+            case 'H':
+                mfu_copy_opts->hardlinks = true;
+                if(rank == 0) {
+                    MFU_LOG(MFU_LOG_INFO, "Preserving hard links");
+                }
+                break;
+            case 'O':
+                mfu_copy_opts->offload = 1;
+                if(rank == 0) {
+                    MFU_LOG(MFU_LOG_INFO, "Using copy offload");
+                }
+                break;
             case 'S':
                 mfu_copy_opts->sparse = 1;
                 if(rank == 0) {
                     MFU_LOG(MFU_LOG_INFO, "Using sparse file");
                 }
                 break;
+            case 'Y':
+                if (mfu_sync_mode_parse(optarg, &mfu_copy_opts->sync_mode) != MFU_SUCCESS) {
+                    if (rank == 0) {
+                        MFU_LOG(MFU_LOG_ERR,
+                                "Invalid sync mode: '%s'", optarg);
+                    }
+                    usage = 1;
+                }
+                break;
             case 'R':
                 mfu_progress_timeout = atoi(optarg);
                 break;
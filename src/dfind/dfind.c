@@ -164,6 +164,12 @@ static void print_usage(void)
     printf("  -q, --quiet             - quiet output\n");
     printf("  -h, --help              - print usage\n");
     printf("\n");
+    printf("Walk:\n");
+    printf("  --maxdepth N   - descend at most N levels below each path (not with --input)\n");
+    printf("  --prune        - don't descend into directories matching the tests given before --prune (not with --input)\n");
+    printf("  --incremental FILE\n");
+    printf("                 - reuse entries of unchanged directories from list in FILE\n");
+    printf("\n");
     printf("Tests:\n");
     printf("  --amin N       - last accessed N minutes ago\n");
     printf("  --anewer FILE  - last accessed more recently than FILE modified\n");
@@ -208,6 +214,16 @@ static void mfu_flist_pred(mfu_flist flist, mfu_pred* p)
     return;
 }
 
+/* when a cache is read only to run tests and actions on its items,
+ * it is read in batches of this many items rather than all at once */
+#define DFIND_BATCH_SIZE (1024 * 1024)
+
+/* apply predicate tests and actions to items in a batch */
+static void mfu_flist_pred_batch(mfu_flist batch, void* arg)
+{
+    mfu_flist_pred(batch, (mfu_pred*) arg);
+}
+
 /* look up mtimes for specified file,
  * return secs/nsecs in newly allocated mfu_pred_times struct,
  * return NULL on error */
@@ -262,6 +278,26 @@ static int add_type(mfu_pred* p, char t)
     return 1;
 }
 
+/* check that a predicate list can be used to prune directories,
+ * it must have at least one test and no actions */
+static int pred_prune_ok (const mfu_pred* p)
+{
+    int tests = 0;
+
+    const mfu_pred* cur = p;
+    while (cur) {
+        if (cur->f == MFU_PRED_PRINT || cur->f == MFU_PRED_EXEC) {
+            return 0;
+        }
+        if (cur->f != NULL) {
+            tests++;
+        }
+        cur = cur->next;
+    }
+
+    return (tests > 0);
+}
+
 static void pred_commit (mfu_pred* p)
 {
     int need_print = 1;
@@ -304,8 +340,10 @@ int main (int argc, char** argv)
     int ch;
 
     mfu_pred* pred_head = mfu_pred_new();
+    mfu_pred* prune_head = NULL;
     char* inputname  = NULL;
     char* outputname = NULL;
+    char* prevname   = NULL;
     int walk = 0;
     int text = 0;
     int rc = 0;
@@ -324,6 +362,8 @@ int main (int argc, char** argv)
         {"help",        0, 0, 'h'},
 
         { "maxdepth", required_argument, NULL, 'd' },
+        { "prune",    no_argument,       NULL, 'X' },
+        { "incremental", required_argument, NULL, 'I' },
 
         { "amin",     required_argument, NULL, 'a' },
         { "anewer",   required_argument, NULL, 'B' },
@@ -351,8 +391,6 @@ int main (int argc, char** argv)
         { NULL, 0, NULL, 0 },
     };
 
-    options.maxdepth = INT_MAX;
-
     int usage = 0;
     while (1) {
         int c = getopt_long(
@@ -419,7 +457,26 @@ int main (int argc, char** argv)
     	    break;
 
     	case 'd':
-    	    options.maxdepth = atoi(optarg);
+    	    walk_opts->maxdepth = atoi(optarg);
+    	    if (walk_opts->maxdepth < 0) {
+                if (rank == 0) {
+    	            printf("%s: invalid maxdepth %s\n", argv[0], optarg);
+                }
+    	        exit(1);
+    	    }
+    	    break;
+
+    	case 'X':
+            /* tests given so far select directories to prune,
+             * start a new list for the tests that follow */
+            if (prune_head != NULL || !pred_prune_ok(pred_head)) {
+                if (rank == 0) {
+    	            printf("%s: --prune may be used once and only after tests\n", argv[0]);
+                }
+    	        exit(1);
+            }
+            prune_head = pred_head;
+            pred_head  = mfu_pred_new();
     	    break;
 
     	case 'g':
@@ -540,6 +597,9 @@ int main (int argc, char** argv)
         case 'o':
             outputname = MFU_STRDUP(optarg);
             break;
+        case 'I':
+            prevname = MFU_STRDUP(optarg);
+            break;
         case 't':
             text = 1;
             break;
@@ -648,6 +708,23 @@ daos_setup_done:
             }
             usage = 1;
         }
+
+        /* depth and pruning are applied while walking, and a list
+         * read from a file does not record the paths it was walked from */
+        if (inputname != NULL && (walk_opts->maxdepth >= 0 || prune_head != NULL)) {
+            if (rank == 0) {
+                MFU_LOG(MFU_LOG_ERR, "--maxdepth and --prune are not supported with --input");
+            }
+            usage = 1;
+        }
+    }
+
+    /* an incremental walk reuses entries without regard to depth or pruning */
+    if (prevname != NULL && (!walk || walk_opts->maxdepth >= 0 || prune_head != NULL)) {
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "--incremental requires a <path> and cannot be used with --maxdepth or --prune");
+        }
+        usage = 1;
     }
 
     if (usage) {
@@ -660,7 +737,7 @@ daos_setup_done:
         mfu_file_delete(&mfu_file);
         mfu_finalize();
         MPI_Finalize();
-        return 0;
+        return 1;
     }
 
 
@@ -668,12 +745,36 @@ daos_setup_done:
     mfu_flist flist = mfu_flist_new();
 
     if (walk) {
+        /* skip directories matching prune tests during the walk */
+        walk_opts->prune = prune_head;
+
+        /* reuse entries of unchanged directories from a previous list */
+        mfu_flist prevlist = NULL;
+        if (prevname != NULL) {
+            prevlist = mfu_flist_new();
+            mfu_flist_read_cache(prevname, prevlist);
+            walk_opts->prev = prevlist;
+        }
+
         /* walk list of input paths */
         mfu_flist_walk_param_paths(numpaths, paths, walk_opts, flist, mfu_file);
+
+        if (prevlist != NULL) {
+            walk_opts->prev = NULL;
+            mfu_flist_free(&prevlist);
+        }
+    }
+    else if (outputname == NULL) {
+        /* without an output file, matching items are not kept, so run
+         * predicates on batches of the cache rather than holding the
+         * whole list, which leaves flist empty */
+        mfu_flist_read_cache_batches(inputname, pred_head, DFIND_BATCH_SIZE,
+            mfu_flist_pred_batch, pred_head);
     }
     else {
-        /* read data from cache file */
-        mfu_flist_read_cache(inputname, flist);
+        /* read data from cache file, skipping items the
+         * predicates rule out if the file records enough */
+        mfu_flist_read_cache_pred(inputname, flist, pred_head);
     }
 
     /* apply predicates to each item in list */
@@ -698,12 +799,14 @@ daos_setup_done:
     /* free users, groups, and files objects */
     mfu_flist_free(&flist);
 
-    /* free predicate list */
+    /* free predicate lists */
     mfu_pred_free(&pred_head);
+    mfu_pred_free(&prune_head);
 
     /* free memory allocated for options */
     mfu_free(&outputname);
     mfu_free(&inputname);
+    mfu_free(&prevname);
 
     /* free the path parameters */
     mfu_param_path_free_all(numpaths, paths);
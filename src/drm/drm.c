@@ -88,6 +88,7 @@ int main(int argc, char** argv)
     int name         = 0;
     int dryrun       = 0;
     int traceless    = 0;
+    int stat_requested = 0;
     int text         = 0;
 
 #ifdef DAOS_SUPPORT
@@ -151,6 +152,7 @@ int main(int argc, char** argv)
             case 's':
                 /* stat each file during the walk */
                 walk_opts->use_stat = 1;
+                stat_requested = 1;
                 break;
             case 'e':
                 regex_exp = MFU_STRDUP(optarg);
@@ -334,6 +336,13 @@ daos_setup_done:
     /* get our list of files, either by walking or reading an
      * input file */
     if (walk) {
+        /* we only need the file type to remove items, but keep full
+         * stat data if the user asked for it or if we print or write
+         * the list, since items may be gone by the time we do */
+        if (!stat_requested && !dryrun && outputname == NULL) {
+            walk_opts->stat_mask = MFU_STAT_MODE;
+        }
+
         /* walk list of input paths */
         mfu_flist_walk_param_paths(numpaths, paths, walk_opts, flist, mfu_file);
     }
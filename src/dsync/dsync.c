@@ -38,7 +38,7 @@
 #include <assert.h>
 
 #include "mfu.h"
-#include "strmap.h"
+#include "mfu_cmpmap.h"
 #include "list.h"
 
 #include "mfu_errors.h"
@@ -69,11 +69,18 @@ static void print_usage(void)
 #endif
     printf("  -c, --contents          - read and compare file contents rather than compare size and mtime\n");
     printf("  -D, --delete            - delete extraneous files from target\n");
+    printf("      --dynamic           - let idle processes take chunks from busy ones while copying\n");
+    printf("  -H, --hardlinks         - copy data of hard linked files once and link other names to it\n");
+    printf("      --iodepth <N>       - number of buffers to keep in flight per process (default " MFU_IO_DEPTH_STR ")\n");
+    printf("      --ioengine <ENGINE> - engine to read and write file data in {posix, uring} (default posix)\n");
     printf("  -L, --dereference       - copy original files instead of links\n");
     printf("  -P, --no-dereference    - don't follow links in source\n"); 
+    printf("      --offload           - try reflink and copy_file_range before copying through buffers\n");
+    printf("      --open-files <N>    - number of files to keep open per process (default " MFU_OPEN_FILES_STR ")\n");
     printf("  -s, --direct            - open files with O_DIRECT\n");
     printf("      --link-dest <DIR>   - hardlink to files in DIR when unchanged\n");
     printf("  -S, --sparse            - create sparse files when possible\n");
+    printf("      --sync-mode <MODE>  - how to flush copied data to disk in {node, fs, file} (default fs)\n");
     printf("      --progress <N>      - print progress every N seconds\n");
     printf("  -v, --verbose           - verbose output\n");
     printf("  -q, --quiet             - quiet output\n");
@@ -375,131 +382,63 @@ static int dsync_state_from_string(const char* string, dsync_state *state)
     return -ENOENT;
 }
 
-/* given a filename as the key, encode an index followed
- * by the init state */
-static void dsync_strmap_item_init(
-    strmap* map,
-    const char *key,
-    uint64_t item_index)
-{
-    /* Should be long enough for 64 bit number and DCMPF_MAX */
-    char val[21 + DCMPF_MAX];
-    int i;
-
-    /* encode the index */
-    int len = snprintf(val, sizeof(val), "%llu",
-                       (unsigned long long) item_index);
-
-    /* encode the state (state characters and trailing NUL) */
-    assert((size_t)len + DCMPF_MAX + 1 <= (sizeof(val)));
-    size_t position = strlen(val);
-    for (i = 0; i < DCMPF_MAX; i++) {
-        val[position] = DCMPS_INIT;
-        position++;
-    }
-    val[position] = '\0';
-
-    /* add item to map */
-    strmap_set(map, key, val);
-}
-
+/* record the state of a field of the item with the given key */
 static void dsync_strmap_item_update(
-    strmap* map,
+    mfu_cmpmap* map,
     const char *key,
     dsync_field field,
     dsync_state state)
 {
-    /* Should be long enough for 64 bit number and DCMPF_MAX */
-    char new_val[21 + DCMPF_MAX];
-
     /* lookup item from map */
-    const char* val = strmap_get(map, key);
+    uint64_t idx;
+    if (mfu_cmpmap_lookup(map, key, &idx) != 0) {
+        MFU_ABORT(-1, "Failed to find item in comparison map: '%s'", key);
+    }
 
-    /* copy existing index over */
+    /* states are stored relative to the initial state */
     assert(field < DCMPF_MAX);
-    assert(strlen(val) + 1 <= sizeof(new_val));
-    strcpy(new_val, val);
-
-    /* set new state value */
-    size_t position = strlen(new_val) - DCMPF_MAX;
-    new_val[position + field] = state;
-
-    /* reinsert item in map */
-    strmap_set(map, key, new_val);
+    mfu_cmpmap_set_state(map, idx, field, state - DCMPS_INIT);
 }
 
 static int dsync_strmap_item_index(
-    strmap* map,
+    mfu_cmpmap* map,
     const char *key,
     uint64_t *item_index)
 {
-    /* Should be long enough for 64 bit number and DCMPF_MAX */
-    char new_val[21 + DCMPF_MAX];
-
     /* lookup item from map */
-    const char* val = strmap_get(map, key);
-    if (val == NULL) {
-        return -1;
-    }
-
-    /* extract index */
-    assert(strlen(val) + 1 <= sizeof(new_val));
-    strcpy(new_val, val);
-    new_val[strlen(new_val) - DCMPF_MAX] = '\0';
-    *item_index = strtoull(new_val, NULL, 0);
-
-    return 0;
+    return mfu_cmpmap_lookup(map, key, item_index);
 }
 
 static int dsync_strmap_item_state(
-    strmap* map,
+    mfu_cmpmap* map,
     const char *key,
     dsync_field field,
     dsync_state *state)
 {
     /* lookup item from map */
-    const char* val = strmap_get(map, key);
-    if (val == NULL) {
+    uint64_t idx;
+    if (mfu_cmpmap_lookup(map, key, &idx) != 0) {
         return -1;
     }
 
     /* extract state */
-    assert(strlen(val) > DCMPF_MAX);
     assert(field < DCMPF_MAX);
-    size_t position = strlen(val) - DCMPF_MAX;
-    *state = val[position + field];
+    *state = (dsync_state)(DCMPS_INIT + mfu_cmpmap_get_state(map, idx, field));
 
     return 0;
 }
 
 /* map each file name to its index in the file list and initialize
  * its state for comparison operation */
-static strmap* dsync_strmap_creat(mfu_flist list, const char* prefix)
+static mfu_cmpmap* dsync_strmap_creat(mfu_flist list, const char* prefix)
 {
-    /* create a new string map to map a file name to a string
-     * encoding its index and state */
-    strmap* map = strmap_new();
-
-    /* determine length of prefix string */
-    size_t prefix_len = strlen(prefix);
-
-    /* iterate over each item in the file list */
-    uint64_t i = 0;
-    uint64_t count = mfu_flist_size(list);
-    while (i < count) {
-        /* get full path of file name */
-        const char* name = mfu_flist_file_get_name(list, i);
-
-        /* ignore prefix portion of path */
-        name += prefix_len;
-
-        /* create entry for this file */
-        dsync_strmap_item_init(map, name, i);
-
-        /* go to next item in list */
-        i++;
-    }
+    /* each state must fit in the map */
+    assert(DCMPF_MAX <= MFU_CMPMAP_FIELDS);
+    assert(DCMPS_MAX - DCMPS_INIT <= MFU_CMPMAP_STATE_MAX);
 
+    /* keys are file names without the prefix portion of the path,
+     * every field starts in DCMPS_INIT */
+    mfu_cmpmap* map = mfu_cmpmap_new(list, strlen(prefix));
     return map;
 }
 
@@ -524,8 +463,8 @@ static void dsync_compare_acl(
     uint64_t src_index,
     mfu_flist dst_list,
     uint64_t dst_index,
-    strmap* src_map,
-    strmap* dst_map,
+    mfu_cmpmap* src_map,
+    mfu_cmpmap* dst_map,
     int *diff)
 {
     void *src_val, *dst_val;
@@ -596,10 +535,10 @@ static int dsync_option_need_compare(dsync_field field)
 /* Return -1 when error, return 0 when equal, return > 0 when diff */
 static int dsync_compare_metadata(
     mfu_flist src_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     uint64_t src_index,
     mfu_flist dst_list,
-    strmap* dst_map,
+    mfu_cmpmap* dst_map,
     uint64_t dst_index,
     const char* key)
 {
@@ -803,6 +742,9 @@ static void dsync_strmap_compare_data_link_dest(
         dst_p = dst_p->next;
     }
 
+    /* close files left open while comparing */
+    mfu_compare_contents_close(mfu_src_file, mfu_dst_file);
+
     /* finalize progress messages */
     count_bytes[0] = *count_bytes_read;
     count_bytes[1] = *count_bytes_written;
@@ -814,12 +756,12 @@ static void dsync_strmap_compare_data_link_dest(
     /* execute logical OR over chunks for each file */
     mfu_file_chunk_list_lor(src_compare_list, src_head, vals, results);
 
-    /* unpack contents of recv buffer & store results in strmap */
+    /* unpack contents of recv buffer & store results in map */
     for (i = 0; i < size; i++) {
         /* get comparison results for this item */
         int flag = results[i];
 
-        /* set flag in strmap to record status of file */
+        /* set flag in map to record status of file */
         if (flag == 0) {
             /* if same, add to same list */
 	    mfu_flist_file_copy(link_compare_list, i, link_same_list);
@@ -841,9 +783,9 @@ static void dsync_strmap_compare_data_link_dest(
 
 static int dsync_strmap_compare_data(
     mfu_flist src_compare_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_compare_list,
-    strmap* dst_map,
+    mfu_cmpmap* dst_map,
     mfu_flist src_list,
     mfu_flist src_cp_list,
     mfu_flist dst_same_list,
@@ -943,6 +885,9 @@ static int dsync_strmap_compare_data(
         dst_p = dst_p->next;
     }
 
+    /* close files left open while comparing */
+    mfu_compare_contents_close(mfu_src_file, mfu_dst_file);
+
     /* finalize progress messages */
     count_bytes[0] = *count_bytes_read;
     count_bytes[1] = *count_bytes_written;
@@ -954,9 +899,9 @@ static int dsync_strmap_compare_data(
     /* execute logical OR over chunks for each file */
     mfu_file_chunk_list_lor(src_compare_list, src_head, vals, results);
 
-    /* unpack contents of recv buffer & store results in strmap */
+    /* unpack contents of recv buffer & store results in map */
     for (i = 0; i < size; i++) {
-        /* lookup name of file based on id to send to strmap updata call */
+        /* lookup name of file based on id to send to map update call */
         const char* name = mfu_flist_file_get_name(src_compare_list, i);
 
         /* ignore prefix portion of path to use as key */
@@ -965,7 +910,7 @@ static int dsync_strmap_compare_data(
         /* get comparison results for this item */
         int flag = results[i];
 
-        /* set flag in strmap to record status of file */
+        /* set flag in map to record status of file */
         if (flag != 0) {
             /* update to say contents of the files were found to be different */
             dsync_strmap_item_update(src_map, name, DCMPF_CONTENT, DCMPS_DIFFER);
@@ -1017,7 +962,7 @@ static void dsync_generate_real_lists(
     size_t src_strlen_prefix,   /* length of prefix string to source directory */
     const mfu_param_path *link_path, /* param path for link-dest directory */
     mfu_flist dst_list,         /* list of files in destination */
-    strmap *dst_map,            /* map each file in destination to its index in dst_list */
+    mfu_cmpmap* dst_map,            /* map each file in destination to its index in dst_list */
     mfu_flist src_cp_list,      /* list of files to be copied to destination */
     mfu_flist dst_same_list,    /* list of files in destination that are same as in source */
     mfu_flist link_same_list,   /* list of files in link-dest that are same as in source */
@@ -1029,7 +974,7 @@ static void dsync_generate_real_lists(
     uint64_t idx;
 
     /* create map of item name to index in its respective list */
-    strmap* link_same_map = dsync_strmap_creat(link_same_list, link_path->path);
+    mfu_cmpmap* link_same_map = dsync_strmap_creat(link_same_list, link_path->path);
 
     /* walk list of files we need to copy from source to destination,
      * and split into set that must actually be copied and set that
@@ -1122,7 +1067,7 @@ static void dsync_generate_real_lists(
     mfu_flist_summarize(dst_remove_list);
 
     /* free the map */
-    strmap_delete(&link_same_map);
+    mfu_cmpmap_delete(&link_same_map);
 }
 
 /* given a list of source/destination files to compare, spread file
@@ -1165,10 +1110,10 @@ static int dsync_strmap_compare_lite(
     mfu_flist src_compare_list,
     mfu_flist src_cp_list,
     mfu_flist dst_same_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_compare_list,
     mfu_flist dst_remove_list,
-    strmap* dst_map,
+    mfu_cmpmap* dst_map,
     size_t strlen_prefix,
     bool use_hardlinks)
 {
@@ -1181,7 +1126,7 @@ static int dsync_strmap_compare_lite(
     /* check size and mtime of each item */
     uint64_t idx;
     for (idx = 0; idx < size; idx++) {
-        /* lookup name of file based on id to send to strmap updata call */
+        /* lookup name of file based on id to send to map update call */
         const char* name = mfu_flist_file_get_name(src_compare_list, idx);
 
         /* ignore prefix portion of path to use as key */
@@ -1309,14 +1254,14 @@ static void print_comparison_stats(
 
 /* loop on the dest map to check for files only in the dst list
  * and copy to a remove_list for the --sync option */
-static void dsync_only_dst(strmap* src_map,
-    strmap* dst_map, mfu_flist dst_list, mfu_flist dst_remove_list)
+static void dsync_only_dst(mfu_cmpmap* src_map,
+    mfu_cmpmap* dst_map, mfu_flist dst_list, mfu_flist dst_remove_list)
 {
     /* iterate over each item in dest map */
-    const strmap_node* node;
-    strmap_foreach(dst_map, node) {
+    uint64_t node;
+    mfu_cmpmap_foreach(dst_map, node) {
         /* get file name */
-        const char* key = strmap_node_key(node);
+        const char* key = mfu_cmpmap_key(dst_map, node);
 
         /* get index of destination file */
         uint64_t dst_index;
@@ -1334,8 +1279,8 @@ static void dsync_only_dst(strmap* src_map,
 }
 
 static int dsync_sync_files(
-    strmap* src_map,
-    strmap* dst_map,
+    mfu_cmpmap* src_map,
+    mfu_cmpmap* dst_map,
     const mfu_param_path* src_path,
     const mfu_param_path* dest_path,
     const mfu_param_path* link_path,
@@ -1428,9 +1373,9 @@ static int dsync_sync_files(
 /* compare entries from src to items in link-dest */
 static int dsync_strmap_compare_link_dest(
     mfu_flist src_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist link_list,
-    strmap* link_map,
+    mfu_cmpmap* link_map,
     mfu_flist link_same_list,
     mfu_copy_opts_t* copy_opts,
     mfu_file_t* mfu_src_file,
@@ -1452,10 +1397,10 @@ static int dsync_strmap_compare_link_dest(
     mfu_flist link_compare_list = mfu_flist_subset(link_list);
 
     /* iterate over each item in source map */
-    const strmap_node* node;
-    strmap_foreach(src_map, node) {
+    uint64_t node;
+    mfu_cmpmap_foreach(src_map, node) {
         /* get file name */
-        const char* key = strmap_node_key(node);
+        const char* key = mfu_cmpmap_key(src_map, node);
 
         /* get index of source file */
         uint64_t src_index;
@@ -1580,11 +1525,11 @@ static int dsync_strmap_compare_link_dest(
 /* compare entries from src into dst */
 static int dsync_strmap_compare(
     mfu_flist src_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_list,
-    strmap* dst_map,
+    mfu_cmpmap* dst_map,
     mfu_flist link_list,
-    strmap* link_map,
+    mfu_cmpmap* link_map,
     size_t strlen_prefix,
     mfu_copy_opts_t* copy_opts,
     const mfu_param_path* src_path,
@@ -1640,15 +1585,17 @@ static int dsync_strmap_compare(
         src_real_cp_list = mfu_flist_subset(src_list);
     }
 
-    /* use a map as a list to record source and destination indices
-     * for entries that need a refresh on metadata */
-    strmap* metadata_refresh = strmap_new();
+    /* record source and destination indices for entries that need a
+     * refresh on metadata, each source item is added at most once */
+    uint64_t refresh_count = 0;
+    uint64_t* refresh_src = (uint64_t*) MFU_MALLOC(mfu_cmpmap_size(src_map) * sizeof(uint64_t));
+    uint64_t* refresh_dst = (uint64_t*) MFU_MALLOC(mfu_cmpmap_size(src_map) * sizeof(uint64_t));
 
     /* iterate over each item in source map */
-    const strmap_node* node;
-    strmap_foreach(src_map, node) {
+    uint64_t node;
+    mfu_cmpmap_foreach(src_map, node) {
         /* get file name */
-        const char* key = strmap_node_key(node);
+        const char* key = mfu_cmpmap_key(src_map, node);
 
         /* get index of source file */
         uint64_t src_index;
@@ -1699,7 +1646,9 @@ static int dsync_strmap_compare(
         if ((uid_state == DCMPS_DIFFER) || (gid_state == DCMPS_DIFFER) ||
             (perm_state == DCMPS_DIFFER) || (atime_state == DCMPS_DIFFER) ||
             (mtime_state == DCMPS_DIFFER)) {
-            strmap_setf(metadata_refresh, "%llu=%llu", src_index, dst_index);
+            refresh_src[refresh_count] = src_index;
+            refresh_dst[refresh_count] = dst_index;
+            refresh_count++;
         }
 
         /* Skip if no need to compare type.
@@ -1904,15 +1853,11 @@ static int dsync_strmap_compare(
         }
 
         /* update metadata on files */
-        strmap_foreach(metadata_refresh, node) {
+        uint64_t i;
+        for (i = 0; i < refresh_count; i++) {
             /* extract source and destination indices */
-            unsigned long long src_i, dst_i;
-            const char* key = strmap_node_key(node);
-            const char* val = strmap_node_value(node);
-            sscanf(key, "%llu", &src_i);
-            sscanf(val, "%llu", &dst_i);
-            uint64_t src_index = (uint64_t) src_i;
-            uint64_t dst_index = (uint64_t) dst_i;
+            uint64_t src_index = refresh_src[i];
+            uint64_t dst_index = refresh_dst[i];
 
             /* copy metadata values from source to destination, if needed */
             tmp_rc = mfu_flist_file_sync_meta(src_list, src_index, dst_list,
@@ -1928,7 +1873,8 @@ static int dsync_strmap_compare(
     }
 
     /* done with our list of files for refreshing metadata */
-    strmap_delete(&metadata_refresh);
+    mfu_free(&refresh_src);
+    mfu_free(&refresh_dst);
 
     /* free lists used for removing and copying files */
     mfu_flist_free(&dst_remove_list);
@@ -1956,15 +1902,15 @@ static int dsync_strmap_compare(
 }
 
 /* loop on the src map to check the results */
-static void dsync_strmap_check_src(strmap* src_map,
-                                  strmap* dst_map)
+static void dsync_strmap_check_src(mfu_cmpmap* src_map,
+                                  mfu_cmpmap* dst_map)
 {
     assert(dsync_option_need_compare(DCMPF_EXIST));
     /* iterate over each item in source map */
-    const strmap_node* node;
-    strmap_foreach(src_map, node) {
+    uint64_t node;
+    mfu_cmpmap_foreach(src_map, node) {
         /* get file name */
-        const char* key = strmap_node_key(node);
+        const char* key = mfu_cmpmap_key(src_map, node);
         int only_src = 0;
 
         /* get index of source file */
@@ -2043,16 +1989,16 @@ static void dsync_strmap_check_src(strmap* src_map,
 }
 
 /* loop on the dest map to check the results */
-static void dsync_strmap_check_dst(strmap* src_map,
-    strmap* dst_map)
+static void dsync_strmap_check_dst(mfu_cmpmap* src_map,
+    mfu_cmpmap* dst_map)
 {
     assert(dsync_option_need_compare(DCMPF_EXIST));
 
     /* iterate over each item in dest map */
-    const strmap_node* node;
-    strmap_foreach(dst_map, node) {
+    uint64_t node;
+    mfu_cmpmap_foreach(dst_map, node) {
         /* get file name */
-        const char* key = strmap_node_key(node);
+        const char* key = mfu_cmpmap_key(dst_map, node);
         int only_dest = 0;
 
         /* get index of destination file */
@@ -2144,8 +2090,8 @@ static void dsync_strmap_check_dst(strmap* src_map,
 
 /* check the result maps are valid */
 static void dsync_strmap_check(
-    strmap* src_map,
-    strmap* dst_map)
+    mfu_cmpmap* src_map,
+    mfu_cmpmap* dst_map)
 {
     dsync_strmap_check_src(src_map, dst_map);
     dsync_strmap_check_dst(src_map, dst_map);
@@ -2239,7 +2185,7 @@ static void dsync_expression_print(
 
 static int dsync_expression_match(
     struct dsync_expression *expression,
-    strmap* map,
+    mfu_cmpmap* map,
     const char* key)
 {
     int ret;
@@ -2367,7 +2313,7 @@ static void dsync_conjunction_print(
 /* if matched return 1, else return 0 */
 static int dsync_conjunction_match(
     struct dsync_conjunction *conjunction,
-    strmap* map,
+    mfu_cmpmap* map,
     const char* key)
 {
     struct dsync_expression* expression;
@@ -2455,7 +2401,7 @@ static void dsync_disjunction_print(
 /* if matched return 1, else return 0 */
 static int dsync_disjunction_match(
     struct dsync_disjunction* disjunction,
-    strmap* map,
+    mfu_cmpmap* map,
     const char* key,
     int is_src)
 {
@@ -2548,30 +2494,29 @@ static void dsync_option_add_comparison(dsync_field field)
 
 static int dsync_output_flist_match(
     struct dsync_output *output,
-    strmap* map,
+    mfu_cmpmap* map,
     mfu_flist flist,
     mfu_flist new_flist,
     mfu_flist *matched_flist,
     int is_src)
 {
-    const strmap_node* node;
     struct dsync_conjunction *conjunction;
 
-    /* iterate over each item in map */
-    strmap_foreach(map, node) {
+    /* iterate over each item in map ordered by name */
+    uint64_t count;
+    uint64_t* sorted = mfu_cmpmap_sorted(map, &count);
+    uint64_t i;
+    for (i = 0; i < count; i++) {
         /* get file name */
-        const char* key = strmap_node_key(node);
-
-        /* get index of file */
-        uint64_t idx;
-        int ret = dsync_strmap_item_index(map, key, &idx);
-        assert(ret == 0);
+        uint64_t idx = sorted[i];
+        const char* key = mfu_cmpmap_key(map, idx);
 
         if (dsync_disjunction_match(output->disjunction, map, key, is_src)) {
             mfu_flist_increase(matched_flist);
             mfu_flist_file_copy(flist, idx, new_flist);
         }
     }
+    mfu_free(&sorted);
 
     list_for_each_entry(conjunction,
                         &output->disjunction->conjunctions,
@@ -2591,9 +2536,9 @@ static int dsync_output_flist_match(
 static int dsync_output_write(
     struct dsync_output *output,
     mfu_flist src_flist,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_flist,
-    strmap* dst_map)
+    mfu_cmpmap* dst_map)
 {
     int ret = 0;
     mfu_flist new_flist = mfu_flist_subset(src_flist);
@@ -2644,9 +2589,9 @@ static int dsync_output_write(
 
 static int dsync_outputs_write(
     mfu_flist src_list,
-    strmap* src_map,
+    mfu_cmpmap* src_map,
     mfu_flist dst_list,
-    strmap* dst_map)
+    mfu_cmpmap* dst_map)
 {
     struct dsync_output* output;
     int ret = 0;
@@ -3025,13 +2970,20 @@ int main(int argc, char **argv)
         {"daos-api",       1, 0, 'x'},
         {"contents",       0, 0, 'c'},
         {"delete",         0, 0, 'D'},
+        {"dynamic",        0, 0, 'Z'},
+        {"hardlinks",      0, 0, 'H'},
+        {"iodepth",        1, 0, 'I'},
+        {"ioengine",       1, 0, 'E'},
         {"dereference",    0, 0, 'L'},
         {"no-dereference", 0, 0, 'P'},
+        {"offload",        0, 0, 'O'},
+        {"open-files",     1, 0, 'F'},
         {"direct",         0, 0, 's'},
         {"output",         1, 0, 'o'}, // undocumented
         {"debug",          0, 0, 'd'}, // undocumented
         {"link-dest",      1, 0, 'l'},
         {"sparse",         0, 0, 'S'},
+        {"sync-mode",      1, 0, 'Y'},
         {"progress",       1, 0, 'R'},
         {"verbose",        0, 0, 'v'},
         {"quiet",          0, 0, 'q'},
@@ -3051,7 +3003,7 @@ int main(int argc, char **argv)
 
     while (1) {
         int c = getopt_long(
-            argc, argv, "b:cDso:LPSvqh",
+            argc, argv, "b:cDHso:LPSvqh",
             long_options, &option_index
         );
 
@@ -3096,6 +3048,38 @@ int main(int argc, char **argv)
             }
             break;
 #endif
+        case 'F':
+            copy_opts->open_files = atoi(optarg);
+            if (copy_opts->open_files < 1) {
+                if (rank == 0) {
+                    MFU_LOG(MFU_LOG_ERR,
+                            "Number of open files must be a positive integer: '%s'", optarg);
+                }
+                usage = 1;
+            }
+            break;
+        case 'Z':
+            copy_opts->dynamic = true;
+            break;
+        case 'E':
+            if (mfu_io_engine_parse(optarg, &copy_opts->io_engine) != MFU_SUCCESS) {
+                if (rank == 0) {
+                    MFU_LOG(MFU_LOG_ERR,
+                            "Invalid I/O engine: '%s'", optarg);
+                }
+                usage = 1;
+            }
+            break;
+        case 'I':
+            copy_opts->io_depth = atoi(optarg);
+            if (copy_opts->io_depth < 1) {
+                if (rank == 0) {
+                    MFU_LOG(MFU_LOG_ERR,
+                            "I/O depth must be a positive integer: '%s'", optarg);
+                }
+                usage = 1;
+            }
+            break;
         case 'c':
             options.contents++;
             break;
@@ -3136,9 +3120,24 @@ int main(int argc, char **argv)
         case 'd':
             options.debug++;
             break;
+        case 'H':
+            copy_opts->hardlinks = true;
+            break;
+        case 'O':
+            copy_opts->offload = 1;
+            break;
         case 'S':
             copy_opts->sparse = 1;
             break;
+        case 'Y':
+            if (mfu_sync_mode_parse(optarg, &copy_opts->sync_mode) != MFU_SUCCESS) {
+                if (rank == 0) {
+                    MFU_LOG(MFU_LOG_ERR,
+                            "Invalid sync mode: '%s'", optarg);
+                }
+                usage = 1;
+            }
+            break;
         case 'R':
             mfu_progress_timeout = atoi(optarg);
             break;
@@ -3343,9 +3342,9 @@ int main(int argc, char **argv)
     }
 
     /* map each file name to its index and its comparison state */
-    strmap* map_src = dsync_strmap_creat(flist_src, path_src);
-    strmap* map_dst = dsync_strmap_creat(flist_dst, path_dst);
-    strmap* map_link = NULL;
+    mfu_cmpmap* map_src = dsync_strmap_creat(flist_src, path_src);
+    mfu_cmpmap* map_dst = dsync_strmap_creat(flist_dst, path_dst);
+    mfu_cmpmap* map_link = NULL;
     if (options.link_dest != NULL) {
         map_link = dsync_strmap_creat(flist_link, path_link);
     }
@@ -3358,10 +3357,10 @@ int main(int argc, char **argv)
     }
 
     /* free maps of file names to comparison state info */
-    strmap_delete(&map_src);
-    strmap_delete(&map_dst);
+    mfu_cmpmap_delete(&map_src);
+    mfu_cmpmap_delete(&map_dst);
     if (options.link_dest != NULL) {
-        strmap_delete(&map_link);
+        mfu_cmpmap_delete(&map_link);
     }
 
     /* free file lists */
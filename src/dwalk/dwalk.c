@@ -45,33 +45,18 @@ struct distribute_option {
     uint64_t separators[MAX_DISTRIBUTE_SEPARATORS];
 };
 
-static void create_default_separators(struct distribute_option *option,
-                                      mfu_flist* flist,
-                                      uint64_t* size,
-                                      int* separators,
-                                      uint64_t* global_max_file_size)
+static void set_default_separators(struct distribute_option *option,
+                                   uint64_t global_max_file_size,
+                                   int* separators)
 {
-    /* get local max file size for Allreduce */
-    uint64_t local_max_file_size = 0;
-    for (int i = 0; i < *size; i++) {
-        uint64_t file_size = mfu_flist_file_get_size(*flist, i);
-        if (file_size > local_max_file_size) {
-            local_max_file_size = file_size;
-        }
-    }
-
-    /* get the max file size across all ranks */
-    MPI_Allreduce(&local_max_file_size, global_max_file_size, 1,
-                  MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
-
     /* print and convert max file size to appropriate units */
     double max_size_tmp;
     const char* max_size_units;
-    mfu_format_bytes(*global_max_file_size, &max_size_tmp, &max_size_units);
+    mfu_format_bytes(global_max_file_size, &max_size_tmp, &max_size_units);
     printf("Max File Size: %.3lf %s\n", max_size_tmp, max_size_units);
 
     /* round next_pow_2 to next multiple of 10 */
-    uint64_t max_magnitude_bin = (ceil(log2(*global_max_file_size) / 10 )) * 10;
+    uint64_t max_magnitude_bin = (ceil(log2(global_max_file_size) / 10 )) * 10;
 
     /* get bin ranges based on max file size */
     option->separators[0] = 1;
@@ -85,38 +70,37 @@ static void create_default_separators(struct distribute_option *option,
     }
 }
 
-static int print_flist_distribution(int file_histogram,
-                                    struct distribute_option *option,
-                                    mfu_flist* pflist, int rank)
+static void create_default_separators(struct distribute_option *option,
+                                      mfu_flist* flist,
+                                      uint64_t* size,
+                                      int* separators,
+                                      uint64_t* global_max_file_size)
 {
-    /* file list to use */
-    mfu_flist flist = *pflist;
-
-    /* get local size for each rank, and max file sizes */
-    uint64_t size = mfu_flist_size(flist);
-    uint64_t global_max_file_size;
-
-    int separators = 0;
-    if (file_histogram) {
-        /* create default separators */
-        create_default_separators(option, &flist, &size, &separators,
-                                  &global_max_file_size);
-    } else {
-        separators = option->separator_number;
+    /* get local max file size for Allreduce */
+    uint64_t local_max_file_size = 0;
+    for (int i = 0; i < *size; i++) {
+        uint64_t file_size = mfu_flist_file_get_size(*flist, i);
+        if (file_size > local_max_file_size) {
+            local_max_file_size = file_size;
+        }
     }
 
-    /* allocate a count for each bin, initialize the bin counts to 0
-     * it is separator + 1 because the last bin is the last separator
-     * to the DISTRIBUTE_MAX */
-    uint64_t* dist = (uint64_t*) MFU_MALLOC((separators + 1) * sizeof(uint64_t));
+    /* get the max file size across all ranks */
+    MPI_Allreduce(&local_max_file_size, global_max_file_size, 1,
+                  MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
 
-    /* initialize the bin counts to 0 */
-    for (int i = 0; i <= separators; i++) {
-        dist[i] = 0;
-    }
+    /* set separators based on max file size */
+    set_default_separators(option, *global_max_file_size, separators);
+}
 
+/* add each item of the list to the count of the bin its size falls in */
+static void count_flist_distribution(const struct distribute_option *option,
+                                     int separators, mfu_flist flist,
+                                     uint64_t* dist)
+{
     /* for each file, identify appropriate bin and increment its count */
-    for (int i = 0; i < size; i++) {
+    uint64_t size = mfu_flist_size(flist);
+    for (uint64_t i = 0; i < size; i++) {
          /* get the size of the file */
          uint64_t file_size = mfu_flist_file_get_size(flist, i);
 
@@ -142,7 +126,13 @@ static int print_flist_distribution(int file_histogram,
              dist[separators]++;
          }
     }
+}
 
+/* sum bin counts across ranks and print the distribution */
+static void print_distribution(int file_histogram,
+                               const struct distribute_option *option,
+                               int separators, uint64_t* dist, int rank)
+{
     /* get the total sum across all of the bins */
     uint64_t* disttotal = (uint64_t*) MFU_MALLOC((separators + 1) * sizeof(uint64_t));
     MPI_Allreduce(dist, disttotal, (uint64_t)separators + 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
@@ -190,11 +180,154 @@ static int print_flist_distribution(int file_histogram,
 
     /* free the memory used to hold bin counts */
     mfu_free(&disttotal);
+}
+
+static int print_flist_distribution(int file_histogram,
+                                    struct distribute_option *option,
+                                    mfu_flist* pflist, int rank)
+{
+    /* file list to use */
+    mfu_flist flist = *pflist;
+
+    /* get local size for each rank, and max file sizes */
+    uint64_t size = mfu_flist_size(flist);
+    uint64_t global_max_file_size;
+
+    int separators = 0;
+    if (file_histogram) {
+        /* create default separators */
+        create_default_separators(option, &flist, &size, &separators,
+                                  &global_max_file_size);
+    } else {
+        separators = option->separator_number;
+    }
+
+    /* allocate a count for each bin, initialize the bin counts to 0
+     * it is separator + 1 because the last bin is the last separator
+     * to the DISTRIBUTE_MAX */
+    uint64_t* dist = (uint64_t*) MFU_MALLOC((separators + 1) * sizeof(uint64_t));
+
+    /* initialize the bin counts to 0 */
+    for (int i = 0; i <= separators; i++) {
+        dist[i] = 0;
+    }
+
+    /* count items in each bin */
+    count_flist_distribution(option, separators, flist, dist);
+
+    /* sum counts across ranks and print them */
+    print_distribution(file_histogram, option, separators, dist, rank);
+
+    /* free the memory used to hold bin counts */
     mfu_free(&dist);
 
     return 0;
 }
 
+/* when only aggregate values are needed, a list is read from its cache
+ * in batches of this many items rather than all at once */
+#define DWALK_BATCH_SIZE (1024 * 1024)
+
+/* number of separators used to count items by size before the max file
+ * size is known, one for each power of 2^10 up to 2^60 */
+#define DWALK_STREAM_SEPARATORS (7)
+
+/* totals gathered from each batch of a list read in batches */
+struct dwalk_stream {
+    mfu_flist_summary_t summary;            /* counts of items by type */
+    struct distribute_option option;        /* separators to count items by */
+    int separators;                         /* number of separators */
+    uint64_t* dist;                         /* count of items in each bin, if any */
+    uint64_t max_file_size;                 /* largest size of any item */
+};
+
+/* add items of a batch to the running totals */
+static void dwalk_stream_batch(mfu_flist batch, void* arg)
+{
+    struct dwalk_stream* stream = (struct dwalk_stream*) arg;
+
+    /* count items by type */
+    mfu_flist_summary_add(batch, &stream->summary);
+
+    /* count items by size */
+    if (stream->dist != NULL) {
+        count_flist_distribution(&stream->option, stream->separators, batch, stream->dist);
+    }
+
+    /* track largest size for the default histogram */
+    uint64_t size = mfu_flist_size(batch);
+    for (uint64_t i = 0; i < size; i++) {
+        uint64_t file_size = mfu_flist_file_get_size(batch, i);
+        if (file_size > stream->max_file_size) {
+            stream->max_file_size = file_size;
+        }
+    }
+}
+
+/* read list from cache in batches and print its summary and
+ * distribution without holding the whole list in memory */
+static void dwalk_stream_cache(const char* inputname, int file_histogram,
+                               int distribution, struct distribute_option *option,
+                               int rank)
+{
+    struct dwalk_stream stream;
+    mfu_flist_summary_init(&stream.summary);
+    stream.separators     = 0;
+    stream.dist           = NULL;
+    stream.max_file_size  = 0;
+
+    if (file_histogram) {
+        /* the default bins depend on the max file size, which we only
+         * know at the end, so count using every power of 2^10 and
+         * merge the upper bins once the max is known */
+        stream.option.separators[0] = 1;
+        for (int i = 1; i < DWALK_STREAM_SEPARATORS; i++) {
+            stream.option.separators[i] = (uint64_t)1 << (10 * i);
+        }
+        stream.separators = DWALK_STREAM_SEPARATORS;
+    } else if (distribution) {
+        stream.option     = *option;
+        stream.separators = option->separator_number;
+    }
+
+    if (file_histogram || distribution) {
+        stream.dist = (uint64_t*) MFU_MALLOC((stream.separators + 1) * sizeof(uint64_t));
+        for (int i = 0; i <= stream.separators; i++) {
+            stream.dist[i] = 0;
+        }
+    }
+
+    /* add up totals of each batch */
+    mfu_flist_read_cache_batches(inputname, NULL, DWALK_BATCH_SIZE, dwalk_stream_batch, &stream);
+
+    /* print summary statistics of list */
+    mfu_flist_summary_print(&stream.summary);
+
+    /* print distribution if user specified this option */
+    if (file_histogram) {
+        /* get the max file size across all ranks */
+        uint64_t global_max_file_size;
+        MPI_Allreduce(&stream.max_file_size, &global_max_file_size, 1,
+                      MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+        /* select default bins and fold counts above the last one into it */
+        int separators = 0;
+        set_default_separators(option, global_max_file_size, &separators);
+        if (separators > DWALK_STREAM_SEPARATORS) {
+            separators = DWALK_STREAM_SEPARATORS;
+        }
+        for (int i = separators + 1; i <= DWALK_STREAM_SEPARATORS; i++) {
+            stream.dist[separators] += stream.dist[i];
+        }
+
+        print_distribution(file_histogram, option, separators, stream.dist, rank);
+    } else if (distribution) {
+        print_distribution(file_histogram, option, stream.separators, stream.dist, rank);
+    }
+
+    mfu_free(&stream.dist);
+}
+
 /* * Search the right position to insert the separator * If the separator exists already, return failure * Otherwise, locate the right position, and move the array forward to
  * save the separator.
  */
@@ -315,6 +448,10 @@ static void print_usage(void)
     printf("  -o, --output <file>     - write processed list to file in binary format\n");
     printf("  -t, --text              - use with -o; write processed list to file in ascii format\n");
     printf("  -l, --lite              - walk file system without stat\n");
+    printf("      --incremental <file>\n                          - reuse entries of unchanged directories from list in file\n");
+    printf("      --checkpoint <prefix>\n                          - periodically save walk progress to files named <prefix>.<rank>\n");
+    printf("      --checkpoint-secs <N>\n                          - save walk progress every N seconds (default 600)\n");
+    printf("      --resume <prefix>   - continue a walk from files written with --checkpoint\n");
     printf("  -s, --sort <fields>     - sort output by comma-delimited fields\n");
     printf("  -d, --distribution <field>:<separators> \n                          - print distribution by field\n");
     printf("  -f, --file_histogram    - print default size distribution of items\n");
@@ -367,6 +504,9 @@ int main(int argc, char** argv)
 
     char* inputname      = NULL;
     char* outputname     = NULL;
+    char* prevname       = NULL;
+    char* ckptname       = NULL;
+    char* resumename     = NULL;
     char* sortfields     = NULL;
     char* distribution   = NULL;
 
@@ -386,6 +526,10 @@ int main(int argc, char** argv)
         {"output",         1, 0, 'o'},
         {"text",           0, 0, 't'},
         {"lite",           0, 0, 'l'},
+        {"incremental",    1, 0, 'I'},
+        {"checkpoint",     1, 0, 'C'},
+        {"checkpoint-secs", 1, 0, 'S'},
+        {"resume",         1, 0, 'E'},
         {"sort",           1, 0, 's'},
         {"distribution",   1, 0, 'd'},
         {"file_histogram", 0, 0, 'f'},
@@ -420,6 +564,18 @@ int main(int argc, char** argv)
                 /* don't stat each file on the walk */
                 walk_opts->use_stat = 0;
                 break;
+            case 'I':
+                prevname = MFU_STRDUP(optarg);
+                break;
+            case 'C':
+                ckptname = MFU_STRDUP(optarg);
+                break;
+            case 'S':
+                walk_opts->checkpoint_secs = atoi(optarg);
+                break;
+            case 'E':
+                resumename = MFU_STRDUP(optarg);
+                break;
             case 's':
                 sortfields = MFU_STRDUP(optarg);
                 break;
@@ -553,6 +709,34 @@ daos_setup_done:
         }
     }
 
+    /* an incremental walk compares against stat info of the previous list */
+    if (prevname != NULL && (!walk || !walk_opts->use_stat)) {
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "--incremental requires a <path> and cannot be used with --lite");
+        }
+        usage = 1;
+    }
+
+    /* checkpoints record stat info of walked items */
+    if ((ckptname != NULL || resumename != NULL) && (!walk || !walk_opts->use_stat)) {
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "--checkpoint and --resume require a <path> and cannot be used with --lite");
+        }
+        usage = 1;
+    }
+    if (prevname != NULL && resumename != NULL) {
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "--incremental cannot be used with --resume");
+        }
+        usage = 1;
+    }
+    if (walk_opts->checkpoint_secs <= 0) {
+        if (rank == 0) {
+            MFU_LOG(MFU_LOG_ERR, "Seconds in --checkpoint-secs must be positive: %d invalid", walk_opts->checkpoint_secs);
+        }
+        usage = 1;
+    }
+
     /* if user is trying to sort, verify the sort fields are valid */
     if (sortfields != NULL) {
         int maxfields;
@@ -649,12 +833,43 @@ daos_setup_done:
     /* TODO: check stat fields fit within MPI types */
     // if (sizeof(st_uid) > uint64_t) error(); etc...
 
+    /* when reading a cache only to print its summary and distribution,
+     * process it in batches rather than holding the whole list */
+    int stream = (!walk && sortfields == NULL && !print && outputname == NULL);
+
     /* create an empty file list with default values */
     mfu_flist flist = mfu_flist_new();
 
     if (walk) {
+        /* the summary and distribution only need type and size,
+         * other fields are filled in on demand if needed */
+        if (sortfields == NULL && !print && outputname == NULL) {
+            walk_opts->stat_mask = MFU_STAT_MODE | MFU_STAT_SIZE;
+        }
+
+        /* read list from a previous walk to reuse unchanged directories */
+        mfu_flist prevlist = NULL;
+        if (prevname != NULL) {
+            prevlist = mfu_flist_new();
+            mfu_flist_read_cache(prevname, prevlist);
+            walk_opts->prev = prevlist;
+        }
+
+        /* save progress of the walk and continue an interrupted one */
+        walk_opts->checkpoint = ckptname;
+        walk_opts->resume     = resumename;
+
         /* walk list of input paths */
         mfu_flist_walk_param_paths(numpaths, paths, walk_opts, flist, mfu_file);
+
+        if (prevlist != NULL) {
+            walk_opts->prev = NULL;
+            mfu_flist_free(&prevlist);
+        }
+    }
+    else if (stream) {
+        /* read data from cache file and print its totals */
+        dwalk_stream_cache(inputname, file_histogram, distribution != NULL, &option, rank);
     }
     else {
         /* read data from cache file */
@@ -677,12 +892,14 @@ daos_setup_done:
         mfu_flist_print(flist);
     }
 
-    /* print summary statistics of flist */
-    mfu_flist_print_summary(flist);
+    /* print summary statistics of flist, already done if streamed */
+    if (!stream) {
+        mfu_flist_print_summary(flist);
 
-    /* print distribution if user specified this option */
-    if (distribution != NULL || file_histogram) {
-        print_flist_distribution(file_histogram, &option, &flist, rank);
+        /* print distribution if user specified this option */
+        if (distribution != NULL || file_histogram) {
+            print_flist_distribution(file_histogram, &option, &flist, rank);
+        }
     }
 
     /* write data to cache file */
@@ -706,6 +923,9 @@ daos_setup_done:
     mfu_free(&sortfields);
     mfu_free(&outputname);
     mfu_free(&inputname);
+    mfu_free(&prevname);
+    mfu_free(&ckptname);
+    mfu_free(&resumename);
 
     /* free the path parameters */
     mfu_param_path_free_all(numpaths, paths);
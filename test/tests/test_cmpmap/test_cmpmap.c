@@ -0,0 +1,234 @@
+/* Checks the comparison map used by dcmp and dsync: lookups of every
+ * key, misses, keys that appear more than once in a list, ordered
+ * iteration, and packed states of all fields.
+ *
+ * Build against the mfu library and run on a single process:
+ *   mpicc -I<src>/src/common test_cmpmap.c -L<lib> -lmfu -o test_cmpmap
+ *   mpirun -np 1 ./test_cmpmap */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpi.h"
+#include "mfu.h"
+#include "mfu_cmpmap.h"
+
+#define PREFIX "/base"
+
+/* number of items in the large map, enough to wrap around
+ * the table many times while probing */
+#define NUM_ITEMS (100000)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (! (cond)) { \
+            printf("FAIL line %d: ", __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+/* append an item with the given name to list */
+static void add_item(mfu_flist list, const char* name)
+{
+    uint64_t idx = mfu_flist_file_create(list);
+    mfu_flist_file_set_name(list, idx, name);
+}
+
+/* check that an empty list gives an empty map */
+static void test_empty(void)
+{
+    mfu_flist list = mfu_flist_new();
+    mfu_flist_summarize(list);
+
+    mfu_cmpmap* map = mfu_cmpmap_new(list, strlen(PREFIX));
+    CHECK(mfu_cmpmap_size(map) == 0, "empty map has %llu items",
+        (unsigned long long) mfu_cmpmap_size(map));
+
+    uint64_t idx;
+    CHECK(mfu_cmpmap_lookup(map, "/a", &idx) != 0, "found key in empty map");
+
+    uint64_t count;
+    uint64_t* sorted = mfu_cmpmap_sorted(map, &count);
+    CHECK(count == 0, "sorted empty map has %llu items", (unsigned long long) count);
+    mfu_free(&sorted);
+
+    mfu_cmpmap_delete(&map);
+    CHECK(map == NULL, "map not set to NULL after delete");
+    mfu_flist_free(&list);
+}
+
+/* check lookups and misses in a map with many keys */
+static void test_lookup(void)
+{
+    mfu_flist list = mfu_flist_new();
+
+    char name[64];
+    uint64_t i;
+    for (i = 0; i < NUM_ITEMS; i++) {
+        snprintf(name, sizeof(name), PREFIX "/dir%llu/file%llu",
+            (unsigned long long) (i % 97), (unsigned long long) i);
+        add_item(list, name);
+    }
+    mfu_flist_summarize(list);
+
+    mfu_cmpmap* map = mfu_cmpmap_new(list, strlen(PREFIX));
+    CHECK(mfu_cmpmap_size(map) == NUM_ITEMS, "map has %llu items",
+        (unsigned long long) mfu_cmpmap_size(map));
+
+    /* every key maps to its own item, and keys skip the prefix */
+    for (i = 0; i < NUM_ITEMS; i++) {
+        const char* key = mfu_cmpmap_key(map, i);
+        snprintf(name, sizeof(name), "/dir%llu/file%llu",
+            (unsigned long long) (i % 97), (unsigned long long) i);
+        CHECK(strcmp(key, name) == 0, "key %s, expected %s", key, name);
+
+        uint64_t idx;
+        int rc = mfu_cmpmap_lookup(map, name, &idx);
+        CHECK(rc == 0 && idx == i, "lookup of %s rc=%d idx=%llu",
+            name, rc, (unsigned long long) idx);
+    }
+
+    /* keys that are not in the map, including ones that share
+     * a prefix with or extend keys in the map */
+    const char* missing[] = {
+        "",
+        "/",
+        "/dir0",
+        "/dir0/file",
+        "/dir0/file00",
+        "/dir0/file0/",
+        "/dir97/file0",
+        PREFIX "/dir0/file0",
+    };
+    for (i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+        uint64_t idx;
+        CHECK(mfu_cmpmap_lookup(map, missing[i], &idx) != 0,
+            "found missing key '%s'", missing[i]);
+    }
+    for (i = NUM_ITEMS; i < 2 * NUM_ITEMS; i++) {
+        uint64_t idx;
+        snprintf(name, sizeof(name), "/dir%llu/file%llu",
+            (unsigned long long) (i % 97), (unsigned long long) i);
+        CHECK(mfu_cmpmap_lookup(map, name, &idx) != 0, "found missing key '%s'", name);
+    }
+
+    mfu_cmpmap_delete(&map);
+    mfu_flist_free(&list);
+}
+
+/* check that the last of several items with the same key wins,
+ * and that sorted iteration lists each key once in order */
+static void test_duplicates(void)
+{
+    mfu_flist list = mfu_flist_new();
+    add_item(list, PREFIX "/c");
+    add_item(list, PREFIX "/a");
+    add_item(list, PREFIX "/b/x");
+    add_item(list, PREFIX "/a");
+    add_item(list, PREFIX "/b");
+    add_item(list, PREFIX "/c");
+    add_item(list, PREFIX "/a");
+    mfu_flist_summarize(list);
+
+    mfu_cmpmap* map = mfu_cmpmap_new(list, strlen(PREFIX));
+    CHECK(mfu_cmpmap_size(map) == 7, "map has %llu items",
+        (unsigned long long) mfu_cmpmap_size(map));
+
+    uint64_t idx;
+    CHECK(mfu_cmpmap_lookup(map, "/a", &idx) == 0 && idx == 6,
+        "/a maps to %llu, expected 6", (unsigned long long) idx);
+    CHECK(mfu_cmpmap_lookup(map, "/c", &idx) == 0 && idx == 5,
+        "/c maps to %llu, expected 5", (unsigned long long) idx);
+    CHECK(mfu_cmpmap_lookup(map, "/b", &idx) == 0 && idx == 4,
+        "/b maps to %llu, expected 4", (unsigned long long) idx);
+
+    const uint64_t expected[] = {6, 4, 2, 5};
+    uint64_t count;
+    uint64_t* sorted = mfu_cmpmap_sorted(map, &count);
+    CHECK(count == 4, "sorted map has %llu items, expected 4", (unsigned long long) count);
+    for (idx = 0; idx < count && idx < 4; idx++) {
+        CHECK(sorted[idx] == expected[idx], "sorted item %llu is %llu, expected %llu",
+            (unsigned long long) idx, (unsigned long long) sorted[idx],
+            (unsigned long long) expected[idx]);
+    }
+    mfu_free(&sorted);
+
+    mfu_cmpmap_delete(&map);
+    mfu_flist_free(&list);
+}
+
+/* check that states of each field are kept apart */
+static void test_states(void)
+{
+    mfu_flist list = mfu_flist_new();
+    add_item(list, PREFIX "/a");
+    add_item(list, PREFIX "/b");
+    mfu_flist_summarize(list);
+
+    mfu_cmpmap* map = mfu_cmpmap_new(list, strlen(PREFIX));
+
+    int field;
+    for (field = 0; field < MFU_CMPMAP_FIELDS; field++) {
+        CHECK(mfu_cmpmap_get_state(map, 0, field) == 0,
+            "field %d does not start in state 0", field);
+    }
+
+    /* set each field to a different state */
+    for (field = 0; field < MFU_CMPMAP_FIELDS; field++) {
+        int state = (field * 7 + 3) % (MFU_CMPMAP_STATE_MAX + 1);
+        mfu_cmpmap_set_state(map, 0, field, state);
+    }
+    mfu_cmpmap_set_state(map, 1, MFU_CMPMAP_FIELDS - 1, MFU_CMPMAP_STATE_MAX);
+
+    for (field = 0; field < MFU_CMPMAP_FIELDS; field++) {
+        int state = (field * 7 + 3) % (MFU_CMPMAP_STATE_MAX + 1);
+        int got = mfu_cmpmap_get_state(map, 0, field);
+        CHECK(got == state, "field %d in state %d, expected %d", field, got, state);
+    }
+
+    /* overwrite a field with a smaller state */
+    mfu_cmpmap_set_state(map, 0, 3, 1);
+    CHECK(mfu_cmpmap_get_state(map, 0, 3) == 1, "field 3 not overwritten");
+    CHECK(mfu_cmpmap_get_state(map, 0, 2) == (2 * 7 + 3) % (MFU_CMPMAP_STATE_MAX + 1),
+        "field 2 changed by writing field 3");
+    CHECK(mfu_cmpmap_get_state(map, 0, 4) == (4 * 7 + 3) % (MFU_CMPMAP_STATE_MAX + 1),
+        "field 4 changed by writing field 3");
+
+    /* other items are not affected */
+    for (field = 0; field < MFU_CMPMAP_FIELDS - 1; field++) {
+        CHECK(mfu_cmpmap_get_state(map, 1, field) == 0,
+            "field %d of second item changed", field);
+    }
+    CHECK(mfu_cmpmap_get_state(map, 1, MFU_CMPMAP_FIELDS - 1) == MFU_CMPMAP_STATE_MAX,
+        "last field of second item not set");
+
+    mfu_cmpmap_delete(&map);
+    mfu_flist_free(&list);
+}
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+    mfu_init();
+
+    test_empty();
+    test_lookup();
+    test_duplicates();
+    test_states();
+
+    if (failures == 0) {
+        printf("PASS\n");
+    } else {
+        printf("FAILED %d checks\n", failures);
+    }
+
+    mfu_finalize();
+    MPI_Finalize();
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check the comparison map used by dcmp and dsync.
+#
+#   Builds test_cmpmap.c against the mfu library and runs it on a single
+#   process.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+MFU_MPICC_BIN=${MFU_MPICC_BIN:-${1}}
+MFU_MPIRUN_BIN=${MFU_MPIRUN_BIN:-${2}}
+MFU_SRC_DIR=${MFU_SRC_DIR:-${3}}
+MFU_LIB_DIR=${MFU_LIB_DIR:-${4}}
+
+echo "Using mpicc binary at: $MFU_MPICC_BIN"
+echo "Using mpirun binary at: $MFU_MPIRUN_BIN"
+echo "Using mpiFileUtils source at: $MFU_SRC_DIR"
+echo "Using mfu library at: $MFU_LIB_DIR"
+
+TEST_CMPMAP=`dirname $0`/test_cmpmap
+
+$MFU_MPICC_BIN -I$MFU_SRC_DIR/src/common `dirname $0`/test_cmpmap.c \
+	-L$MFU_LIB_DIR -Wl,-rpath,$MFU_LIB_DIR -lmfu -o $TEST_CMPMAP
+if [[ $? -ne 0 ]]; then
+	echo "Failed to build `dirname $0`/test_cmpmap.c"
+	exit 1
+fi
+
+$MFU_MPIRUN_BIN -np 1 $TEST_CMPMAP
+if [[ $? -ne 0 ]]; then
+	echo "Comparison map test failed"
+	rm -f $TEST_CMPMAP
+	exit 1
+fi
+
+rm -f $TEST_CMPMAP
+
+exit 0
@@ -0,0 +1,112 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that dfind --maxdepth and --prune limit the walk
+#   the same way as find -maxdepth and -prune.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+MFU_DFIND_BIN=${MFU_DFIND_BIN:-${1}}
+MFU_MPIRUN_BIN=${MFU_MPIRUN_BIN:-${2}}
+MFU_TEST_DIR=${MFU_TEST_DIR:-${3}}
+
+echo "Using dfind binary at: $MFU_DFIND_BIN"
+echo "Using mpirun binary at: $MFU_MPIRUN_BIN"
+echo "Using test directory at: $MFU_TEST_DIR"
+
+# dfind lists absolute paths
+MFU_TEST_DIR=$(cd $MFU_TEST_DIR && pwd)
+SRC_DIR=$MFU_TEST_DIR/src
+LIST_DIR=$MFU_TEST_DIR/lists
+
+rm -rf $SRC_DIR $LIST_DIR
+mkdir -p $SRC_DIR $LIST_DIR
+
+# Create a tree several levels deep, with directories named skip
+# at different depths.
+for a in 1 2 3; do
+	for b in 1 2 3; do
+		mkdir -p $SRC_DIR/a_$a/b_$b/c/d
+		touch $SRC_DIR/a_$a/file_$b $SRC_DIR/a_$a/b_$b/file $SRC_DIR/a_$a/b_$b/c/d/file
+	done
+	mkdir -p $SRC_DIR/a_$a/skip/inner $SRC_DIR/a_$a/b_1/skip/inner
+	touch $SRC_DIR/a_$a/skip/file $SRC_DIR/a_$a/skip/inner/file $SRC_DIR/a_$a/b_1/skip/file
+done
+mkdir -p $SRC_DIR/skip
+touch $SRC_DIR/skip/file $SRC_DIR/top_file
+
+# Names of items dfind selects, sorted.
+function run_dfind {
+	local out=$1
+	shift
+	rm -f $out.unsorted
+	$MFU_MPIRUN_BIN -np 3 $MFU_DFIND_BIN -q -o $out.unsorted -t "$@" $SRC_DIR
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: $MFU_MPIRUN_BIN -np 3 $MFU_DFIND_BIN -q -o $out.unsorted -t $@ $SRC_DIR"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+	touch $out.unsorted
+	awk '{print $NF}' $out.unsorted | sort > $out
+	rm -f $out.unsorted
+}
+
+# Compare items dfind selects with the items find prints.
+function check_find {
+	local message=$1
+
+	diff $LIST_DIR/expect.txt $LIST_DIR/got.txt
+	if [[ $? -ne 0 ]]; then
+		echo "dfind differs from find: $message"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+}
+
+echo "Subtest 1, maxdepth 0."
+find $SRC_DIR -maxdepth 0 | sort > $LIST_DIR/expect.txt
+run_dfind $LIST_DIR/got.txt --maxdepth 0
+check_find "--maxdepth 0"
+
+echo "Subtest 2, maxdepth 2."
+find $SRC_DIR -maxdepth 2 | sort > $LIST_DIR/expect.txt
+run_dfind $LIST_DIR/got.txt --maxdepth 2
+check_find "--maxdepth 2"
+
+echo "Subtest 3, prune directories by name."
+find $SRC_DIR -name skip -prune -print -o -print | sort > $LIST_DIR/expect.txt
+run_dfind $LIST_DIR/got.txt --name skip --prune
+check_find "--name skip --prune"
+
+echo "Subtest 4, prune directories by name and select files."
+find $SRC_DIR -name skip -prune -o -type f -print | sort > $LIST_DIR/expect.txt
+run_dfind $LIST_DIR/got.txt --name skip --prune --type f
+check_find "--name skip --prune --type f"
+
+echo "Subtest 5, prune and limit depth."
+find $SRC_DIR -maxdepth 3 -name skip -prune -print -o -print | sort > $LIST_DIR/expect.txt
+run_dfind $LIST_DIR/got.txt --maxdepth 3 --name skip --prune
+check_find "--maxdepth 3 --name skip --prune"
+
+echo "Subtest 6, maxdepth and prune are rejected with an input list."
+$MFU_MPIRUN_BIN -np 3 $MFU_DFIND_BIN -q -o $LIST_DIR/list $SRC_DIR
+if [[ $? -ne 0 ]]; then
+	echo "Failed to run cmd: $MFU_MPIRUN_BIN -np 3 $MFU_DFIND_BIN -q -o $LIST_DIR/list $SRC_DIR"
+	rm -rf $SRC_DIR $LIST_DIR
+	exit 1
+fi
+$MFU_MPIRUN_BIN -np 3 $MFU_DFIND_BIN -q -i $LIST_DIR/list --maxdepth 1 -o $LIST_DIR/got.txt -t
+if [[ $? -eq 0 ]]; then
+	echo "dfind accepted --maxdepth with --input"
+	rm -rf $SRC_DIR $LIST_DIR
+	exit 1
+fi
+
+rm -rf $SRC_DIR $LIST_DIR
+
+exit 0
@@ -0,0 +1,175 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that lists written in each cache format read back
+#   the same.
+#
+#   Walks a directory tree once and saves the list in version 4 format.
+#   That list is then written in each other format, read back, and
+#   written as text, which must match the text of the version 4 list.
+#   dfind must select the same items from a version 6 list, which skips
+#   blocks using their zone maps, as from the version 4 list.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+MFU_DWALK_BIN=${MFU_DWALK_BIN:-${1}}
+MFU_MPIRUN_BIN=${MFU_MPIRUN_BIN:-${2}}
+MFU_TEST_DIR=${MFU_TEST_DIR:-${3}}
+MFU_DFIND_BIN=${MFU_DFIND_BIN:-${4}}
+
+echo "Using dwalk binary at: $MFU_DWALK_BIN"
+echo "Using mpirun binary at: $MFU_MPIRUN_BIN"
+echo "Using test directory at: $MFU_TEST_DIR"
+echo "Using dfind binary at: $MFU_DFIND_BIN"
+
+SRC_DIR=$MFU_TEST_DIR/src
+LIST_DIR=$MFU_TEST_DIR/lists
+
+rm -rf $SRC_DIR $LIST_DIR
+mkdir -p $SRC_DIR $LIST_DIR
+
+# Create a tree with enough items for several blocks per process,
+# files of each directory have similar sizes.
+for d in small medium large; do
+	mkdir -p $SRC_DIR/$d
+done
+for i in $(seq 1 3000); do
+	truncate -s $((i % 100)) $SRC_DIR/small/file_$i
+	truncate -s $((100000 + i)) $SRC_DIR/medium/file_$i
+	truncate -s $((10000000 + i)) $SRC_DIR/large/file_$i
+done
+mkdir -p $SRC_DIR/deep/a/b/c/d/e
+ln -s ../small/file_1 $SRC_DIR/deep/link
+touch $SRC_DIR/deep/a/b/c/d/e/"name with spaces"
+
+function run_dwalk {
+	$MFU_MPIRUN_BIN -np 3 $MFU_DWALK_BIN -q "$@"
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: $MFU_MPIRUN_BIN -np 3 $MFU_DWALK_BIN -q $@"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+}
+
+# Write list as text, sorted by name so the order of processes doesn't matter.
+function list_to_text {
+	run_dwalk -i $1 -o $2.unsorted -t
+	sort $2.unsorted > $2
+	rm -f $2.unsorted
+}
+
+# Walk once, all other lists are converted from this one.
+MFU_FLIST_CACHE_VERSION=4 run_dwalk -o $LIST_DIR/list.v4 $SRC_DIR
+list_to_text $LIST_DIR/list.v4 $LIST_DIR/list.v4.txt
+
+if [[ $(wc -l < $LIST_DIR/list.v4.txt) -lt 9000 ]]; then
+	echo "Version 4 list is missing items"
+	rm -rf $SRC_DIR $LIST_DIR
+	exit 1
+fi
+
+# Return version number stored in the first 8 bytes of a list.
+function list_version {
+	echo $((16#$(od -An -tx1 -N8 $1 | tr -d ' \n')))
+}
+
+# Version 4 is written by default.
+unset MFU_FLIST_CACHE_VERSION
+run_dwalk -i $LIST_DIR/list.v4 -o $LIST_DIR/list.default
+if [[ $(list_version $LIST_DIR/list.default) -ne 4 ]]; then
+	echo "Default format is not version 4"
+	rm -rf $SRC_DIR $LIST_DIR
+	exit 1
+fi
+
+function test_format {
+	local version=$1
+	local compress=$2
+	local list=$LIST_DIR/list.v$version.$compress
+
+	MFU_FLIST_CACHE_VERSION=$version MFU_FLIST_CACHE_COMPRESS=$compress \
+		run_dwalk -i $LIST_DIR/list.v4 -o $list
+	if [[ $(list_version $list) -ne $version ]]; then
+		echo "List is not version $version: $list"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+	list_to_text $list $list.txt
+
+	diff $LIST_DIR/list.v4.txt $list.txt
+	if [[ $? -ne 0 ]]; then
+		echo "List mismatch: version $version compress $compress"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+
+	# Read back with more processes than wrote the list.
+	$MFU_MPIRUN_BIN -np 5 $MFU_DWALK_BIN -q -i $list -o $list.np5.txt -t
+	sort $list.np5.txt | diff $LIST_DIR/list.v4.txt -
+	if [[ $? -ne 0 ]]; then
+		echo "List mismatch with 5 processes: version $version compress $compress"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+}
+
+echo "Subtest 1, version 5."
+test_format 5 NONE
+
+echo "Subtest 2, version 5 with bzip2."
+test_format 5 BZ2
+
+echo "Subtest 3, version 6."
+test_format 6 NONE
+
+echo "Subtest 4, version 6 with bzip2."
+test_format 6 BZ2
+
+# Items dfind selects from a list, sorted by name.
+function find_in_list {
+	local list=$1
+	local out=$2
+	shift 2
+
+	rm -f $out.unsorted
+	$MFU_MPIRUN_BIN -np 3 $MFU_DFIND_BIN -q -i $list -o $out.unsorted -t "$@"
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: $MFU_MPIRUN_BIN -np 3 $MFU_DFIND_BIN -q -i $list -o $out.unsorted -t $@"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+	touch $out.unsorted
+	sort $out.unsorted > $out
+	rm -f $out.unsorted
+}
+
+function test_find {
+	find_in_list $LIST_DIR/list.v4 $LIST_DIR/find.v4.txt "$@"
+	find_in_list $LIST_DIR/list.v6.NONE $LIST_DIR/find.v6.txt "$@"
+	find_in_list $LIST_DIR/list.v6.BZ2 $LIST_DIR/find.v6bz2.txt "$@"
+
+	diff $LIST_DIR/find.v4.txt $LIST_DIR/find.v6.txt && \
+		diff $LIST_DIR/find.v4.txt $LIST_DIR/find.v6bz2.txt
+	if [[ $? -ne 0 ]]; then
+		echo "dfind mismatch between version 4 and version 6 lists: $@"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+}
+
+echo "Subtest 5, dfind on version 6 lists."
+test_find --size -50
+test_find --size +10MB
+test_find --size +100000 --size -100100
+test_find --size +1GB
+test_find --type f --name "file_1*"
+test_find --uid $(id -u)
+
+rm -rf $SRC_DIR $LIST_DIR
+
+exit 0
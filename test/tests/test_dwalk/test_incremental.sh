@@ -0,0 +1,143 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that an incremental walk, which reuses entries of
+#   unchanged directories from a previous list, gives the same list as
+#   a full walk.
+#
+#   Walks a tree once, then adds, removes, and renames entries at
+#   several depths and changes the size of a file without touching its
+#   directory.  Lists from dwalk --incremental and dfind --incremental
+#   must then match a full walk, including the stat fields written in
+#   text lists.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+MFU_DWALK_BIN=${MFU_DWALK_BIN:-${1}}
+MFU_MPIRUN_BIN=${MFU_MPIRUN_BIN:-${2}}
+MFU_TEST_DIR=${MFU_TEST_DIR:-${3}}
+MFU_DFIND_BIN=${MFU_DFIND_BIN:-${4}}
+
+echo "Using dwalk binary at: $MFU_DWALK_BIN"
+echo "Using mpirun binary at: $MFU_MPIRUN_BIN"
+echo "Using test directory at: $MFU_TEST_DIR"
+echo "Using dfind binary at: $MFU_DFIND_BIN"
+
+SRC_DIR=$MFU_TEST_DIR/src
+LIST_DIR=$MFU_TEST_DIR/lists
+
+rm -rf $SRC_DIR $LIST_DIR
+mkdir -p $SRC_DIR $LIST_DIR
+
+# Create a tree with files at each level.
+for a in 1 2 3; do
+	for b in 1 2 3; do
+		mkdir -p $SRC_DIR/a_$a/b_$b/c
+		for i in 1 2 3; do
+			truncate -s $((a * 100 + b * 10 + i)) $SRC_DIR/a_$a/b_$b/c/file_$i
+			truncate -s $i $SRC_DIR/a_$a/b_$b/file_$i
+		done
+		touch $SRC_DIR/a_$a/file_$b
+	done
+done
+touch $SRC_DIR/top_file
+
+function fail {
+	echo "$@"
+	rm -rf $SRC_DIR $LIST_DIR
+	exit 1
+}
+
+# Run a tool, writing its list as text sorted by name to $out.
+function run_text {
+	local np=$1
+	local bin=$2
+	local out=$3
+	shift 3
+
+	rm -f $out.unsorted
+	$MFU_MPIRUN_BIN -np $np $bin -q -o $out.unsorted -t "$@"
+	if [[ $? -ne 0 ]]; then
+		fail "Failed to run cmd: $MFU_MPIRUN_BIN -np $np $bin -q -o $out.unsorted -t $@"
+	fi
+	sort $out.unsorted > $out
+	rm -f $out.unsorted
+}
+
+# Compare a list from an incremental walk with a full walk.
+function check_same {
+	diff $LIST_DIR/expect.txt $1
+	if [[ $? -ne 0 ]]; then
+		fail "$2"
+	fi
+}
+
+# Save the list of a full walk to use as the previous list.
+$MFU_MPIRUN_BIN -np 3 $MFU_DWALK_BIN -q -o $LIST_DIR/prev $SRC_DIR
+if [[ $? -ne 0 ]]; then
+	fail "Failed to walk $SRC_DIR"
+fi
+
+# Directory times are compared to the previous list, so make sure
+# changes get a different time even on coarse grained file systems.
+sleep 1
+
+# Add entries at several depths.
+touch $SRC_DIR/new_top
+touch $SRC_DIR/a_1/b_1/c/new_file
+mkdir -p $SRC_DIR/a_2/new_dir/sub
+touch $SRC_DIR/a_2/new_dir/sub/file
+
+# Remove a file and a subtree.
+rm -f $SRC_DIR/a_1/file_2
+rm -rf $SRC_DIR/a_3/b_2
+
+# Rename a file, and move a directory to another parent,
+# which leaves the times of the moved directory unchanged.
+mv $SRC_DIR/a_2/b_1/file_1 $SRC_DIR/a_2/b_1/renamed
+mv $SRC_DIR/a_1/b_3 $SRC_DIR/a_2/moved_b_3
+
+# Change files without touching their directories.
+truncate -s 12345 $SRC_DIR/a_3/b_1/c/file_1
+chmod 600 $SRC_DIR/a_3/b_3/file_2
+touch -d "2001-02-03 04:05" $SRC_DIR/a_1/b_2/c/file_3
+
+run_text 3 $MFU_DWALK_BIN $LIST_DIR/expect.txt $SRC_DIR
+
+echo "Subtest 1, dwalk --incremental."
+run_text 3 $MFU_DWALK_BIN $LIST_DIR/got.txt --incremental $LIST_DIR/prev $SRC_DIR
+check_same $LIST_DIR/got.txt "dwalk --incremental differs from full walk"
+
+echo "Subtest 2, dwalk --incremental with a different number of processes."
+run_text 4 $MFU_DWALK_BIN $LIST_DIR/got.txt --incremental $LIST_DIR/prev $SRC_DIR
+check_same $LIST_DIR/got.txt "dwalk --incremental with 4 processes differs from full walk"
+
+echo "Subtest 3, dfind --incremental."
+run_text 3 $MFU_DFIND_BIN $LIST_DIR/got.txt --incremental $LIST_DIR/prev $SRC_DIR
+check_same $LIST_DIR/got.txt "dfind --incremental differs from full walk"
+
+run_text 3 $MFU_DFIND_BIN $LIST_DIR/expect.txt --type f --size +100 $SRC_DIR
+run_text 3 $MFU_DFIND_BIN $LIST_DIR/got.txt --incremental $LIST_DIR/prev --type f --size +100 $SRC_DIR
+check_same $LIST_DIR/got.txt "dfind --incremental with tests differs from full walk"
+
+echo "Subtest 4, incremental walk from an incremental list."
+$MFU_MPIRUN_BIN -np 3 $MFU_DWALK_BIN -q --incremental $LIST_DIR/prev -o $LIST_DIR/prev2 $SRC_DIR
+if [[ $? -ne 0 ]]; then
+	fail "Failed to walk $SRC_DIR incrementally"
+fi
+sleep 1
+rm -rf $SRC_DIR/a_2/new_dir
+touch $SRC_DIR/a_2/moved_b_3/c/another
+truncate -s 54321 $SRC_DIR/a_2/moved_b_3/file_1
+run_text 3 $MFU_DWALK_BIN $LIST_DIR/expect.txt $SRC_DIR
+run_text 2 $MFU_DWALK_BIN $LIST_DIR/got.txt --incremental $LIST_DIR/prev2 $SRC_DIR
+check_same $LIST_DIR/got.txt "dwalk --incremental from an incremental list differs from full walk"
+
+rm -rf $SRC_DIR $LIST_DIR
+
+exit 0
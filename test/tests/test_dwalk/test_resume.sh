@@ -0,0 +1,110 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that a walk resumed from checkpoint files finds the
+#   same items as a full walk, even if the part files end in a partial
+#   record.
+#
+#   An incremental walk writes all items it reuses from a previous list
+#   to its checkpoint files when it starts, which gives checkpoint files
+#   holding most of the tree without having to interrupt a walk.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+MFU_DWALK_BIN=${MFU_DWALK_BIN:-${1}}
+MFU_MPIRUN_BIN=${MFU_MPIRUN_BIN:-${2}}
+MFU_TEST_DIR=${MFU_TEST_DIR:-${3}}
+
+echo "Using dwalk binary at: $MFU_DWALK_BIN"
+echo "Using mpirun binary at: $MFU_MPIRUN_BIN"
+echo "Using test directory at: $MFU_TEST_DIR"
+
+SRC_DIR=$MFU_TEST_DIR/src
+LIST_DIR=$MFU_TEST_DIR/lists
+CKPT=$LIST_DIR/ckpt
+
+rm -rf $SRC_DIR $LIST_DIR
+mkdir -p $SRC_DIR $LIST_DIR
+
+# Create a tree with files at several levels.
+for d in $(seq 1 20); do
+	mkdir -p $SRC_DIR/dir_$d/sub_$d
+	for i in $(seq 1 100); do
+		truncate -s $i $SRC_DIR/dir_$d/file_$i
+		truncate -s $((d * i)) $SRC_DIR/dir_$d/sub_$d/file_$i
+	done
+done
+
+function run_dwalk {
+	local np=$1
+	shift
+	$MFU_MPIRUN_BIN -np $np $MFU_DWALK_BIN -q "$@"
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: $MFU_MPIRUN_BIN -np $np $MFU_DWALK_BIN -q $@"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+}
+
+function check_same {
+	diff $1 $2
+	if [[ $? -ne 0 ]]; then
+		echo "$3"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+}
+
+# Write checkpoint files holding the items of the full walk.
+function write_checkpoint {
+	rm -f $CKPT.*
+	run_dwalk 3 -o $LIST_DIR/full $SRC_DIR
+	run_dwalk 3 --incremental $LIST_DIR/full --checkpoint $CKPT -o $LIST_DIR/incr $SRC_DIR
+	for i in 0 1 2; do
+		if [[ $(stat -c %s $CKPT.$i) -le 8 ]]; then
+			echo "Checkpoint file holds no records: $CKPT.$i"
+			rm -rf $SRC_DIR $LIST_DIR
+			exit 1
+		fi
+	done
+}
+
+echo "Subtest 1, resume from complete checkpoint files."
+write_checkpoint
+run_dwalk 3 -i $LIST_DIR/full -o $LIST_DIR/full.txt -t
+sort $LIST_DIR/full.txt > $LIST_DIR/expect.txt
+run_dwalk 3 --resume $CKPT -o $LIST_DIR/resume.txt -t $SRC_DIR
+sort $LIST_DIR/resume.txt > $LIST_DIR/got.txt
+check_same $LIST_DIR/expect.txt $LIST_DIR/got.txt "Resumed walk differs from full walk"
+
+echo "Subtest 2, resume from part files ending in a partial record."
+# A record length followed by fewer bytes than it claims,
+# and a part file cut off in the middle of its last record.
+printf '\0\0\0\0\0\0\1\0partial' >> $CKPT.0
+truncate -s -5 $CKPT.1
+run_dwalk 2 --resume $CKPT -o $LIST_DIR/resume.txt -t $SRC_DIR
+sort $LIST_DIR/resume.txt > $LIST_DIR/got.txt
+check_same $LIST_DIR/expect.txt $LIST_DIR/got.txt "Resumed walk differs from full walk with partial records"
+
+echo "Subtest 3, resume after items were added."
+write_checkpoint
+for i in $(seq 101 150); do
+	truncate -s $i $SRC_DIR/dir_1/file_$i
+done
+mkdir -p $SRC_DIR/dir_new/sub
+touch $SRC_DIR/dir_new/sub/file_1 $SRC_DIR/dir_2/sub_2/file_new
+# Resumed items keep their recorded stat info, so only compare names.
+run_dwalk 3 -o $LIST_DIR/full.txt -t $SRC_DIR
+awk '{print $NF}' $LIST_DIR/full.txt | sort > $LIST_DIR/expect.txt
+run_dwalk 4 --resume $CKPT -o $LIST_DIR/resume.txt -t $SRC_DIR
+awk '{print $NF}' $LIST_DIR/resume.txt | sort > $LIST_DIR/got.txt
+check_same $LIST_DIR/expect.txt $LIST_DIR/got.txt "Resumed walk missed items added after checkpoint"
+
+rm -rf $SRC_DIR $LIST_DIR
+
+exit 0
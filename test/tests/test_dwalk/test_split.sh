@@ -0,0 +1,92 @@
+#!/bin/bash
+
+##############################################################################
+# Description:
+#
+#   A test to check that walks which share the entries of large
+#   directories among processes find each item exactly once.
+#
+#   Walks the same tree with directory splitting disabled and with
+#   directories split after a few entries, with and without threads,
+#   and compares the lists.
+#
+##############################################################################
+
+# Turn on verbose output
+#set -x
+
+MFU_DWALK_BIN=${MFU_DWALK_BIN:-${1}}
+MFU_MPIRUN_BIN=${MFU_MPIRUN_BIN:-${2}}
+MFU_TEST_DIR=${MFU_TEST_DIR:-${3}}
+
+echo "Using dwalk binary at: $MFU_DWALK_BIN"
+echo "Using mpirun binary at: $MFU_MPIRUN_BIN"
+echo "Using test directory at: $MFU_TEST_DIR"
+
+SRC_DIR=$MFU_TEST_DIR/src
+LIST_DIR=$MFU_TEST_DIR/lists
+
+rm -rf $SRC_DIR $LIST_DIR
+mkdir -p $SRC_DIR $LIST_DIR
+
+# One large directory holding files and subdirectories,
+# and a few small ones.
+mkdir -p $SRC_DIR/large
+for i in $(seq 1 3000); do
+	truncate -s $i $SRC_DIR/large/file_$i
+done
+for i in $(seq 1 50); do
+	mkdir -p $SRC_DIR/large/dir_$i
+	touch $SRC_DIR/large/dir_$i/file
+done
+for d in $(seq 1 5); do
+	mkdir -p $SRC_DIR/small_$d
+	touch $SRC_DIR/small_$d/file
+done
+
+function walk_to_text {
+	local out=$1
+	shift
+	$MFU_MPIRUN_BIN -np 4 $MFU_DWALK_BIN -q -o $out.unsorted -t "$@" $SRC_DIR
+	if [[ $? -ne 0 ]]; then
+		echo "Failed to run cmd: $MFU_MPIRUN_BIN -np 4 $MFU_DWALK_BIN -q -o $out.unsorted -t $@ $SRC_DIR"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+	sort $out.unsorted > $out
+	rm -f $out.unsorted
+}
+
+function test_split {
+	local split=$1
+	local threads=$2
+	shift 2
+
+	MFU_FLIST_WALK_SPLIT=0 MFU_FLIST_WALK_THREADS=1 \
+		walk_to_text $LIST_DIR/expect.txt "$@"
+	MFU_FLIST_WALK_SPLIT=$split MFU_FLIST_WALK_THREADS=$threads \
+		walk_to_text $LIST_DIR/got.txt "$@"
+
+	diff $LIST_DIR/expect.txt $LIST_DIR/got.txt
+	if [[ $? -ne 0 ]]; then
+		echo "List mismatch: split $split threads $threads $@"
+		rm -rf $SRC_DIR $LIST_DIR
+		exit 1
+	fi
+}
+
+echo "Subtest 1, split every 7 entries."
+test_split 7 1
+
+echo "Subtest 2, split every 7 entries with threads."
+test_split 7 4
+
+echo "Subtest 3, split every entry without stat."
+test_split 1 1 --lite
+
+echo "Subtest 4, split with more entries than the directory holds."
+test_split 10000 1
+
+rm -rf $SRC_DIR $LIST_DIR
+
+exit 0